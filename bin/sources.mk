@@ -28,6 +28,7 @@ src/NFutil \
 src/NFutil/MTrand \
 src/NFtest/transcription \
 src/NFtest/tlbr \
+src/NFtest/microbench \
 src/NFtest/simple_system \
 src/NFtest/agentcell/cell \
 src/NFtest/agentcell \
@@ -46,4 +47,5 @@ src/NFfunction \
 src/NFcore \
 src/NFcore/reactionSelector \
 src/NFcore/moleculeLists \
+src/NFapi \
 
@@ -0,0 +1,27 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../src/NFapi/NFapi.cpp \
+../src/NFapi/NFserver.cpp 
+
+OBJS += \
+./src/NFapi/NFapi.o \
+./src/NFapi/NFserver.o 
+
+CPP_DEPS += \
+./src/NFapi/NFapi.d \
+./src/NFapi/NFserver.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+src/NFapi/%.o: ../src/NFapi/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C++ Compiler'
+	g++ -O3 -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
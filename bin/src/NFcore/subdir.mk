@@ -9,7 +9,10 @@ CPP_SRCS += \
 ../src/NFcore/molecule.cpp \
 ../src/NFcore/moleculeType.cpp \
 ../src/NFcore/observable.cpp \
+../src/NFcore/optimisticEngine.cpp \
+../src/NFcore/profiler.cpp \
 ../src/NFcore/reactionClass.cpp \
+../src/NFcore/subvolumeEngine.cpp \
 ../src/NFcore/system.cpp \
 ../src/NFcore/templateMolecule.cpp 
 
@@ -19,7 +22,10 @@ OBJS += \
 ./src/NFcore/molecule.o \
 ./src/NFcore/moleculeType.o \
 ./src/NFcore/observable.o \
+./src/NFcore/optimisticEngine.o \
+./src/NFcore/profiler.o \
 ./src/NFcore/reactionClass.o \
+./src/NFcore/subvolumeEngine.o \
 ./src/NFcore/system.o \
 ./src/NFcore/templateMolecule.o 
 
@@ -29,7 +35,10 @@ CPP_DEPS += \
 ./src/NFcore/molecule.d \
 ./src/NFcore/moleculeType.d \
 ./src/NFcore/observable.d \
+./src/NFcore/optimisticEngine.d \
+./src/NFcore/profiler.d \
 ./src/NFcore/reactionClass.d \
+./src/NFcore/subvolumeEngine.d \
 ./src/NFcore/system.d \
 ./src/NFcore/templateMolecule.d 
 
@@ -4,13 +4,16 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../src/NFoutput/NFoutput.cpp 
+../src/NFoutput/NFoutput.cpp \
+../src/NFoutput/ensembleStats.cpp 
 
 OBJS += \
-./src/NFoutput/NFoutput.o 
+./src/NFoutput/NFoutput.o \
+./src/NFoutput/ensembleStats.o 
 
 CPP_DEPS += \
-./src/NFoutput/NFoutput.d 
+./src/NFoutput/NFoutput.d \
+./src/NFoutput/ensembleStats.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -4,13 +4,16 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../src/NFtest/agentcell/agentcell.cpp 
+../src/NFtest/agentcell/agentcell.cpp \
+../src/NFtest/agentcell/population.cpp 
 
 OBJS += \
-./src/NFtest/agentcell/agentcell.o 
+./src/NFtest/agentcell/agentcell.o \
+./src/NFtest/agentcell/population.o 
 
 CPP_DEPS += \
-./src/NFtest/agentcell/agentcell.d 
+./src/NFtest/agentcell/agentcell.d \
+./src/NFtest/agentcell/population.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -5,16 +5,19 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 ../src/NFutil/conversion.cpp \
+../src/NFutil/parallel.cpp \
 ../src/NFutil/random.cpp \
 ../src/NFutil/stringOperations.cpp 
 
 OBJS += \
 ./src/NFutil/conversion.o \
+./src/NFutil/parallel.o \
 ./src/NFutil/random.o \
 ./src/NFutil/stringOperations.o 
 
 CPP_DEPS += \
 ./src/NFutil/conversion.d \
+./src/NFutil/parallel.d \
 ./src/NFutil/random.d \
 ./src/NFutil/stringOperations.d 
 
@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""Reproducible NFsim performance benchmark over the performance test models.
+
+Each model is run from the pre-generated XML in this folder with a fixed
+random seed and a fixed event budget (-maxevents), using the command line
+options from the README.  The results are written as a JSON report with,
+per model:
+
+    events                 number of events simulated
+    null_events            number of null events among them
+    null_event_ratio       null_events / events
+    sim_cpu_s              CPU time spent in System::sim
+    events_per_s           events / sim_cpu_s
+    cpu_s_per_nonnull      sim_cpu_s / (events - null_events)
+    startup_cpu_s          total CPU time of the process minus sim_cpu_s
+                           (parsing the XML, preparing and tearing down)
+    peak_rss_kb            maximum resident set size of the NFsim process
+    wall_s                 wall clock time of the process
+
+With --compare, the new report is checked against a stored baseline report
+and any model that got slower, or used more memory, by more than the given
+tolerance is flagged.  The exit code is 1 if a regression was found.
+
+Usage:
+    python3 benchmark.py --nfsim ../../build/NFsim -o report.json
+    python3 benchmark.py --nfsim ../../build/NFsim --compare baseline.json
+"""
+
+import argparse
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+# model name -> (extra NFsim arguments, event budget).  The simulation times
+# are long enough that every run stops on the event budget, not on time.
+MODELS = [
+    ('push_pull',        ['-oSteps', '100',  '-sim', '1000', '-notf'],              500000),
+    ('egfr_net',         ['-oSteps', '120',  '-sim', '1200', '-notf', '-utl', '2'], 200000),
+    ('poly',             ['-oSteps', '100',  '-sim', '10000', '-utl', '2'],          50000),
+    ('tlbr_performance', ['-oSteps', '3000', '-sim', '3000', '-bscb', '-cb', '-utl', '3'], 30000),
+    ('ANx_noActivity',   ['-oSteps', '1000', '-sim', '1000', '-utl', '2'],         100000),
+]
+
+SEED = 4242
+
+# metric -> +1 if larger is worse, -1 if smaller is worse
+COMPARED_METRICS = {
+    'events_per_s': -1,
+    'cpu_s_per_nonnull': +1,
+    'startup_cpu_s': +1,
+    'peak_rss_kb': +1,
+}
+
+# startup times are short, so ignore changes below this many seconds
+STARTUP_FLOOR_S = 0.05
+
+
+def default_nfsim():
+    for cand in [os.path.join(HERE, '..', '..', 'build', 'NFsim'),
+                 os.path.join(HERE, '..', '..', 'bin', 'NFsim')]:
+        if os.path.isfile(cand):
+            return os.path.normpath(cand)
+    return 'NFsim'
+
+
+def parse_output(text):
+    """Pull the event counts and timings out of the NFsim console output."""
+    res = {}
+    m = re.search(r'You just simulated (\d+) reactions in ([0-9.eE+-]+)s', text)
+    if not m:
+        raise RuntimeError('could not find the simulation summary in the NFsim output')
+    res['events'] = int(m.group(1))
+    res['sim_cpu_s'] = float(m.group(2))
+    m = re.search(r'Null events: (\d+)', text)
+    res['null_events'] = int(m.group(1)) if m else 0
+    m = re.search(r'Total CPU time: ([0-9.eE+-]+)s', text)
+    res['total_cpu_s'] = float(m.group(1)) if m else float('nan')
+    return res
+
+
+def run_once(nfsim, name, args, budget, workdir, xml=None):
+    if xml is None:
+        xml = os.path.join(HERE, name + '.xml')
+    cmd = [nfsim, '-xml', xml, '-seed', str(SEED), '-maxevents', str(budget),
+           '-o', os.path.join(workdir, name + '_nf.gdat')] + args
+    log_path = os.path.join(workdir, name + '.log')
+    with open(log_path, 'w') as log:
+        t0 = time.time()
+        p = subprocess.Popen(cmd, stdout=log, stderr=subprocess.STDOUT, cwd=workdir)
+        _, status, usage = os.wait4(p.pid, 0)
+        wall = time.time() - t0
+        p.returncode = status
+    with open(log_path) as log:
+        text = log.read()
+    if status != 0:
+        raise RuntimeError('NFsim failed on %s (status %d):\n%s' % (name, status, text[-2000:]))
+    res = parse_output(text)
+    events = res['events']
+    nonnull = events - res['null_events']
+    res['null_event_ratio'] = res['null_events'] / float(events) if events else 0.0
+    res['events_per_s'] = events / res['sim_cpu_s'] if res['sim_cpu_s'] > 0 else float('nan')
+    res['cpu_s_per_nonnull'] = res['sim_cpu_s'] / nonnull if nonnull else float('nan')
+    res['startup_cpu_s'] = max(0.0, res['total_cpu_s'] - res['sim_cpu_s'])
+    # ru_maxrss is in kilobytes on Linux and in bytes on macOS
+    rss = usage.ru_maxrss
+    if sys.platform == 'darwin':
+        rss = rss / 1024
+    res['peak_rss_kb'] = int(rss)
+    res['wall_s'] = wall
+    res['budget'] = budget
+    res['command'] = ' '.join(cmd[1:])
+    return res
+
+
+def run_suite(nfsim, names, repeat):
+    report = {
+        'nfsim': nfsim,
+        'seed': SEED,
+        'repeat': repeat,
+        'host': platform.node(),
+        'platform': platform.platform(),
+        'date': time.strftime('%Y-%m-%dT%H:%M:%S'),
+        'models': {},
+    }
+    with tempfile.TemporaryDirectory(prefix='nfsim_bench_') as workdir:
+        for name, args, budget in MODELS:
+            if names and name not in names:
+                continue
+            runs = []
+            for r in range(repeat):
+                runs.append(run_once(nfsim, name, args, budget, workdir))
+            # keep the fastest run; the event counts are identical between runs
+            best = min(runs, key=lambda x: x['sim_cpu_s'])
+            best['startup_cpu_s'] = min(x['startup_cpu_s'] for x in runs)
+            best['peak_rss_kb'] = min(x['peak_rss_kb'] for x in runs)
+            report['models'][name] = best
+            print('%-18s %9d events  %11.1f events/s  %.3e s/non-null  null %.3f  startup %.3fs  rss %d kB'
+                  % (name, best['events'], best['events_per_s'], best['cpu_s_per_nonnull'],
+                     best['null_event_ratio'], best['startup_cpu_s'], best['peak_rss_kb']))
+    return report
+
+
+def compare(report, baseline, tolerance):
+    regressions = []
+    for name, cur in report['models'].items():
+        base = baseline.get('models', {}).get(name)
+        if base is None:
+            print('%-18s not in baseline, skipped' % name)
+            continue
+        if cur['events'] != base['events'] or cur['null_events'] != base['null_events']:
+            print('%-18s WARNING: event counts differ from baseline (%d/%d vs %d/%d), '
+                  'the simulated trajectory changed' % (name, cur['events'], cur['null_events'],
+                                                        base['events'], base['null_events']))
+        for metric, sign in COMPARED_METRICS.items():
+            old, new = base.get(metric), cur.get(metric)
+            if old is None or new is None or old != old or new != new or old == 0:
+                continue
+            change = (new - old) / float(old)
+            worse = sign * change > tolerance
+            if metric == 'startup_cpu_s' and abs(new - old) < STARTUP_FLOOR_S:
+                worse = False
+            flag = 'REGRESSION' if worse else 'ok'
+            print('%-18s %-18s %12.4g -> %12.4g  (%+6.1f%%)  %s'
+                  % (name, metric, old, new, 100.0 * change, flag))
+            if worse:
+                regressions.append((name, metric, old, new))
+    report['regressions'] = [{'model': n, 'metric': m, 'baseline': o, 'current': c}
+                             for n, m, o, c in regressions]
+    return regressions
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--nfsim', default=default_nfsim(), help='path to the NFsim executable')
+    ap.add_argument('-o', '--output', default='benchmark_report.json', help='JSON report to write')
+    ap.add_argument('--compare', metavar='BASELINE', help='baseline JSON report to compare against')
+    ap.add_argument('--tolerance', type=float, default=0.10,
+                    help='relative change that counts as a regression (default 0.10)')
+    ap.add_argument('--repeat', type=int, default=3, help='runs per model, the fastest is kept')
+    ap.add_argument('--models', nargs='*', help='only run these models')
+    opts = ap.parse_args()
+
+    report = run_suite(os.path.abspath(opts.nfsim), opts.models, max(1, opts.repeat))
+    status = 0
+    if opts.compare:
+        with open(opts.compare) as f:
+            baseline = json.load(f)
+        if compare(report, baseline, opts.tolerance):
+            print('performance regressions found against %s' % opts.compare)
+            status = 1
+        else:
+            print('no performance regressions against %s' % opts.compare)
+    with open(opts.output, 'w') as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+    print('report written to %s' % opts.output)
+    return status
+
+
+if __name__ == '__main__':
+    sys.exit(main())
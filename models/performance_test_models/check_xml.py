@@ -0,0 +1,524 @@
+#!/usr/bin/env python3
+"""Checks that the XML files in this folder say the same thing as the BNGL.
+
+The XML files next to the models were written by hand from the BNGL, not by
+BioNetGen, so this script reads both and compares them:
+
+    parameters     every BNGL parameter is in the XML with the same value
+                   (expressions are evaluated), and the XML has no others
+    molecule types the same components, in order, with the same allowed
+                   states; without a molecule types block they are
+                   inferred from the species, rules and observables, as
+                   BioNetGen does
+    species        the same patterns (up to molecule and bond numbering)
+                   with the same counts, in order
+    observables    the same names, types and patterns, in order
+    rules          every rule, with reversible rules split into their forward
+                   and reverse halves, has the same reactant and product
+                   patterns and rate constant, in order
+
+For each reaction rule of the XML it also checks that the operations, applied
+to the reactant patterns, give the product patterns through the molecule and
+component map of the rule, and that the symmetry_factor is 1 over the number
+of ways of permuting the reactant molecules onto themselves that leave the
+reaction center in place (0.5 for the homodimerization rules of egfr_net).
+
+The BNGL reader handles the subset of the language the models here use.  The
+two BioNetGen generated models test/tlbr and test/simple_system pass the
+same check, apart from the map, which that BioNetGen version left out.
+
+Usage:
+    python3 check_xml.py
+    python3 check_xml.py egfr_net poly
+    python3 check_xml.py --bngl ../../test/tlbr/tlbr.bngl --xml ../../test/tlbr/tlbr.xml
+"""
+
+import argparse
+import math
+import os
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+MODELS = ['push_pull', 'egfr_net', 'poly', 'tlbr_performance', 'ANx_noActivity']
+
+
+class Pattern(object):
+    """Molecules with components (name, state, bond), where the bond is '0'
+    for free, '+' or '?' as in BNGL, or 'b' for a bond listed in bonds,
+    which maps (molecule, component) to the bound (molecule, component)."""
+
+    def __init__(self):
+        self.mols = []
+        self.bonds = {}
+        self.ids = {}
+
+    def __str__(self):
+        out = []
+        labels = {}
+        for mi, (name, comps) in enumerate(self.mols):
+            cs = []
+            for ci, (cname, state, bond) in enumerate(comps):
+                s = cname + ('~' + state if state is not None else '')
+                if bond == 'b':
+                    key = tuple(sorted([(mi, ci), self.bonds[(mi, ci)]]))
+                    labels.setdefault(key, len(labels) + 1)
+                    s += '!%d' % labels[key]
+                elif bond != '0':
+                    s += '!' + bond
+                cs.append(s)
+            out.append('%s(%s)' % (name, ','.join(cs)))
+        return '.'.join(out)
+
+
+# --- BNGL ------------------------------------------------------------------
+
+def eval_expr(expr, params):
+    env = dict(vars(math))
+    env.update(params)
+    return float(eval(expr.replace('^', '**'), {'__builtins__': {}}, env))
+
+
+def parse_bngl_pattern(text):
+    p = Pattern()
+    labels = {}
+    for mi, mol in enumerate(text.strip().split('.')):
+        m = re.match(r'^([A-Za-z_]\w*)(?:\((.*)\))?$', mol.strip())
+        if not m:
+            raise ValueError('cannot read molecule "%s" in %s' % (mol, text))
+        comps = []
+        for ci, comp in enumerate([c for c in (m.group(2) or '').split(',') if c.strip()]):
+            cm = re.match(r'^(\w+)(?:~(\w+|\?))?((?:!(?:\d+|\+|\?))*)$', comp.strip())
+            if not cm:
+                raise ValueError('cannot read component "%s" in %s' % (comp, text))
+            state = cm.group(2) if cm.group(2) not in (None, '?') else None
+            bonds = re.findall(r'!(\d+|\+|\?)', cm.group(3))
+            if len(bonds) > 1:
+                raise ValueError('more than one bond on a component in %s' % text)
+            bond = '0'
+            if bonds and bonds[0] in ('+', '?'):
+                bond = bonds[0]
+            elif bonds:
+                bond = 'b'
+                labels.setdefault(bonds[0], []).append((mi, ci))
+            comps.append((cm.group(1), state, bond))
+        p.mols.append((m.group(1), comps))
+    for label, ends in labels.items():
+        if len(ends) != 2:
+            raise ValueError('bond %s does not join two components in %s' % (label, text))
+        p.bonds[ends[0]] = ends[1]
+        p.bonds[ends[1]] = ends[0]
+    return p
+
+
+def split_plus(text):
+    # '+' separates patterns, '!+' is a bond
+    return [s for s in re.split(r'(?<!!)\+', text) if s.strip()]
+
+
+def read_bngl(path):
+    with open(path) as f:
+        text = f.read()
+    text = text.replace('\\\n', ' ')
+    lines = [l.split('#', 1)[0].strip() for l in text.split('\n')]
+    blocks = {}
+    current = None
+    for line in lines:
+        if not line:
+            continue
+        m = re.match(r'^(begin|end)\s+(.*)$', line)
+        if m:
+            current = m.group(2).strip() if m.group(1) == 'begin' else None
+            if current:
+                blocks.setdefault(current, [])
+        elif current:
+            blocks[current].append(line)
+
+    model = {'params': [], 'types': None, 'species': [], 'observables': [], 'rules': []}
+    values = {}
+    for line in blocks.get('parameters', []):
+        m = re.match(r'^(?:\d+\s+)?([A-Za-z_]\w*)\s*(?:=\s*|\s+)(.+)$', line)
+        values[m.group(1)] = eval_expr(m.group(2), values)
+        model['params'].append((m.group(1), values[m.group(1)]))
+    if 'molecule types' in blocks:
+        model['types'] = [parse_bngl_type(l) for l in blocks['molecule types']]
+    for line in blocks.get('species', []):
+        pat, count = line.rsplit(None, 1)
+        model['species'].append((parse_bngl_pattern(pat), eval_expr(count, values)))
+    for line in blocks.get('observables', []):
+        # patterns are separated by blanks or by commas outside of parentheses
+        fields = re.sub(r',(?![^()]*\))', ' ', line).split()
+        model['observables'].append((fields[1], fields[0], [parse_bngl_pattern(f) for f in fields[2:]]))
+    for line in blocks.get('reaction rules', []):
+        line = re.sub(r'^\s*\w+:\s*', '', line)
+        m = re.match(r'^(.*?)(<->|->)(.*)$', line)
+        lhs, arrow, rhs = m.group(1), m.group(2), m.group(3).strip()
+        if arrow == '<->':
+            rm = re.match(r'^(.*?)\s+(\S+)\s*,\s*(\S+)$', rhs)
+            rhs, rates = rm.group(1), [rm.group(2), rm.group(3)]
+        else:
+            rhs, rates = rhs.rsplit(None, 1)
+            rates = [rates]
+        reac = [parse_bngl_pattern(s) for s in split_plus(lhs)]
+        prod = [parse_bngl_pattern(s) for s in split_plus(rhs)]
+        model['rules'].append((line, reac, prod, eval_expr(rates[0], values)))
+        if arrow == '<->':
+            model['rules'].append((line + ' (reverse)', prod, reac, eval_expr(rates[1], values)))
+    model['values'] = values
+    return model
+
+
+def parse_bngl_type(text):
+    m = re.match(r'^([A-Za-z_]\w*)(?:\((.*)\))?$', text)
+    comps = []
+    for comp in [c for c in (m.group(2) or '').split(',') if c.strip()]:
+        fields = comp.strip().split('~')
+        comps.append((fields[0], set(fields[1:])))
+    return (m.group(1), comps)
+
+
+def infer_types(model):
+    # BioNetGen takes the components from the first molecule of each type it
+    # sees and collects the states from every later one
+    types = {}
+    order = []
+    pats = [p for p, _ in model['species']]
+    for _, reac, prod, _ in model['rules']:
+        pats += reac + prod
+    for _, _, ps in model['observables']:
+        pats += ps
+    for p in pats:
+        for name, comps in p.mols:
+            if name not in types:
+                order.append(name)
+                types[name] = []
+                for cname, state, _ in comps:
+                    types[name].append((cname, set()))
+            for cname, state, _ in comps:
+                if state is None:
+                    continue
+                for tname, states in types[name]:
+                    if tname == cname:
+                        states.add(state)
+    return [(name, types[name]) for name in order]
+
+
+# --- XML -------------------------------------------------------------------
+
+def local(tag):
+    return tag.split('}', 1)[-1]
+
+
+def children(elem, *path):
+    found = [elem]
+    for name in path:
+        found = [c for e in found for c in e if local(c.tag) == name]
+    return found
+
+
+def read_xml_pattern(elem):
+    p = Pattern()
+    for mi, mol in enumerate(children(elem, 'ListOfMolecules', 'Molecule')):
+        p.ids[mol.get('id')] = (mi, None)
+        comps = []
+        for ci, comp in enumerate(children(mol, 'ListOfComponents', 'Component')):
+            p.ids[comp.get('id')] = (mi, ci)
+            nb = comp.get('numberOfBonds')
+            comps.append((comp.get('name'), comp.get('state'), 'b' if nb not in ('0', '+', '?') else nb))
+        p.mols.append((mol.get('name'), comps))
+    for bond in children(elem, 'ListOfBonds', 'Bond'):
+        a, b = p.ids[bond.get('site1')], p.ids[bond.get('site2')]
+        p.bonds[a] = b
+        p.bonds[b] = a
+    # older BioNetGen versions write !+ as one bond that is not in the list
+    for mi, (name, comps) in enumerate(p.mols):
+        for ci, comp in enumerate(comps):
+            if comp[2] == 'b' and (mi, ci) not in p.bonds:
+                comps[ci] = (comp[0], comp[1], '+')
+    return p
+
+
+def read_xml(path):
+    root = ET.parse(path).getroot()
+    model = children(root, 'model')[0]
+    out = {'params': [], 'types': [], 'species': [], 'observables': [], 'rules': []}
+    values = {}
+    for par in children(model, 'ListOfParameters', 'Parameter'):
+        values[par.get('id')] = eval_expr(par.get('value'), values)
+        out['params'].append((par.get('id'), values[par.get('id')]))
+    for mt in children(model, 'ListOfMoleculeTypes', 'MoleculeType'):
+        comps = []
+        for ct in children(mt, 'ListOfComponentTypes', 'ComponentType'):
+            comps.append((ct.get('id'), set(s.get('id') for s in children(ct, 'ListOfAllowedStates', 'AllowedState'))))
+        out['types'].append((mt.get('id'), comps))
+    for sp in children(model, 'ListOfSpecies', 'Species'):
+        out['species'].append((read_xml_pattern(sp), eval_expr(sp.get('concentration'), values)))
+    for obs in children(model, 'ListOfObservables', 'Observable'):
+        out['observables'].append((obs.get('name'), obs.get('type'),
+                                   [read_xml_pattern(p) for p in children(obs, 'ListOfPatterns', 'Pattern')]))
+    for rr in children(model, 'ListOfReactionRules', 'ReactionRule'):
+        reac = [read_xml_pattern(p) for p in children(rr, 'ListOfReactantPatterns', 'ReactantPattern')]
+        prod = [read_xml_pattern(p) for p in children(rr, 'ListOfProductPatterns', 'ProductPattern')]
+        rates = children(rr, 'RateLaw', 'ListOfRateConstants', 'RateConstant')
+        rate = eval_expr(rates[0].get('value'), values) if len(rates) == 1 else None
+        items = [(m.get('sourceID'), m.get('targetID')) for m in children(rr, 'Map', 'MapItem')]
+        ops = [(local(o.tag), dict(o.attrib)) for o in children(rr, 'ListOfOperations')[0]]
+        out['rules'].append({'id': rr.get('id'), 'reac': reac, 'prod': prod, 'rate': rate,
+                             'map': items, 'ops': ops,
+                             'symmetry': float(rr.get('symmetry_factor', '1'))})
+    return out
+
+
+# --- pattern matching --------------------------------------------------------
+
+def label(comp):
+    return (comp[0], comp[1], comp[2])
+
+
+def isomorphisms(a, b):
+    """Yields (molecule map, component map) from a onto b."""
+    if len(a.mols) != len(b.mols):
+        return
+    sig = lambda mol: (mol[0], sorted(map(label, mol[1]), key=str))
+    # visit the molecules of a along the bonds, so partners are mapped early
+    order = []
+    for start in range(len(a.mols)):
+        stack = [start]
+        while stack:
+            mi = stack.pop()
+            if mi in order:
+                continue
+            order.append(mi)
+            stack += [a.bonds[(mi, ci)][0] for ci in range(len(a.mols[mi][1])) if (mi, ci) in a.bonds]
+    molmap, compmap = {}, {}
+
+    def comps(mi, mj, ci, used):
+        if ci == len(a.mols[mi][1]):
+            yield
+            return
+        ca = a.mols[mi][1][ci]
+        for cj, cb in enumerate(b.mols[mj][1]):
+            if cj in used or label(ca) != label(cb):
+                continue
+            if ca[2] == 'b':
+                pm, pc = a.bonds[(mi, ci)]
+                if pm in molmap and (pm, pc) in compmap and compmap[(pm, pc)] != b.bonds[(mj, cj)]:
+                    continue
+                if pm == mi and pc < ci and compmap[(pm, pc)] != b.bonds[(mj, cj)]:
+                    continue
+            compmap[(mi, ci)] = (mj, cj)
+            for _ in comps(mi, mj, ci + 1, used | {cj}):
+                yield
+            del compmap[(mi, ci)]
+
+    def mols(k):
+        if k == len(order):
+            yield dict(molmap), dict(compmap)
+            return
+        mi = order[k]
+        for mj in range(len(b.mols)):
+            if mj in molmap.values() or sig(a.mols[mi]) != sig(b.mols[mj]):
+                continue
+            molmap[mi] = mj
+            for _ in comps(mi, mj, 0, frozenset()):
+                for found in mols(k + 1):
+                    yield found
+            del molmap[mi]
+
+    for found in mols(0):
+        yield found
+
+
+def same(a, b):
+    return next(isomorphisms(a, b), None) is not None
+
+
+def merge(patterns):
+    """One pattern holding all of the given ones, for the rule checks."""
+    out = Pattern()
+    for p in patterns:
+        base = len(out.mols)
+        out.mols += p.mols
+        for (m, c), (pm, pc) in p.bonds.items():
+            out.bonds[(m + base, c)] = (pm + base, pc)
+        for key, (m, c) in p.ids.items():
+            out.ids[key] = (m + base, c)
+    return out
+
+
+def close(x, y):
+    return x is not None and y is not None and abs(x - y) <= 1e-9 * max(abs(x), abs(y), 1e-300)
+
+
+# --- rule checks -------------------------------------------------------------
+
+def apply_operations(rule, reac):
+    """The reactants after the operations of the rule, or an error message."""
+    mols = [(name, [list(c) for c in comps]) for name, comps in reac.mols]
+    bonds = dict(reac.bonds)
+    for kind, attr in rule['ops']:
+        if kind == 'StateChange':
+            mi, ci = reac.ids[attr['site']]
+            mols[mi][1][ci][1] = attr['finalState']
+        elif kind in ('AddBond', 'DeleteBond'):
+            s1, s2 = reac.ids[attr['site1']], reac.ids[attr['site2']]
+            for s, other in ((s1, s2), (s2, s1)):
+                comp = mols[s[0]][1][s[1]]
+                if kind == 'AddBond':
+                    if comp[2] != '0':
+                        return None, '%s adds a bond to a site that is not free' % rule['id']
+                    comp[2] = 'b'
+                    bonds[s] = other
+                else:
+                    if bonds.get(s) != other:
+                        return None, '%s deletes a bond that is not there' % rule['id']
+                    comp[2] = '0'
+                    del bonds[s]
+        else:
+            return None, '%s: cannot check the %s operation' % (rule['id'], kind)
+    return (mols, bonds), None
+
+
+def check_map(rule, reac, prod):
+    if any(t is None for _, t in rule['map']):
+        return ['%s has no map targets, not checked' % rule['id']], []
+    result, error = apply_operations(rule, reac)
+    if error:
+        return [], [error]
+    mols, bonds = result
+    target = dict((reac.ids[s], prod.ids[t]) for s, t in rule['map'])
+    errors = []
+    for mi, (name, comps) in enumerate(mols):
+        if (mi, None) not in target:
+            errors.append('%s deletes %s, which cannot be checked' % (rule['id'], name))
+            continue
+        pm = target[(mi, None)][0]
+        if prod.mols[pm][0] != name or len(prod.mols[pm][1]) != len(comps):
+            errors.append('%s maps %s onto %s' % (rule['id'], name, prod.mols[pm][0]))
+            continue
+        for ci, comp in enumerate(comps):
+            t = target.get((mi, ci))
+            if t is None or t[0] != pm:
+                errors.append('%s does not map %s.%s' % (rule['id'], name, comp[0]))
+                continue
+            if tuple(comp) != label(prod.mols[t[0]][1][t[1]]):
+                errors.append('%s gives %s.%s as %s, the product has %s'
+                              % (rule['id'], name, comp[0], tuple(comp), prod.mols[t[0]][1][t[1]]))
+            elif comp[2] == 'b' and target.get(bonds[(mi, ci)]) != prod.bonds[t]:
+                errors.append('%s bonds %s.%s to the wrong product site' % (rule['id'], name, comp[0]))
+    if len(set(m for (m, c) in target.values() if c is None)) != len(prod.mols):
+        errors.append('%s creates molecules, which cannot be checked' % rule['id'])
+    return [], errors
+
+
+def center(rule, reac):
+    out = set()
+    for kind, attr in rule['ops']:
+        if kind == 'StateChange':
+            out.add((kind, reac.ids[attr['site']], attr['finalState']))
+        else:
+            out.add((kind, frozenset([reac.ids[attr['site1']], reac.ids[attr['site2']]])))
+    return out
+
+
+def symmetry_factor(rule, reac):
+    ops = center(rule, reac)
+    perms = set()
+    for molmap, compmap in isomorphisms(reac, reac):
+        moved = set()
+        for op in ops:
+            if op[0] == 'StateChange':
+                moved.add((op[0], compmap[op[1]], op[2]))
+            else:
+                moved.add((op[0], frozenset(compmap[s] for s in op[1])))
+        if moved == ops:
+            perms.add(tuple(sorted(molmap.items())))
+    return 1.0 / len(perms)
+
+
+# --- the check ---------------------------------------------------------------
+
+def check(bngl_path, xml_path):
+    bngl, xml = read_bngl(bngl_path), read_xml(xml_path)
+    errors, notes = [], []
+
+    bp, xp = dict(bngl['params']), dict(xml['params'])
+    for name in sorted(set(bp) | set(xp)):
+        if name not in xp:
+            errors.append('parameter %s is missing from the XML' % name)
+        elif name not in bp:
+            errors.append('parameter %s is not in the BNGL' % name)
+        elif not close(bp[name], xp[name]):
+            errors.append('parameter %s is %r in the BNGL and %r in the XML' % (name, bp[name], xp[name]))
+
+    types = bngl['types'] if bngl['types'] is not None else infer_types(bngl)
+    if [(n, c) for n, c in types] != xml['types']:
+        errors.append('molecule types differ:\n      BNGL %s\n      XML  %s' % (types, xml['types']))
+
+    if len(bngl['species']) != len(xml['species']):
+        errors.append('%d species in the BNGL, %d in the XML' % (len(bngl['species']), len(xml['species'])))
+    for i, ((bp_, bc), (xp_, xc)) in enumerate(zip(bngl['species'], xml['species'])):
+        if not same(bp_, xp_) or not close(bc, xc):
+            errors.append('species %d: %s %g in the BNGL, %s %g in the XML' % (i + 1, bp_, bc, xp_, xc))
+
+    if len(bngl['observables']) != len(xml['observables']):
+        errors.append('%d observables in the BNGL, %d in the XML'
+                      % (len(bngl['observables']), len(xml['observables'])))
+    for (bn, bt, bps), (xn, xt, xps) in zip(bngl['observables'], xml['observables']):
+        if bn != xn or bt != xt or len(bps) != len(xps) or not all(same(a, b) for a, b in zip(bps, xps)):
+            errors.append('observable %s %s differs from %s %s in the XML' % (bt, bn, xt, xn))
+
+    if len(bngl['rules']) != len(xml['rules']):
+        errors.append('%d rules (reverse rules counted) in the BNGL, %d in the XML'
+                      % (len(bngl['rules']), len(xml['rules'])))
+    for (text, breac, bprod, brate), rule in zip(bngl['rules'], xml['rules']):
+        where = '%s (%s)' % (rule['id'], text)
+        if len(breac) != len(rule['reac']) or not all(same(a, b) for a, b in zip(breac, rule['reac'])):
+            errors.append('%s: the reactants differ' % where)
+        if len(bprod) != len(rule['prod']) or not all(same(a, b) for a, b in zip(bprod, rule['prod'])):
+            errors.append('%s: the products differ' % where)
+        if not close(brate, rule['rate']):
+            errors.append('%s: rate %r in the BNGL, %r in the XML' % (where, brate, rule['rate']))
+        reac, prod = merge(rule['reac']), merge(rule['prod'])
+        n, e = check_map(rule, reac, prod)
+        notes += n
+        errors += e
+        expected = symmetry_factor(rule, reac)
+        if not close(expected, rule['symmetry']):
+            errors.append('%s: symmetry_factor is %g, expected %g' % (where, rule['symmetry'], expected))
+
+    counts = '%d parameters, %d molecule types, %d species, %d observables, %d rules' % (
+        len(xml['params']), len(xml['types']), len(xml['species']),
+        len(xml['observables']), len(xml['rules']))
+    return counts, notes, errors
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('models', nargs='*', help='models in this folder to check (default: all)')
+    ap.add_argument('--bngl', help='check this BNGL file instead ...')
+    ap.add_argument('--xml', help='... against this XML file')
+    opts = ap.parse_args()
+
+    if opts.bngl or opts.xml:
+        pairs = [(opts.bngl, opts.xml)]
+    else:
+        pairs = [(os.path.join(HERE, m + '.bngl'), os.path.join(HERE, m + '.xml')) for m in (opts.models or MODELS)]
+
+    status = 0
+    for bngl, xml in pairs:
+        counts, notes, errors = check(bngl, xml)
+        print('%-4s %s  (%s)' % ('FAIL' if errors else 'ok', os.path.basename(xml), counts))
+        for n in notes:
+            print('       note: ' + n)
+        for e in errors:
+            print('       ' + e)
+        if errors:
+            status = 1
+    return status
+
+
+if __name__ == '__main__':
+    sys.exit(main())
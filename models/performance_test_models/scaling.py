@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""Scaling study: how the cost of an NFsim model grows with system size.
+
+One of the performance test models is run at several system sizes.  For each
+scale factor a copy of the model XML is written in which the count of every
+seed species is multiplied by that factor (and rounded to the nearest
+integer), and the copy is run with the fixed seed, the command line options
+and an event budget from benchmark.py.  Counts given as a parameter name are
+replaced by the scaled value of the parameter in the Species element only, so
+rate laws that use the same parameter are left untouched.  Rate constants are
+not rescaled for volume, so the copies are larger systems, not the same
+system in a larger volume.
+
+For each size the report holds the number of seed molecules, the CPU time per
+event and per non-null event, the startup time and the peak resident set
+size.  A power law  metric ~ molecules^k  is then fitted to every metric by
+least squares in log-log space, and the exponents are written to the JSON
+report.  An ideal simulator has a cost per event that does not depend on the
+system size (k = 0) and startup time and memory that grow linearly (k = 1).
+Exponents above those by more than --slack are flagged, so a change that
+makes a code path super-linear in the system size shows up in the report.
+
+Usage:
+    python3 scaling.py --model egfr_net --scales 0.25 0.5 1 2 4 -o scaling.json
+    python3 scaling.py --model tlbr_performance --scales 0.5 1 2 --events 20000
+"""
+
+import argparse
+import json
+import math
+import os
+import platform
+import sys
+import tempfile
+import time
+import xml.etree.ElementTree as ET
+
+import benchmark
+
+# metric -> exponent of an ideal implementation
+EXPECTED_EXPONENTS = {
+    'cpu_s_per_event': 0.0,
+    'cpu_s_per_nonnull': 0.0,
+    'startup_cpu_s': 1.0,
+    'peak_rss_kb': 1.0,
+}
+
+
+def local(tag):
+    return tag.split('}', 1)[-1]
+
+
+def scale_model(src, dst, factor):
+    """Writes a copy of the model with all seed species counts scaled.
+
+    Returns the number of seed molecules in the scaled copy."""
+    ET.register_namespace('', 'http://www.sbml.org/sbml/level3')
+    tree = ET.parse(src)
+    params = {}
+    for el in tree.iter():
+        if local(el.tag) == 'Parameter':
+            try:
+                params[el.get('id')] = float(el.get('value'))
+            except (TypeError, ValueError):
+                pass
+    molecules = 0
+    for el in tree.iter():
+        if local(el.tag) != 'Species':
+            continue
+        conc = el.get('concentration')
+        try:
+            count = float(conc)
+        except (TypeError, ValueError):
+            if conc not in params:
+                raise RuntimeError('species %s has a count (%s) that is not a number or a parameter'
+                                   % (el.get('id'), conc))
+            count = params[conc]
+        count = int(round(count * factor))
+        el.set('concentration', str(count))
+        n_mol = sum(1 for m in el.iter() if local(m.tag) == 'Molecule')
+        molecules += count * n_mol
+    tree.write(dst, xml_declaration=True, encoding='UTF-8')
+    return molecules
+
+
+def fit_exponent(xs, ys):
+    """Least squares slope of log(y) against log(x), or None if it can't be fit."""
+    pts = [(math.log(x), math.log(y)) for x, y in zip(xs, ys)
+           if x > 0 and y is not None and y == y and y > 0]
+    if len(pts) < 2:
+        return None
+    mx = sum(p[0] for p in pts) / len(pts)
+    my = sum(p[1] for p in pts) / len(pts)
+    sxx = sum((p[0] - mx) ** 2 for p in pts)
+    if sxx == 0:
+        return None
+    return sum((p[0] - mx) * (p[1] - my) for p in pts) / sxx
+
+
+def run_study(nfsim, name, scales, events, repeat):
+    entry = [m for m in benchmark.MODELS if m[0] == name]
+    if not entry:
+        raise RuntimeError('unknown model %s, expected one of %s'
+                           % (name, ', '.join(m[0] for m in benchmark.MODELS)))
+    _, args, budget = entry[0]
+    if events:
+        budget = events
+    src = os.path.join(benchmark.HERE, name + '.xml')
+
+    sizes = []
+    with tempfile.TemporaryDirectory(prefix='nfsim_scaling_') as workdir:
+        for factor in sorted(scales):
+            xml = os.path.join(workdir, '%s_x%g.xml' % (name, factor))
+            molecules = scale_model(src, xml, factor)
+            runs = [benchmark.run_once(nfsim, '%s_x%g' % (name, factor), args, budget, workdir, xml=xml)
+                    for r in range(repeat)]
+            best = min(runs, key=lambda x: x['sim_cpu_s'])
+            best['startup_cpu_s'] = min(x['startup_cpu_s'] for x in runs)
+            best['peak_rss_kb'] = min(x['peak_rss_kb'] for x in runs)
+            best['cpu_s_per_event'] = best['sim_cpu_s'] / best['events'] if best['events'] else float('nan')
+            best['scale'] = factor
+            best['molecules'] = molecules
+            sizes.append(best)
+            print('x%-6g %9d molecules  %9d events  %.3e s/event  %.3e s/non-null  startup %.3fs  rss %d kB'
+                  % (factor, molecules, best['events'], best['cpu_s_per_event'],
+                     best['cpu_s_per_nonnull'], best['startup_cpu_s'], best['peak_rss_kb']))
+    return sizes, budget
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--nfsim', default=benchmark.default_nfsim(), help='path to the NFsim executable')
+    ap.add_argument('--model', default='egfr_net', help='performance test model to scale')
+    ap.add_argument('--scales', type=float, nargs='+', default=[0.25, 0.5, 1, 2, 4],
+                    help='factors to multiply the seed species counts by')
+    ap.add_argument('--events', type=int, help='event budget per run (default: the benchmark budget)')
+    ap.add_argument('--repeat', type=int, default=1, help='runs per size, the fastest is kept')
+    ap.add_argument('--slack', type=float, default=0.15,
+                    help='how far above the ideal exponent a metric may be before it is flagged')
+    ap.add_argument('-o', '--output', default='scaling_report.json', help='JSON report to write')
+    opts = ap.parse_args()
+
+    if any(s <= 0 for s in opts.scales):
+        print('scale factors must be positive')
+        return 2
+    nfsim = os.path.abspath(opts.nfsim)
+    sizes, budget = run_study(nfsim, opts.model, opts.scales, opts.events, max(1, opts.repeat))
+
+    xs = [s['molecules'] for s in sizes]
+    exponents = {}
+    flagged = []
+    for metric, ideal in EXPECTED_EXPONENTS.items():
+        k = fit_exponent(xs, [s.get(metric) for s in sizes])
+        exponents[metric] = k
+        if k is None:
+            print('%-18s exponent could not be fit' % metric)
+            continue
+        flag = k > ideal + opts.slack
+        if flag:
+            flagged.append(metric)
+        print('%-18s ~ molecules^%.3f  (ideal %g)%s'
+              % (metric, k, ideal, '  SUPER-LINEAR' if flag else ''))
+
+    report = {
+        'nfsim': nfsim,
+        'model': opts.model,
+        'seed': benchmark.SEED,
+        'budget': budget,
+        'repeat': opts.repeat,
+        'host': platform.node(),
+        'platform': platform.platform(),
+        'date': time.strftime('%Y-%m-%dT%H:%M:%S'),
+        'sizes': sizes,
+        'exponents': exponents,
+        'expected_exponents': EXPECTED_EXPONENTS,
+        'flagged': flagged,
+    }
+    with open(opts.output, 'w') as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+    print('report written to %s' % opts.output)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
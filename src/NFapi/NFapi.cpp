@@ -0,0 +1,166 @@
+#include "NFapi.h"
+#include "../NFsim.hh"
+
+#include <cstring>
+
+using namespace NFcore;
+
+
+struct nfsim_system {
+	System *s;
+	bool verbose;
+	vector <string> obsNames;
+	vector <double> obsValues;
+};
+
+
+// NFsim reports everything on cout, which an embedding program usually
+// does not want, so it is switched off while a call is running
+class QuietScope {
+	public:
+		QuietScope(bool verbose) : old(0) { if(!verbose) old = cout.rdbuf(0); };
+		~QuietScope() { if(old!=0) cout.rdbuf(old); };
+	private:
+		streambuf *old;
+};
+
+
+static void copyObservables(nfsim_system *sys)
+{
+	sys->s->refreshObservables();
+	for(unsigned int o=0; o<sys->obsValues.size(); o++)
+		sys->obsValues[o] = sys->s->getObservable(o)->getCount();
+}
+
+
+nfsim_system *nfsim_create(int argc, const char *argv[])
+{
+	// parseArguments skips the program name, as it does for main()
+	vector <const char *> args;
+	args.push_back("nfsim");
+	for(int a=0; a<argc; a++) args.push_back(argv[a]);
+
+	map<string,string> argMap;
+	if(!NFinput::parseArguments(args.size(), &args[0], argMap)) return 0;
+	bool verbose = argMap.find("v")!=argMap.end();
+	if(argMap.find("o")==argMap.end()) argMap["nooutput"] = "";
+
+	QuietScope quiet(verbose);
+	if(argMap.find("seed")!=argMap.end())
+		NFutil::SEED_RANDOM(abs(NFinput::parseAsInt(argMap,"seed",0)));
+
+	System *s = initSystemFromFlags(argMap, verbose);
+	if(s==0) return 0;
+	s->prepareForSimulation();
+	s->snapshot();
+
+	nfsim_system *sys = new nfsim_system;
+	sys->s = s;
+	sys->verbose = verbose;
+	for(int o=0; o<s->getNumOfObservables(); o++)
+		sys->obsNames.push_back(s->getObservable(o)->getName());
+	sys->obsValues.assign(s->getNumOfObservables(), 0);
+	copyObservables(sys);
+	return sys;
+}
+
+
+nfsim_system *nfsim_load_xml(const char *filename)
+{
+	const char *args[] = { "-xml", filename };
+	return nfsim_create(2, args);
+}
+
+
+void nfsim_destroy(nfsim_system *sys)
+{
+	if(sys==0) return;
+	QuietScope quiet(sys->verbose);
+	delete sys->s;
+	delete sys;
+}
+
+
+void nfsim_seed(unsigned long seed)
+{
+	NFutil::SEED_RANDOM(seed);
+}
+
+
+int nfsim_set_parameter(nfsim_system *sys, const char *name, double value)
+{
+	if(!sys->s->hasParameter(name)) return -1;
+	sys->s->setParameter(name, value);
+	return 0;
+}
+
+
+double nfsim_get_parameter(nfsim_system *sys, const char *name)
+{
+	if(!sys->s->hasParameter(name)) return 0;
+	return sys->s->getParameter(name);
+}
+
+
+void nfsim_update_parameters(nfsim_system *sys)
+{
+	QuietScope quiet(sys->verbose);
+	sys->s->updateSystemWithNewParameters();
+}
+
+
+double nfsim_step_to(nfsim_system *sys, double time)
+{
+	QuietScope quiet(sys->verbose);
+	double t = sys->s->stepTo(time);
+	copyObservables(sys);
+	return t;
+}
+
+
+double nfsim_time(nfsim_system *sys)
+{
+	return sys->s->getCurrentTime();
+}
+
+
+int nfsim_num_observables(nfsim_system *sys)
+{
+	return sys->obsValues.size();
+}
+
+
+const char *nfsim_observable_name(nfsim_system *sys, int index)
+{
+	if(index<0 || index>=(int)sys->obsNames.size()) return 0;
+	return sys->obsNames[index].c_str();
+}
+
+
+int nfsim_observable_index(nfsim_system *sys, const char *name)
+{
+	for(unsigned int o=0; o<sys->obsNames.size(); o++)
+		if(sys->obsNames[o]==name) return o;
+	return -1;
+}
+
+
+const double *nfsim_observables(nfsim_system *sys)
+{
+	if(sys->obsValues.empty()) return 0;
+	return &sys->obsValues[0];
+}
+
+
+void nfsim_snapshot(nfsim_system *sys)
+{
+	sys->s->snapshot();
+}
+
+
+void nfsim_reset(nfsim_system *sys)
+{
+	QuietScope quiet(sys->verbose);
+	sys->s->restore();
+	copyObservables(sys);
+}
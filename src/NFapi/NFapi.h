@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////
+// NFapi.h
+//
+// C interface to NFsim, for programs that embed the
+// simulator (built as libnfsim) instead of running the
+// NFsim executable once per simulation.
+//
+// A model is loaded and prepared once, after which it can
+// be stepped, reset to its initial state and given new
+// parameter values as often as needed, without any file
+// I/O.  A typical fitting loop looks like:
+//
+//    const char *args[] = { "-xml", "model.xml", "-cb" };
+//    nfsim_system *sys = nfsim_create(3, args);
+//    const double *obs = nfsim_observables(sys);
+//    for(...) {
+//       nfsim_reset(sys);
+//       nfsim_seed(seed);
+//       nfsim_set_parameter(sys, "kon", kon);
+//       nfsim_update_parameters(sys);
+//       for(t=dt; t<=tEnd; t+=dt) {
+//          nfsim_step_to(sys, t);
+//          ... read obs[0] .. obs[nfsim_num_observables(sys)-1]
+//       }
+//    }
+//    nfsim_destroy(sys);
+//
+// The random number generator is shared by all systems in
+// a process, and none of these functions are thread safe.
+// As in the executable, errors in the model stop the
+// process.
+//
+//////////////////////////////////////////////////////////
+#ifndef NFAPI_H_
+#define NFAPI_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct nfsim_system nfsim_system;
+
+
+/* Loads and prepares a model from the usual NFsim command line flags, for
+ * instance { "-xml", "model.xml", "-cb", "-utl", "4" }.  No output file is
+ * written unless -o is given, and the console output of NFsim is suppressed
+ * unless -v is given.  A snapshot of the prepared system is taken, so that
+ * nfsim_reset() goes back to it.  Returns NULL if the model can't be loaded. */
+nfsim_system *nfsim_create(int argc, const char *argv[]);
+
+/* Same as nfsim_create() with just the -xml flag. */
+nfsim_system *nfsim_load_xml(const char *filename);
+
+void nfsim_destroy(nfsim_system *sys);
+
+
+/* Seeds the random number generator shared by all systems. */
+void nfsim_seed(unsigned long seed);
+
+
+/* Sets a model parameter; returns 0, or -1 if there is no such parameter.
+ * Changes take effect when nfsim_update_parameters() is called. */
+int nfsim_set_parameter(nfsim_system *sys, const char *name, double value);
+double nfsim_get_parameter(nfsim_system *sys, const char *name);
+void nfsim_update_parameters(nfsim_system *sys);
+
+
+/* Simulates until the given time and returns the time of the last event, which
+ * is at most the given time.  The observables are up to date afterwards. */
+double nfsim_step_to(nfsim_system *sys, double time);
+double nfsim_time(nfsim_system *sys);
+
+
+/* Observable counts, in the order of the gdat output.  The returned array
+ * stays at the same address for the lifetime of the system, and holds the
+ * counts as of the last nfsim_step_to() or nfsim_reset(). */
+int nfsim_num_observables(nfsim_system *sys);
+const char *nfsim_observable_name(nfsim_system *sys, int index);
+int nfsim_observable_index(nfsim_system *sys, const char *name);
+const double *nfsim_observables(nfsim_system *sys);
+
+
+/* Takes a new snapshot of the current state, and puts the system back into
+ * the last snapshot (the prepared model, if nfsim_snapshot() was never
+ * called).  Parameter values are not part of the snapshot. */
+void nfsim_snapshot(nfsim_system *sys);
+void nfsim_reset(nfsim_system *sys);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NFAPI_H_ */
@@ -0,0 +1,225 @@
+#include "NFserver.hh"
+#include "../NFsim.hh"
+
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <cerrno>
+#include <signal.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+using namespace NFcore;
+
+
+static void addObservableRow(System *s, double time, vector <double> &table)
+{
+	s->refreshObservables();
+	table.push_back(time);
+	for(int o=0; o<s->getNumOfObservables(); o++)
+		table.push_back(s->getObservable(o)->getCount());
+}
+
+
+bool NFserver::runCommand(System *s, string command, string &text, vector <double> &table,
+		unsigned int &rows, unsigned int &cols, bool &closeConnection, bool &stopServer)
+{
+	table.clear();
+	rows = 0; cols = 0;
+
+	string::size_type comment = command.find_first_of("#");
+	if(comment!=string::npos) command = command.substr(0,comment);
+	NFutil::trim(command);
+	if(command.empty()) return true;
+
+	stringstream words(command);
+	string verb;
+	words>>verb;
+
+	// everything printed while the command runs goes back to the client
+	stringstream captured;
+	streambuf *old = cout.rdbuf(captured.rdbuf());
+	bool known = true;
+
+	if(verb=="sim") {
+		double duration = 10; int steps = 1;
+		words>>duration;
+		if(!(words>>steps) || steps<1) steps = 1;
+		double start = s->getCurrentTime();
+		cols = s->getNumOfObservables()+1;
+		table.reserve((steps+1)*cols);
+		addObservableRow(s,start,table);
+		for(int k=1; k<=steps; k++) {
+			double sampleTime = start + duration*(double)k/(double)steps;
+			s->stepTo(sampleTime);
+			addObservableRow(s,sampleTime,table);
+		}
+		rows = steps+1;
+	}
+	else if(verb=="observables") {
+		cout<<"time";
+		for(int o=0; o<s->getNumOfObservables(); o++)
+			cout<<"\t"<<s->getObservable(o)->getName();
+		cout<<endl;
+		cols = s->getNumOfObservables()+1;
+		addObservableRow(s,s->getCurrentTime(),table);
+		rows = 1;
+	}
+	else if(verb=="quit") {
+		closeConnection = true;
+	}
+	else if(verb=="shutdown") {
+		closeConnection = true;
+		stopServer = true;
+	}
+	else {
+		known = NFinput::runRNFcommand(s,command,false);
+		if(!known) cout<<"could not figure out what you wanted to do for command: "<<command<<endl;
+	}
+
+	cout.rdbuf(old);
+	text = captured.str();
+	return known;
+}
+
+
+#ifndef _WIN32
+
+static volatile sig_atomic_t stopRequested = 0;
+static void requestStop(int) { stopRequested = 1; }
+
+
+static bool writeAll(int fd, const char *data, size_t length)
+{
+	while(length>0) {
+		ssize_t n = write(fd, data, length);
+		if(n<=0) return false;
+		data += n; length -= n;
+	}
+	return true;
+}
+
+
+//! Serves one client until it disconnects, in a process of its own
+static void serveClient(System *s, int client, pid_t server)
+{
+	signal(SIGPIPE, SIG_IGN);
+	string pending, text;
+	vector <double> table;
+	char chunk[4096];
+	bool closeConnection = false, stopServer = false;
+
+	while(!closeConnection) {
+		string::size_type eol;
+		while((eol = pending.find('\n'))==string::npos) {
+			ssize_t n = read(client, chunk, sizeof(chunk));
+			if(n<=0) return;
+			pending.append(chunk,n);
+		}
+		string command = pending.substr(0,eol);
+		pending.erase(0,eol+1);
+
+		unsigned int header[4];
+		bool known = NFserver::runCommand(s,command,text,table,header[2],header[3],closeConnection,stopServer);
+		header[0] = known ? NFserver::OK : NFserver::UNKNOWN_COMMAND;
+		header[1] = text.size();
+		if(!writeAll(client,(const char *)header,sizeof(header))) return;
+		if(!writeAll(client,text.data(),text.size())) return;
+		if(!table.empty() && !writeAll(client,(const char *)&table[0],table.size()*sizeof(double))) return;
+	}
+	if(stopServer) kill(server,SIGTERM);
+}
+
+
+bool NFserver::serve(map<string,string> &argMap, bool verbose)
+{
+	string path = argMap.find("serve")->second;
+	struct sockaddr_un address;
+	if(path.empty() || path.size()>=sizeof(address.sun_path)) {
+		cout<<"The -serve flag needs the path of a socket, of at most "<<sizeof(address.sun_path)-1<<" characters."<<endl;
+		return false;
+	}
+
+	// no gdat file, the observables go back to the clients
+	argMap.erase("o");
+	argMap["nooutput"] = "";
+	System *s = initSystemFromFlags(argMap, verbose);
+	if(s==0) return false;
+	s->prepareForSimulation();
+	s->snapshot();
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(listener<0) {
+		cerr<<"Could not create a socket for the server."<<endl;
+		delete s;
+		return false;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path)-1);
+	unlink(path.c_str());
+	if(bind(listener, (struct sockaddr *)&address, sizeof(address))!=0 || listen(listener, 16)!=0) {
+		cerr<<"Could not listen on the socket "<<path<<": "<<strerror(errno)<<endl;
+		close(listener);
+		delete s;
+		return false;
+	}
+
+	// children are reaped automatically, and a 'shutdown' from a client or a
+	// SIGINT/SIGTERM ends the accept loop so the socket file gets removed
+	signal(SIGCHLD, SIG_IGN);
+	struct sigaction stop;
+	memset(&stop, 0, sizeof(stop));
+	stop.sa_handler = requestStop;
+	sigaction(SIGTERM, &stop, 0);
+	sigaction(SIGINT, &stop, 0);
+
+	// each connection gets a random stream of its own, seeded like the
+	// replicates of -replicates, so that clients don't repeat each other
+	unsigned long baseSeed = (unsigned long) time(NULL);
+	if(argMap.find("seed")!=argMap.end())
+		baseSeed = abs(NFinput::parseAsInt(argMap,"seed",0));
+
+	cout<<"serving "<<s->getName()<<" on "<<path<<", connection k is seeded with "<<baseSeed<<"+k."<<endl;
+	unsigned long nClients = 0;
+	while(!stopRequested) {
+		int client = accept(listener, 0, 0);
+		if(client<0) {
+			if(errno==EINTR) continue;
+			cerr<<"Could not accept a connection: "<<strerror(errno)<<endl;
+			break;
+		}
+		cout.flush();
+		pid_t pid = fork();
+		if(pid==0) {
+			close(listener);
+			NFutil::SEED_RANDOM(baseSeed+nClients);
+			serveClient(s, client, getppid());
+			close(client);
+			_exit(0);
+		}
+		if(pid<0) cerr<<"Could not fork a process for a client."<<endl;
+		else nClients++;
+		close(client);
+	}
+
+	close(listener);
+	unlink(path.c_str());
+	cout<<"server stopped after "<<nClients<<" connections."<<endl;
+	delete s;
+	return true;
+}
+
+#else
+
+bool NFserver::serve(map<string,string> &argMap, bool verbose)
+{
+	cout<<"The -serve flag is not supported on this platform."<<endl;
+	return false;
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef NFSERVER_HH_
+#define NFSERVER_HH_
+
+
+
+#include "../NFcore/NFcore.hh"
+#include "../NFinput/NFinput.hh"
+
+
+using namespace NFcore;
+
+
+
+//!  Keeps a prepared System resident and runs commands on it sent over a socket.
+/*!
+	Started with
+
+	       ./NFsim -xml model.xml -serve /tmp/nfsim.sock [other flags]
+
+	the model is read and prepared once, a snapshot is taken, and the server
+	listens on the given unix domain socket.  Every connection is served by a
+	forked copy of the prepared System, so clients can't disturb each other,
+	many can run at once, and none of them pays for reading the model.  A client
+	that runs many short simulations should keep its connection open and reset
+	between them.
+
+	The k-th connection (counting from 0) starts with the random stream seeded
+	with base+k, where base is the -seed flag or, without it, the time the
+	server was started.  The server prints the base when it starts, and a
+	client can always choose its own seed with 'reset seed'.
+
+	Clients send one command per line.  Besides the RNF commands (set, update,
+	eq, print, echo, snapshot and reset [seed]) the server knows:
+
+	       sim [duration] [steps]   simulate, and send the observables at the
+	                                start and after each of the steps
+	       observables              send the current observables
+	       quit                     close this connection
+	       shutdown                 close this connection and stop the server
+
+	Every command gets exactly one reply, made of four 32 bit unsigned integers
+	in the byte order of the host: the status (0 if the command was run, 1 if it
+	was not understood), the number of bytes of text, and the number of rows
+	and columns of the table.  The text (whatever NFsim printed while running
+	the command) follows, then the table as rows*columns doubles.  Table rows
+	are the time followed by the observables in the order of the gdat file.
+	The text of the reply to 'observables' holds the column names.
+*/
+namespace NFserver
+{
+
+	//!  Loads the model from the -xml flag and serves it on the -serve socket.
+	bool serve(map<string,string> &argMap, bool verbose);
+
+	//!  Runs a single command for a client, filling in the text and table of the reply.
+	bool runCommand(System *s, string command, string &text, vector <double> &table,
+			unsigned int &rows, unsigned int &cols, bool &closeConnection, bool &stopServer);
+
+	static const unsigned int OK = 0;
+	static const unsigned int UNKNOWN_COMMAND = 1;
+}
+
+
+
+
+#endif /*NFSERVER_HH_*/
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <ctime>
 
 //Include stl containers
 #include <vector>
@@ -16,6 +17,8 @@
 #include <map>
 #include <algorithm>
 #include <set>
+#include <atomic>
+#include <mutex>
 // Include various NFsim classes from other files
 #include "../NFscheduler/NFstream.h"
 #include "../NFutil/NFutil.hh"
@@ -24,6 +27,9 @@
 #include "../NFfunction/NFfunction.hh"
 #include "../NFoutput/NFoutput.hh"
 #include "reactionSelector/reactionSelector.hh"
+#include "profiler.hh"
+#include "optimisticEngine.hh"
+#include "subvolumeEngine.hh"
 
 
 #include "templateMolecule.hh"
@@ -56,6 +62,8 @@ namespace NFcore
 	class MappingSet;
 	class Mapping;
 	class ReactantList;
+	class ReactantContainer;
+	struct ReactantImage;
 	class TransformationSet;
 	class MoleculeList;
 
@@ -67,6 +75,7 @@ namespace NFcore
 	class Outputter;
 	class DumpMoleculeType;
 	class DumpSystem;
+	class EnsembleStats;
 
 	class TemplateMolecule;
 	class Observable;
@@ -154,9 +163,19 @@ namespace NFcore
             // core methods of this class
 			int createComplex(Molecule * m);
 			Complex * getComplex(int ID_complex) const { return allComplexes.at(ID_complex); };
+			int getNumOfComplexes() const { return allComplexes.size(); };
 			Complex * getNextAvailableComplex();
 			void notifyThatComplexIsAvailable(int ID_complex);
 
+			// while set, complexes are handed out and given back under a lock, so that
+			// events on several threads can bind and unbind at once (see OptimisticEngine)
+			void setConcurrent(bool _concurrent) { concurrent = _concurrent; }
+
+			// copy the members of every complex and the queue of available complexes
+			// out and back in, see System::snapshot() and System::restore()
+			void saveImage(vector < vector <Molecule *> > &members, vector <int> &available);
+			void restoreImage(const vector < vector <Molecule *> > &members, const vector <int> &available);
+
 			// output and printing
 			void printAllComplexes();
 			void purgeAndPrintAvailableComplexList(); /*< ONLY USE FOR DEBUG PURPOSES, AS THIS DELETES ALL COMPLEX BOOKKEEPING */
@@ -179,6 +198,8 @@ namespace NFcore
 
 			System * sys;                             /* pointer to the system which this ComplexList belongs to */
 			bool useComplex;                          /* true if the system is tracking complexes */
+			bool concurrent;                          /* true if several threads take complexes at once */
+			mutex availableMutex;                     /* guards nextAvailableComplex while concurrent */
 
 		private:
 			vector <Complex *>::iterator  complexIter;         /* to iterate over allComplexes */
@@ -208,6 +229,11 @@ namespace NFcore
 		// needs access to protected elements of System.
 		friend class Netgen;
 
+		// The optimistic and subvolume engines run events themselves, and put the
+		// reactant lists and observables back together when they are done
+		friend class OptimisticEngine;
+		friend class SubvolumeEngine;
+
 		public:
 
 			/*!
@@ -246,6 +272,7 @@ namespace NFcore
 
 			ReactionClass *getReaction(int rIndex) { return allReactions.at(rIndex); };
 			vector <ReactionClass *> getAllReactions () { return allReactions; };
+			int getNumOfReactions() const { return allReactions.size(); };
 			ReactionClass * getReactionByName(string name);
 
 			MoleculeType * getMoleculeType(int mtIndex) { return allMoleculeTypes.at(mtIndex); };
@@ -314,6 +341,9 @@ namespace NFcore
 			void setDumpOutputter(DumpSystem *ds);
 			void tryToDump();
 
+			/* fold every line of observable output into the statistics of a replicate ensemble */
+			void setEnsembleStats(EnsembleStats *es);
+
 			void turnOnGlobalFuncOut() { this->outputGlobalFunctionValues=true; };
 			void turnOffGlobalFuncOut() { this->outputGlobalFunctionValues=false; };
 
@@ -333,8 +363,14 @@ namespace NFcore
 			void outputAllObservableCounts(double cSampleTime,int eventCounter);
 			void outputAllMoleculeTypes();
 			void outputAllRxnFiringCounts();
+			/* writes the molecule type and firing count files if they were asked for, and
+			 * prints the number of events of a run that started at the given clock() and
+			 * the CPU time it took.  Shared by sim() and the engines, so they report alike */
+			void printRunSummary(unsigned long long iteration, clock_t start, bool verbose);
 			int getNumOfSpeciesObs() const;
 			Observable * getSpeciesObs(int index) const;
+			int getNumOfOnTheFlySpeciesObs() const { return (int)onTheFlySpeciesObservables.size(); };
+			Observable * getOnTheFlySpeciesObs(int index) const { return onTheFlySpeciesObservables[index]; };
 
 			/* functions that print out other information to the console */
 			// NETGEN
@@ -400,11 +436,24 @@ namespace NFcore
 			int getRxnIndex(int rxnId, int rxnPos) const { return rxnIndexMap[rxnId][rxnPos]; };
 
 			void turnOff_OnTheFlyObs();
+			void refreshObservables(); /* recounts the observables that are not updated on the fly */
+			void chooseOnTheFlyObservables();
+			void keepOnTheFly(Observable *o);
+			/* counts the changes to which observables are on the fly, so that what was
+			 * recorded about them (see SpeciesCreator) can tell when it is out of date */
+			unsigned int getOnTheFlyVersion() const { return onTheFlyVersion; };
+			/* observables are recounted, and species saved, on up to this many
+			 * threads, see MoleculeType::addAllToObservables() */
+			void setObservableThreads(int nThreads) { observableThreads = nThreads<1 ? 1 : nThreads; };
+			int getObservableThreads() const { return observableThreads; };
+			int getNumOfObservables() const { return obsToOutput.size(); };
+			Observable * getObservable(int obsIndex) const { return obsToOutput.at(obsIndex); };
 			void turnOnOutputEventCounter() { outputEventCounter=true; };
 			int getGlobalEventCounter() { return globalEventCounter; };
 
 			void addParameter(string name,double value);
 			double getParameter(string name);
+			bool hasParameter(string name) const { return paramMap.find(name)!=paramMap.end(); };
 			void setParameter(string name, double value);
 			void updateSystemWithNewParameters();
 			void printAllParameters();
@@ -420,7 +469,7 @@ namespace NFcore
 			/*! keeps track of null events (ie binding events that have
 			    been rejected because molecules are on the same complex)
 			 */
-			static int NULL_EVENT_COUNTER;
+			static thread_local int NULL_EVENT_COUNTER;
 
 			/*!
 				turns on csv format, so that instead of a gdat file, a comma delimited
@@ -465,6 +514,57 @@ namespace NFcore
 
 			void setMaxCpuTime(double time) { max_cpu_time = time; };
 
+			/* Stop a call to sim() after a fixed number of events, so that
+			 * benchmark runs with a fixed seed do identical work.  A value
+			 * of zero or less means no limit.
+			 */
+			void setMaxEvents(long long events) { max_events = events; };
+			long long getMaxEvents() const { return max_events; };
+
+			/* Print (and write to the given file, if it is not empty) the bytes
+			 * and object counts used by molecules, reactant lists, complexes,
+			 * the connectivity maps and the log buffers.  Once turned on, the
+			 * report is made when the system is prepared and at each output step.
+			 */
+			void turnOnMemoryReport(string filename);
+			void outputMemoryReport(string when, double time);
+
+			/* Keep a compact image of the current molecules, bonds, time and
+			 * firing counts in memory, and later put the system back into that
+			 * state without reading the model again.  The snapshot can only be
+			 * taken once the system is prepared for simulation.  restore()
+			 * returns false if no snapshot was taken.
+			 */
+			void snapshot();
+			bool restore();
+			bool hasSnapshot() const { return image.taken; };
+
+			/* Split the model into independent subsystems: sets of molecule types and
+			 * reactions that never share a molecule, neither directly nor through an
+			 * observable or a function that a rate reads.  This is done when the system
+			 * is prepared, unless it was called before.  Molecule types that no reaction
+			 * changes, and the observables of those types only, belong to no subsystem
+			 * (-1), as do functions that only read such observables.
+			 */
+			void findIndependentSubsystems();
+			int getNumOfSubsystems() const { return n_subsystems; };
+			int getSubsystemOfReaction(int rIndex) const { return subsystemOfReaction.at(rIndex); };
+			int getSubsystemOfObservable(int obsIndex) const { return subsystemOfObservable.at(obsIndex); };
+
+			/* Only simulate the given subsystem from here on.  The reactions of the other
+			 * subsystems are taken out of the selector and their molecules are no longer
+			 * counted, so that the observables of this subsystem are exact and the others
+			 * are not to be read.  The system has to be prepared first.
+			 */
+			void restrictToSubsystem(int subsystem);
+			/* advance a restricted system to the sample time and count its observables there */
+			void sampleSubsystem(double sampleTime);
+			/* write one line of output, with each observable taken from the system that
+			 * simulated its subsystem (the first for those in no subsystem).  The systems
+			 * must all have been read from the same model as this one.
+			 */
+			void outputSubsystemCounts(double cSampleTime, vector <System *> &subsystemSystems);
+
 			clock_t start,finish;
 			double current_cpu_time = 0;
 
@@ -541,6 +641,10 @@ namespace NFcore
 
 			vector <Observable *> obsToOutput; /*!< keeps ordered list of pointers to observables for output */
 			vector <Observable *> speciesObservables;
+			vector <Observable *> onTheFlySpeciesObservables; /*!< the species observables that events update */
+			bool anyLazyObservables; /*!< true if some observables are only counted for output */
+			unsigned int onTheFlyVersion; /*!< see getOnTheFlyVersion() */
+			int observableThreads; /*!< how many threads recount observables at output steps */
 
 			DumpSystem *ds;
 
@@ -562,6 +666,8 @@ namespace NFcore
 			ReactionClass * nextReaction;  /*< keeps track of the next reaction to fire */
 			// max CPU time for simulation
 			double max_cpu_time;
+			// max number of events for a single call to sim()
+			long long max_events;
 
 			///////////////////////////////////////////////////////////////////////////
 			// protected functions needed only by the system while running a simulation
@@ -606,6 +712,55 @@ namespace NFcore
 
 			// AS2023 - sets the default log buffer size to 10000 firings.
 			int log_buffer_size = 10000;
+			// reaction firing log that has not yet been written out
+			string rxnLogBuffer;
+
+			// memory accounting report, see turnOnMemoryReport()
+			bool memoryReport = false;
+			ofstream memoryReportStream;
+
+			// ensemble statistics over replicates, see setEnsembleStats()
+			EnsembleStats *ensembleStats = 0;
+			unsigned int ensembleSample = 0;
+
+			// in-memory image of the system state, see snapshot() and restore()
+			struct StateImage {
+				bool taken = false;
+				double time = 0;
+				int eventCounter = 0;
+				vector < vector <int> > listIds;   /* list ids of the molecules of each type, in list order */
+				vector <int> nLive;                 /* how many molecules of each type were live */
+				vector <int> populations;           /* population count of each live molecule */
+				vector <int> states;                /* component states of each live molecule */
+				vector <Molecule *> bondMolecule;   /* per component, the partner or 0 */
+				vector <int> bondSite;              /* per component, the component index of the partner */
+				vector <int> obsMatches;            /* per live molecule, its matches to each observable of its type */
+				vector <double> localFunctionValues;/* per live molecule, the values of its local functions */
+				vector <int> rxnMemberships;        /* per live molecule and reaction of its type, the number of
+				                                       MappingSet ids it has there, followed by the ids */
+				vector < vector <Molecule *> > complexMembers;
+				vector <int> availableComplexes;
+				vector <ReactantContainer *> containers; /* every reactant list and tree of the reactions */
+				vector <ReactantImage> reactants;        /* and what each of them held */
+				vector <int> obsCounts;             /* molecule observables by type, then species observables */
+				vector <double> propensities;       /* a of each reaction */
+				double aTot = 0;
+				vector <unsigned int> fireCounts;   /* number of times each reaction fired */
+			} image;
+
+			// independent subsystems, see findIndependentSubsystems()
+			bool subsystemsFound = false;
+			int n_subsystems = 0;
+			vector <int> subsystemOfMoleculeType;
+			vector <int> subsystemOfReaction;
+			vector <int> subsystemOfObservable;
+			int restrictedSubsystem = -1;     /* the only subsystem simulated, see restrictToSubsystem() */
+			bool isCountedInSubsystem(int mtIndex) const {
+				return restrictedSubsystem<0 || subsystemOfMoleculeType[mtIndex]<0 || subsystemOfMoleculeType[mtIndex]==restrictedSubsystem; };
+
+			void writeObservableCounts(double cSampleTime, int eventCounter);
+			void countSpeciesObservables();
+			void addComplexesToSpeciesObservables(vector <Observable *> &obs);
 
 		private:
 			list <Molecule *> molList;
@@ -743,12 +898,40 @@ namespace NFcore
 
 
 			void addAllToObservables();
+			/* counts the molecules of this type in the observables that are not kept
+			 * up to date on the fly, see Observable::isOnTheFly() */
+			void addAllToLazyObservables();
+			/* counts the molecules of this type in the given observables, on as many
+			 * threads as the system allows, and with rememberMatches also sets which
+			 * molecules matched, as addAllToObservables() does */
+			void addAllToObservables(const vector <int> &obsIndex, bool rememberMatches);
+			/* counts the molecules of this type in one observable and remembers which
+			 * of them matched, so that events can update it from then on */
+			void addAllToObservable(MoleculesObservable *obs);
+
+			/* packs the states of a molecule into one word, each component in a field
+			 * just wide enough for its possible states, and which of its sites are bound
+			 * into another, so that templates of a single molecule can be checked with a
+			 * few masks (see TemplateMolecule::compareSignature).  Returns false if the
+			 * type has too many components or states for this, or if a state is out of
+			 * the range of its field */
+			bool packState(Molecule *m, unsigned long long &stateWord, unsigned long long &bondWord) const;
+			bool canPackState() const { return packable; };
+			int getStateFieldOffset(int cIndex) const { return stateFieldOffset[cIndex]; };
+			int getStateFieldBits(int cIndex) const { return stateFieldBits[cIndex]; };
+
+			/* gives every template of this type a pattern id, the same one for
+			 * templates that ask for exactly the same states and bonds of a single
+			 * molecule (see TemplateMolecule::getSignatureKey), so that a match found
+			 * for one of them during an event is used for all of them */
+			void findSamePatterns();
 
 
 			//function to access particular molecules or reactions (these are really only
 			//used when debugging or running the walker...
 			Molecule * getMolecule(int ID_molecule) const;
 			int getMoleculeCount() const;
+			MoleculeList * getMoleculeList() const { return mList; };
 
 			int getReactionCount() const { return reactions.size(); };
 			int getRxnIndex(ReactionClass * rxn, int rxnPosition);
@@ -761,6 +944,12 @@ namespace NFcore
 
 			void addMoleculeToRunningSystem(Molecule *&mol);
 			void addMoleculeToRunningSystemButDontUpdate(Molecule *&mol);
+
+			//Adds a molecule whose matches are already known: it is counted in the observables
+			//as given by obsMatches, and only the reactions listed in rxnMembership (indices
+			//into this type's reactions) are tried.  getRunningSystemMembership() records both.
+			void addMoleculeToRunningSystem(Molecule *&mol, vector <int> &rxnMembership, vector <int> &obsMatches);
+			void getRunningSystemMembership(Molecule *mol, vector <int> &rxnMembership, vector <int> &obsMatches);
 			void removeMoleculeFromRunningSystem(Molecule *&m);
 			void removeMoleculeFromRunningSystemButDontUpdate(Molecule *&m);
 			void removeFromRxns(Molecule * m);
@@ -862,6 +1051,11 @@ namespace NFcore
 			bool *isIntegerCompState;
 			const bool population_type;
 
+			//layout of the packed states, see packState()
+			bool packable;
+			int *stateFieldOffset;
+			int *stateFieldBits;
+
 
 			//set of variables to keep track of equivalent (aka symmetric) components
 			int n_eqComp;
@@ -957,6 +1151,12 @@ namespace NFcore
 			void setComponentState(int cIndex, int newValue);
 			void setComponentState(string cName, int newValue);
 
+			/* approximate heap footprint of this molecule, for the -memreport option.  The
+			 * per-reaction membership sets are reported separately, together with the total
+			 * number of entries in them */
+			unsigned long getMemoryUsage() const;
+			unsigned long getRxnMembershipMemoryUsage(unsigned long &n_entries) const;
+
 			///////////// local function methods...
 			void setLocalFunctionValue(double newValue,int localFunctionIndex);
 			double getLocalFunctionValue(int localFunctionIndex);
@@ -977,7 +1177,7 @@ namespace NFcore
 				return (rxnListMappingId2[rxnIndex].size() > 0) ? *rxnListMappingId2[rxnIndex].begin() : -1;  //JJT: changing to handle multiple mappings per reaction
 			};
 
-			set<int> getRxnListMappingSet(int rxnIndex){
+			const set<int> & getRxnListMappingSet(int rxnIndex) const {
 
 				return rxnListMappingId2[rxnIndex];
 			}
@@ -1006,6 +1206,10 @@ namespace NFcore
 			void setBondTo(Molecule * m2, int bindingSiteIndex);
 			void moveToNewComplex(int newComplexID) { ID_complex = newComplexID; };
 
+			/* sets one end of a bond, or clears it if partner is 0, without touching the
+			 * partner or the complexes; only for System::restore(), which sets both ends */
+			void restoreBond(int cIndex, Molecule *partner, int partnerIndex);
+
 
 			/* static functions which bind and unbind two molecules */
 			static void bind(Molecule *m1, int cIndex1, Molecule *m2, int cIndex2);
@@ -1030,6 +1234,12 @@ namespace NFcore
 			 * so that this molecule can add itself to all the necessary lists */
 			void prepareForSimulation();
 
+			/* gets a molecule that was removed from the simulation ready to be handed out
+			 * again.  Only what a previous life could have changed is reset: the states
+			 * go back to their defaults, stray bonds are cleared and the reaction and
+			 * observable memberships are emptied in place, without reallocating them */
+			void recycle();
+
 			/* function that tells this molecule that it changed states or bonds
 			 * and it should update its reaction membership */
 			void updateRxnMembership(ReactionClass * r, bool useConnectivity);
@@ -1097,7 +1307,7 @@ namespace NFcore
 			int ID_unique;
 			int listId;
 
-			static int uniqueIdCount;
+			static atomic <int> uniqueIdCount;
 
 			/* The type of this molecule */
 			MoleculeType *parentMoleculeType;
@@ -1140,9 +1350,11 @@ namespace NFcore
 
 		private:
 
-			static queue <Molecule *> q;
-			static queue <int> d;
-			static list <Molecule *>::iterator molIter;
+			// scratch space for the traversals, one per thread so that separate
+			// Systems can be run side by side
+			static thread_local queue <Molecule *> q;
+			static thread_local queue <int> d;
+			static thread_local list <Molecule *>::iterator molIter;
 
 	};
 
@@ -1180,6 +1392,8 @@ namespace NFcore
 		// _NETGEN_
 		friend class MatchSetIter;
 		friend class Netgen;
+		friend class OptimisticEngine;
+		friend class SubvolumeEngine;
 
 		public:
 			static const int NO_LIMIT = -3;
@@ -1188,7 +1402,7 @@ namespace NFcore
 			static const int DOR_RXN = 1;
 			static const int OBS_DEPENDENT_RXN = 2;
 			static const int POP_RXN = 3;  // deprecated
-			static const int DOR2_RXN = 4;
+			static const int DORN_RXN = 4;
 
 
 
@@ -1199,11 +1413,14 @@ namespace NFcore
 			//! @author Arvind Rasi Subramaniam
 			void setAllReactantAndProductTemplates(map <string,TemplateMolecule *> reactants,
 					map <string,TemplateMolecule *> products);
+			const vector <TemplateMolecule *> & getAllReactantTemplates() const { return allReactantTemplates; };
+			const vector <TemplateMolecule *> & getAllProductTemplates() const { return allProductTemplates; };
 
 			int getNumOfReactants() const { return n_reactants; };
 
 			string getName() const { return name; };
 			int getFireCounter() const { return fireCounter; };
+			void setFireCounter(unsigned int count) { fireCounter = count; };
 			double getBaseRate() const { return baseRate; };
 			int getRxnType() const { return reactionType; };
 
@@ -1214,6 +1431,7 @@ namespace NFcore
 			void setTraversalLimit(int limit) { this->traversalLimit = limit; };
 
 			double get_a() const { return a; };
+			void restore_a(double a) { this->a = a; };  /* only for System::restore() */
 			virtual void printDetails() const;
 			void fire(double random_A_number);
 			// AS2023 - additional call sig to use with reaction firing tracking. The call
@@ -1224,8 +1442,8 @@ namespace NFcore
 			virtual void notifyRateFactorChange(Molecule * m, int reactantIndex, int rxnListIndex) = 0;
 			virtual int getDORreactantPosition() const { cerr<<"Trying to get DOR reactant Position from a reaction that is not of type DOR!"<<endl;
 															cerr<<"this is an internal error, and so I will quit."<<endl; exit(1); return -1; };
-			virtual int getDORreactantPosition2() const { cerr<<"Trying to get DOR reactant Position2 from a reaction that is not of type DOR2!"<<endl;
-															cerr<<"this is an internal error, and so I will quit."<<endl; exit(1); return -1; };
+			//true if local functions are evaluated on the reactant at this position
+			virtual bool isDORreactant(int rPosition) const { return false; };
 
 
 			//The main virtual functions that must be implemented in all implementing classes
@@ -1274,6 +1492,10 @@ namespace NFcore
 			void appendPreConnectedRxn(ReactionClass * rxn);
 			bool isReactionConnected(ReactionClass * rxn);
 			int getNumConnectedRxns() {return connectedReactions.size();};
+			unsigned long getConnectedRxnMemoryUsage() const { return connectedReactions.capacity()*sizeof(ReactionClass *); };
+
+			//! The ReactantList or ReactantTree that holds the given reactant, if there is one
+			virtual ReactantContainer * getReactantContainer(unsigned int reactantIndex) const { return 0; };
 			ReactionClass * getconnectedRxn(int rxn2_id) {return connectedReactions.at(rxn2_id);};
 
 			// Methods to identify connected reactions within NFsim
@@ -1398,6 +1620,8 @@ namespace NFcore
 
 
 			void refactorToNewComplex(int new_ID_complex);
+			void resetToSingleton(Molecule * m);
+			void clearMembers();
 
 			void emptyComplexForever() {};
 
@@ -1411,11 +1635,12 @@ namespace NFcore
 			void printDetails();
 			void printDetailsLong();
 
-			//Diffusion functions
-			double getDistance(Complex * c) {return 1000.0; };
-			double getXpos() { return 0; };
-			double getYpos() { return 0; };
-			double getZpos() { return 0; };
+			//Diffusion functions, the position is set by the SubvolumeEngine
+			void setPosition(double x, double y, double z) { xPos = x; yPos = y; zPos = z; };
+			double getDistance(Complex * c);
+			double getXpos() { return xPos; };
+			double getYpos() { return yPos; };
+			double getZpos() { return zPos; };
 
 			// get canonical label
 			string getCanonicalLabel ( );
@@ -1424,6 +1649,9 @@ namespace NFcore
 			// unset canonical flag
 			void unsetCanonical ( ) { is_canonical = false; };
 
+			// approximate heap footprint of this complex, for the -memreport option
+			unsigned long getMemoryUsage() const;
+
 			//This is public so that anybody can access the molecules quickly
 			list <Molecule *> complexMembers;
 			list <Molecule *>::iterator molIter;
@@ -1436,6 +1664,7 @@ namespace NFcore
 
 			System * system;
 			int ID_complex;
+			double xPos, yPos, zPos;
 
 			bool    is_canonical;
 			string  canonical_label;
@@ -18,12 +18,19 @@ Complex::Complex(System * s, int ID_complex, Molecule * m)
 	this->system = s;
 	this->ID_complex = ID_complex;
 	this->complexMembers.push_back(m);
+	this->xPos = this->yPos = this->zPos = 0;
 }
 
 Complex::~Complex()
 {
 }
 
+double Complex::getDistance(Complex * c)
+{
+	double dx = xPos-c->xPos, dy = yPos-c->yPos, dz = zPos-c->zPos;
+	return sqrt(dx*dx+dy*dy+dz*dz);
+}
+
 bool Complex::isAlive() {
 	if(complexMembers.size()==0) return false;
 	return (*complexMembers.begin())->isAlive();
@@ -101,6 +108,20 @@ void Complex::refactorToNewComplex(int new_ID_complex)
   		(*molIter)->moveToNewComplex(new_ID_complex);
 }
 
+void Complex::clearMembers()
+{
+	complexMembers.clear();
+	unsetCanonical();
+}
+
+/* puts a single molecule back into this complex, dropping any old members */
+void Complex::resetToSingleton(Molecule * m)
+{
+	clearMembers();
+	complexMembers.push_back(m);
+	m->moveToNewComplex(ID_complex);
+}
+
 /* for binding, we want to merge a new complex, c, with our complex, this */
 void Complex::mergeWithList(Complex * c)
 {
@@ -197,6 +218,15 @@ string Complex::getCanonicalLabel ( )
 }
 
 
+unsigned long Complex::getMemoryUsage() const
+{
+	// a std::list node holds the value and the two links
+	return sizeof(Complex)
+		+ complexMembers.size()*(sizeof(Molecule *) + 2*sizeof(void *))
+		+ canonical_label.capacity();
+}
+
+
 // generate a canonical label
 /*  1) construct a Nauty sparse graph representation of the complex.
     2) call Nauty to get canonical node order.
@@ -21,6 +21,7 @@ ComplexList::ComplexList( )
 {
 	sys = 0;
 	useComplex = false;
+	concurrent = false;
 }
 
 
@@ -59,8 +60,10 @@ int ComplexList::createComplex(Molecule * m)
 //  on the queue (so long as we stick to the rule of: create new complex every time a new molecule is instantiated.
 Complex * ComplexList::getNextAvailableComplex()
 {
+	if(concurrent) availableMutex.lock();
 	Complex * c = allComplexes.at(nextAvailableComplex.front());
 	nextAvailableComplex.pop();
+	if(concurrent) availableMutex.unlock();
 	return c;
 }
 
@@ -68,7 +71,9 @@ Complex * ComplexList::getNextAvailableComplex()
 
 void ComplexList::notifyThatComplexIsAvailable(int ID_complex)
 {
+	if(concurrent) availableMutex.lock();
 	nextAvailableComplex.push(ID_complex);
+	if(concurrent) availableMutex.unlock();
 }
 
 
@@ -76,6 +81,50 @@ void ComplexList::notifyThatComplexIsAvailable(int ID_complex)
 
 
 
+// Copies the members of every complex, in order, and the queue of complexes that
+// are free to be handed out.
+void ComplexList::saveImage(vector < vector <Molecule *> > &members, vector <int> &available)
+{
+	members.clear();
+	available.clear();
+	if (!useComplex) return;
+	members.resize(allComplexes.size());
+	for( unsigned int c=0; c<allComplexes.size(); c++ )
+		members[c].assign(allComplexes[c]->complexMembers.begin(), allComplexes[c]->complexMembers.end());
+	for( unsigned int k=0; k<nextAvailableComplex.size(); k++ )
+	{
+		available.push_back(nextAvailableComplex.front());
+		nextAvailableComplex.push(nextAvailableComplex.front());
+		nextAvailableComplex.pop();
+	}
+}
+
+
+// Puts the members and the queue back.  Complexes made since the image are left
+// empty; they belong to molecules that were made since, which System::restore()
+// gives back their complex.
+void ComplexList::restoreImage(const vector < vector <Molecule *> > &members, const vector <int> &available)
+{
+	if (!useComplex) return;
+	for( unsigned int c=0; c<allComplexes.size(); c++ )
+	{
+		Complex * complex = allComplexes[c];
+		complex->clearMembers();
+		if( c>=members.size() ) continue;
+		for( unsigned int k=0; k<members[c].size(); k++ )
+		{
+			complex->complexMembers.push_back(members[c][k]);
+			members[c][k]->moveToNewComplex(c);
+		}
+	}
+	while( !nextAvailableComplex.empty() )
+		nextAvailableComplex.pop();
+	for( unsigned int k=0; k<available.size(); k++ )
+		nextAvailableComplex.push(available[k]);
+}
+
+
+
 void ComplexList::purgeAndPrintAvailableComplexList()
 {
 	cout << "AvailableComplexes:";
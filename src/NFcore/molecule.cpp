@@ -6,7 +6,7 @@
 using namespace std;
 using namespace NFcore;
 
-int Molecule::uniqueIdCount = 0;
+atomic <int> Molecule::uniqueIdCount(0);
 
 
 
@@ -102,11 +102,39 @@ void Molecule::prepareForSimulation()
 
 
 
+void Molecule::recycle()
+{
+	// a molecule that never entered the simulation is still as it was constructed
+	if(!isPrepared) return;
+
+	population_count = ( parentMoleculeType->isPopulationType()  ?  0  :  1 );
+	for(int c=0; c<numOfComponents; c++) {
+		int defaultState = parentMoleculeType->getDefaultComponentState(c);
+		if(component[c]!=defaultState) component[c] = defaultState;
+		if(bond[c]!=0) { bond[c]=0; indexOfBond[c]=NOBOND; }
+		hasVisitedBond[c] = false;
+	}
+	hasVisitedMolecule = false;
+	hasEvaluatedMolecule = false;
+	isMatchedTo = 0;
+
+	// removing the molecule from its reactions normally empties these already
+	for(int r=0; r<nReactions; r++)
+		if(!rxnListMappingId2[r].empty()) rxnListMappingId2[r].clear();
+	for(int o=0; o<parentMoleculeType->getNumOfMolObs(); o++)
+		isObservable[o]=0;
+	for(int lf=0; localFunctionValues!=0 && lf<parentMoleculeType->getNumOfTypeIFunctions(); lf++)
+		localFunctionValues[lf]=0;
+}
+
+
 void Molecule::setUpLocalFunctionList()
 {
 	if (parentMoleculeType->getNumOfTypeIFunctions() > 0)
 	{
-		localFunctionValues=new double[parentMoleculeType->getNumOfTypeIFunctions()];
+		// a recycled molecule keeps the array it had
+		if(localFunctionValues==0)
+			localFunctionValues=new double[parentMoleculeType->getNumOfTypeIFunctions()];
 		for(int lf=0; lf<parentMoleculeType->getNumOfTypeIFunctions(); lf++) {
 			localFunctionValues[lf]=0;
 		}
@@ -338,6 +366,33 @@ void Molecule::setComponentState(string cName, int newValue) {
 }
 
 
+unsigned long Molecule::getMemoryUsage() const
+{
+	unsigned long bytes = sizeof(Molecule);
+	bytes += numOfComponents*(sizeof(int) + sizeof(Molecule *) + sizeof(int) + sizeof(bool));
+	if(localFunctionValues!=0)
+		bytes += parentMoleculeType->getNumOfTypeIFunctions()*sizeof(double);
+	if(isPrepared)
+		bytes += parentMoleculeType->getNumOfMolObs()*sizeof(int);
+	return bytes;
+}
+
+
+unsigned long Molecule::getRxnMembershipMemoryUsage(unsigned long &n_entries) const
+{
+	n_entries = 0;
+	if(!isPrepared) return 0;
+
+	// each entry of a std::set is a red-black tree node: three pointers and
+	// a colour flag, followed by the value
+	const unsigned long nodeBytes = 4*sizeof(void *) + sizeof(int);
+	unsigned long bytes = nReactions*sizeof(set<int>);
+	for(int r=0; r<nReactions; r++)
+		n_entries += rxnListMappingId2[r].size();
+	return bytes + n_entries*nodeBytes;
+}
+
+
 void Molecule::printDetails() {
 	this->printDetails(cout);
 }
@@ -510,6 +565,12 @@ int Molecule::getBondedMoleculeBindingSiteIndex(int cIndex) const
 
 
 
+void Molecule::restoreBond(int cIndex, Molecule *partner, int partnerIndex)
+{
+	bond[cIndex]=partner;
+	indexOfBond[cIndex]=(partner==0) ? NOINDEX : partnerIndex;
+}
+
 void Molecule::bind(Molecule *m1, int cIndex1, Molecule *m2, int cIndex2)
 {
 	if(m1->bond[cIndex1]!=nullptr || m2->bond[cIndex2]!=nullptr) {
@@ -613,9 +674,9 @@ vector<int> Molecule::unbind(Molecule *m1, char * compName)
 
 
 
-queue <Molecule *> Molecule::q;
-queue <int> Molecule::d;
-list <Molecule *>::iterator Molecule::molIter;
+thread_local queue <Molecule *> Molecule::q;
+thread_local queue <int> Molecule::d;
+thread_local list <Molecule *>::iterator Molecule::molIter;
 void Molecule::breadthFirstSearch(list <Molecule *> &members, Molecule *m, int depth)
 {
 	if(m==0) {
@@ -638,6 +699,7 @@ void Molecule::breadthFirstSearch(list <Molecule *> &members, Molecule *m, int d
 	members.push_back(m);
 	d.push(currentDepth+1);
 	m->hasVisitedMolecule=true;
+	NF_PROFILE_BFS_BEGIN(visited);
 
 	//Look at children until the queue is empty
 	while(!q.empty())
@@ -667,11 +729,13 @@ void Molecule::breadthFirstSearch(list <Molecule *> &members, Molecule *m, int d
 					members.push_back(neighbor);
 					q.push(neighbor);
 					d.push(currentDepth+1);
+					NF_PROFILE_BFS_VISIT(visited);
 					//cout<<"adding... to traversal list."<<endl;
 				}
 			}
 		}
 	}
+	NF_PROFILE_BFS_END(visited);
 
 
 	//clear the has visitedMolecule values
@@ -702,6 +766,7 @@ void Molecule::breadthFirstSearch(list <Molecule *> &members, Molecule *m, int d
 	members.push_back(m);
 	d.push(currentDepth+1);
 	m->hasVisitedMolecule=true;
+	NF_PROFILE_BFS_BEGIN(visited);
 
 	//Look at children until the queue is empty
 	while(!q.empty())
@@ -735,11 +800,13 @@ void Molecule::breadthFirstSearch(list <Molecule *> &members, Molecule *m, int d
 					members.push_back(neighbor);
 					q.push(neighbor);
 					d.push(currentDepth+1);
+					NF_PROFILE_BFS_VISIT(visited);
 					//cout<<"adding... to traversal list."<<endl;
 				}
 			}
 		}
 	}
+	NF_PROFILE_BFS_END(visited);
 
 
 	//clear the has visitedMolecule values
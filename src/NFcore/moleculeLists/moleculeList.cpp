@@ -162,6 +162,49 @@ void MoleculeList::removeLast()
 
 
 
+unsigned long MoleculeList::getMemoryUsage() const
+{
+	return sizeof(MoleculeList) + capacity*(sizeof(Molecule *) + sizeof(int));
+}
+
+
+void MoleculeList::getOrder(vector <int> &listIds) const
+{
+	listIds.resize(capacity);
+	for(int i=0; i<capacity; i++)
+		listIds[i] = mArray[i]->getMolListId();
+}
+
+
+void MoleculeList::restoreOrder(const vector <int> &listIds, int nLive)
+{
+	if((int)listIds.size()>capacity || nLive>(int)listIds.size()) {
+		cerr<<"Error in MoleculeList: cannot restore an order of "<<listIds.size()<<" molecules";
+		cerr<<" onto a list of type '"<<mt->getName()<<"' with capacity "<<capacity<<"."<<endl;
+		exit(1);
+	}
+
+	// list ids are handed out as 0..capacity-1 when the Molecules are allocated,
+	// so any later order is a permutation of them
+	Molecule ** byId = new Molecule * [capacity];
+	for(int i=0; i<capacity; i++)
+		byId[mArray[i]->getMolListId()] = mArray[i];
+
+	int pos = 0;
+	for(unsigned int i=0; i<listIds.size(); i++, pos++) {
+		mArray[pos] = byId[listIds[i]];
+		molPos[listIds[i]] = pos;
+	}
+	for(int id=listIds.size(); id<capacity; id++, pos++) {
+		mArray[pos] = byId[id];
+		molPos[id] = pos;
+	}
+	delete [] byId;
+
+	n_molecules = nLive;
+}
+
+
 void MoleculeList::printDetails()
 {
 	//Used for debuggin'...
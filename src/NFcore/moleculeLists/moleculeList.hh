@@ -51,7 +51,9 @@ namespace NFcore
 				Allocates a spot for a new Molecule in the system.  The given
 				pointer is assigned to the new Molecule (so it should be passed
 				in as a null pointer) and the method returns the index this
-				Molecule was assigned.
+				Molecule was assigned.  Removed Molecules are kept just past the
+				live ones, so this hands back the one that was removed last, which
+				works as a pool of recycled molecules that are still in the cache.
 			*/
 			int create(Molecule *&m);
 
@@ -71,6 +73,27 @@ namespace NFcore
 			*/
 			void printDetails();
 
+			/*!
+				Returns the number of Molecule objects allocated by this list, which
+				includes the ones that are not currently alive.
+			*/
+			int getCapacity() const { return capacity; };
+
+			/*!
+				Returns the bytes used by the arrays of this list (but not by the
+				Molecule objects themselves).
+			*/
+			unsigned long getMemoryUsage() const;
+
+			/*!
+				Gets the list ids of all Molecules in the order they sit on the list,
+				live ones first, and puts the list back into that order with the first
+				nLive of them live.  Molecules allocated after the order was taken go
+				after the given ones.  Used to snapshot and restore a System.
+			*/
+			void getOrder(vector <int> &listIds) const;
+			void restoreOrder(const vector <int> &listIds, int nLive);
+
 			static const int NO_LIMIT = -1;
 
 		protected:
@@ -6,6 +6,10 @@ using namespace std;
 using namespace NFcore;
 
 
+//Fewer molecules than this are not worth starting another thread for
+static const int MIN_MOLECULES_PER_THREAD = 10000;
+
+
 
 
 MoleculeType::MoleculeType(
@@ -144,6 +148,19 @@ void MoleculeType::init(
 		this->possibleCompStates.push_back(p);
 	}
 
+	//Lay out the fields of the packed states, each wide enough for the possible states
+	this->stateFieldOffset = new int [numOfComponents];
+	this->stateFieldBits = new int [numOfComponents];
+	int offset = 0;
+	for(int c=0; c<numOfComponents; c++) {
+		int bits = 0;
+		while((1<<bits) < (int)possibleCompStates.at(c).size()) bits++;
+		stateFieldOffset[c] = offset;
+		stateFieldBits[c] = bits;
+		offset += bits;
+	}
+	this->packable = (numOfComponents<=64 && offset<=64);
+
 
 	//Register myself with the system, and get an ID number
 	this->system = system;
@@ -167,6 +184,8 @@ MoleculeType::~MoleculeType()
 	delete [] compName;
 	delete [] defaultCompState;
 	delete [] isIntegerCompState;
+	delete [] stateFieldOffset;
+	delete [] stateFieldBits;
 
 	//Delete details about equivalent components
 	delete [] eqCompSizes;
@@ -323,8 +342,11 @@ string MoleculeType::getComponentStateName(int cIndex, int cValue) {
 
 Molecule *MoleculeType::genDefaultMolecule()
 {
+	// the list hands back the molecule that was removed last, if there is one,
+	// which is still warm in the cache; it only needs its old life wiped
 	Molecule *m;
 	mList->create(m);
+	m->recycle();
 	m->setAlive(true);
 	//cout<<"adding molecule: "<<m->getMoleculeTypeName()<<"_"<<m->getUniqueID()<<endl;
 
@@ -345,6 +367,41 @@ void MoleculeType::addMoleculeToRunningSystem(Molecule *&mol)
 }
 
 
+void MoleculeType::addMoleculeToRunningSystem(Molecule *&mol, vector <int> &rxnMembership, vector <int> &obsMatches)
+{
+	mol->setUpLocalFunctionList();
+	mol->prepareForSimulation();
+	mol->setAlive(true);
+
+	for(unsigned int o=0; o<obsMatches.size(); o++) {
+		mol->setIsObs(o,obsMatches[o]);
+		molObs.at(o)->add(obsMatches[o]);
+	}
+
+	for(unsigned int k=0; k<rxnMembership.size(); k++) {
+		int r = rxnMembership[k];
+		ReactionClass * rxn=reactions.at(r);
+		double oldA = rxn->get_a();
+		rxn->tryToAdd(mol, reactionPositions.at(r));
+		this->system->update_A_tot(rxn,oldA,rxn->update_a());
+	}
+}
+
+
+void MoleculeType::getRunningSystemMembership(Molecule *mol, vector <int> &rxnMembership, vector <int> &obsMatches)
+{
+	rxnMembership.clear();
+	for(unsigned int r=0; r<reactions.size(); r++) {
+		if(mol->getRxnListMappingId(getRxnIndex(reactions.at(r),reactionPositions.at(r)))>=0)
+			rxnMembership.push_back(r);
+	}
+
+	obsMatches.clear();
+	for(unsigned int o=0; o<molObs.size(); o++)
+		obsMatches.push_back(mol->isObs(o));
+}
+
+
 void MoleculeType::addMoleculeToRunningSystemButDontUpdate(Molecule *&mol)
 {
 	//First prepare the molecule for simulation
@@ -458,16 +515,8 @@ void MoleculeType::addReactionClass(ReactionClass * r, int rPosition)
 
 	//We also have to check to make sure that if the reaction is a DOR reaction,
 	//we remember it so we can updated it
-	if(r->getRxnType()==ReactionClass::DOR_RXN) {
-		if( r->getDORreactantPosition()==rPosition) {
-			indexOfDORrxns.push_back(reactions.size()-1);
-		}
-	}
-	else if(r->getRxnType()==ReactionClass::DOR2_RXN) {
-		if( r->getDORreactantPosition()==rPosition) {
-			indexOfDORrxns.push_back(reactions.size()-1);
-		}
-		else if( r->getDORreactantPosition2()==rPosition) {
+	if(r->getRxnType()==ReactionClass::DOR_RXN || r->getRxnType()==ReactionClass::DORN_RXN) {
+		if( r->isDORreactant(rPosition) ) {
 			indexOfDORrxns.push_back(reactions.size()-1);
 		}
 	}
@@ -507,6 +556,8 @@ void MoleculeType::setUpLocalFunctionListForMolecules()
 
 void MoleculeType::prepareForSimulation()
 {
+	findSamePatterns();
+
 	//cout<<"Preparing: "<<name<<endl;
 	//Check each reaction and add this molecule as a reactant if we have to
 	int r=0;
@@ -535,6 +586,28 @@ void MoleculeType::prepareForSimulation()
 	}
 }
 
+void MoleculeType::findSamePatterns()
+{
+	map <vector <unsigned long long>, TemplateMolecule *> patterns;
+	vector <unsigned long long> key;
+	int nPatterns = 0;
+	for(unsigned int t=0; t<allTemplates.size(); t++) {
+		TemplateMolecule *tm = allTemplates[t];
+		if(!tm->getSignatureKey(key)) {
+			tm->setCanonicalPattern(tm,nPatterns++);
+			continue;
+		}
+		map <vector <unsigned long long>, TemplateMolecule *>::iterator found = patterns.find(key);
+		if(found==patterns.end()) {
+			patterns[key] = tm;
+			tm->setCanonicalPattern(tm,nPatterns++);
+		} else {
+			tm->setCanonicalPattern(found->second,found->second->getPatternId());
+		}
+	}
+}
+
+
 void MoleculeType::updateRxnMembership(Molecule * m)
 {
 	for( unsigned int r=0; r<reactions.size(); r++ )
@@ -614,6 +687,9 @@ void MoleculeType::removeFromObservables(Molecule *m)
   		//Only subtract if m happened to be an observable... this saves us a compare call
   		//int matches = (*molObsIter)->isObservable(m);
 
+  		// observables that are only counted for output don't keep track of m
+  		if(!(*molObsIter)->isOnTheFly()) { ind++; continue; }
+
   		// How many times does this observable match the molecule?
   		int matches = m->isObs(ind);
   		// subtract matches from observable
@@ -675,40 +751,163 @@ void MoleculeType::addAllToObservables()
 	/////  WARNING:: when calling this function, be sure to clear all observables
 	/////  first, because this function will not clear observables.
 
-//	cout<<"+++++++++ "<<this->getName()<<endl;
+	vector <int> all;
+	for(unsigned int o=0; o<molObs.size(); o++) all.push_back(o);
+	addAllToObservables(all,true);
+}
 
-	//Check each observable and see if this molecule should be counted
-	Molecule *mol;  int o=0;  int matches=0;
-  	for(molObsIter = molObs.begin(); molObsIter != molObs.end(); molObsIter++)
-  	{
-  		//cout<<"comparing to obs: "<<(*molObsIter)->getName()<<endl;
-
-  		for( int m=0; m<mList->size(); m++ )
-  		{
-  			mol = mList->at(m);
-  			matches = (*molObsIter)->isObservable(mol);
-  			(*molObsIter)->add(matches);
-  			mol->setIsObs(o,matches);
-  			//cout<<"matches:"<<matches<<endl;
-  		}
-  		o++;
+
+void MoleculeType::addAllToObservable(MoleculesObservable *obs)
+{
+	for(unsigned int o=0; o<molObs.size(); o++) {
+		if(molObs[o]!=obs) continue;
+		for( int m=0; m<mList->size(); m++ ) {
+			Molecule *mol = mList->at(m);
+			int matches = obs->isObservable(mol);
+			obs->add(matches);
+			mol->setIsObs(o,matches);
+		}
+	}
+}
+
+
+void MoleculeType::addAllToLazyObservables()
+{
+	/////  Like addAllToObservables(), this does not clear the observables first.
+
+	//An observable that takes any molecule of this type, whatever its states and
+	//bonds, just counts the molecules once for each of its templates of this type
+	vector <int> toScan;
+	int n_templates; TemplateMolecule **tmList;
+	for(unsigned int o=0; o<molObs.size(); o++) {
+		MoleculesObservable *obs = molObs[o];
+		if(obs->isOnTheFly()) continue;
+		int perMolecule = 0;
+		obs->getTemplateMoleculeList(n_templates,tmList);
+		for(int t=0; t<n_templates && perMolecule>=0; t++) {
+			if(tmList[t]->getMoleculeType()!=this) continue;
+			if(tmList[t]->matchesAnyMolecule()) perMolecule++;
+			else perMolecule=-1;
+		}
+		if(perMolecule<0 || population_type) toScan.push_back(o);
+		else obs->straightAdd(perMolecule*mList->size());
+	}
+	if(!toScan.empty()) addAllToObservables(toScan,false);
+}
+
+
+void MoleculeType::addAllToObservables(const vector <int> &obsIndex, bool rememberMatches)
+{
+	//Observables whose templates each look at a single molecule are matched against
+	//the packed words, which only reads the molecule, so they are counted on
+	//several threads, each over its own range of the list and with its own tally.
+	//Patterns of several molecules mark the templates and molecules they visit, so
+	//they are counted on this thread afterwards, as are the molecules with states
+	//that don't fit in the packed words.
+	vector <int> packed, full;
+	for(unsigned int k=0; k<obsIndex.size(); k++) {
+		if(molObs[obsIndex[k]]->matchesOnlyBySignature()) packed.push_back(obsIndex[k]);
+		else full.push_back(obsIndex[k]);
+	}
+
+	//On one thread, everything is matched in a single pass over the list
+	int maxRanges = system->getObservableThreads();
+	if(packed.empty() || NFutil::countRanges(mList->size(),maxRanges,MIN_MOLECULES_PER_THREAD)==1) {
+		unsigned long long stateWord, bondWord;
+		for( int m=0; m<mList->size(); m++ ) {
+			Molecule *mol = mList->at(m);
+			bool isPacked = packState(mol,stateWord,bondWord);
+			for(unsigned int k=0; k<obsIndex.size(); k++) {
+				MoleculesObservable *obs = molObs[obsIndex[k]];
+				int matches = isPacked ? obs->isObservable(mol,stateWord,bondWord) : obs->isObservable(mol);
+				if(rememberMatches) { obs->add(matches); mol->setIsObs(obsIndex[k],matches); }
+				else obs->straightAdd(matches);
+			}
+		}
+		return;
+	}
+
+	vector <vector <int> > tally(maxRanges, vector <int> (packed.size(),0));
+	vector <vector <Molecule *> > unpacked(maxRanges);
+	int nRanges = NFutil::runInRanges(mList->size(), maxRanges, MIN_MOLECULES_PER_THREAD,
+		[&](int begin, int end, int r) {
+			unsigned long long stateWord, bondWord;
+			for(int m=begin; m<end; m++) {
+				Molecule *mol = mList->at(m);
+				if(!packState(mol,stateWord,bondWord)) { unpacked[r].push_back(mol); continue; }
+				for(unsigned int k=0; k<packed.size(); k++) {
+					int matches = molObs[packed[k]]->isObservable(mol,stateWord,bondWord);
+					tally[r][k] += matches;
+					if(rememberMatches) mol->setIsObs(packed[k],matches);
+				}
+			}
+		});
+
+	//add up the ranges in order, then match what the threads left over
+	vector <int> total(obsIndex.size(),0);
+	for(unsigned int k=0; k<packed.size(); k++) {
+		for(int r=0; r<nRanges; r++) total[k] += tally[r][k];
+		for(int r=0; r<nRanges; r++) {
+			for(unsigned int i=0; i<unpacked[r].size(); i++) {
+				int matches = molObs[packed[k]]->isObservable(unpacked[r][i]);
+				total[k] += matches;
+				if(rememberMatches) unpacked[r][i]->setIsObs(packed[k],matches);
+			}
+		}
+	}
+	if(!full.empty()) {
+		unsigned long long stateWord, bondWord;
+		for( int m=0; m<mList->size(); m++ ) {
+			Molecule *mol = mList->at(m);
+			bool isPacked = packState(mol,stateWord,bondWord);
+			for(unsigned int k=0; k<full.size(); k++) {
+				MoleculesObservable *obs = molObs[full[k]];
+				int matches = isPacked ? obs->isObservable(mol,stateWord,bondWord) : obs->isObservable(mol);
+				total[packed.size()+k] += matches;
+				if(rememberMatches) mol->setIsObs(full[k],matches);
+			}
+		}
 	}
 
+	for(unsigned int k=0; k<packed.size()+full.size(); k++) {
+		MoleculesObservable *obs = molObs[k<packed.size() ? packed[k] : full[k-packed.size()]];
+		if(rememberMatches) obs->add(total[k]);
+		else obs->straightAdd(total[k]);
+	}
 }
 
 
+bool MoleculeType::packState(Molecule *m, unsigned long long &stateWord, unsigned long long &bondWord) const
+{
+	if(!packable) return false;
+	stateWord = 0; bondWord = 0;
+	for(int c=0; c<numOfComponents; c++) {
+		if(m->isBindingSiteBonded(c)) bondWord |= 1ULL<<c;
+		if(stateFieldBits[c]==0) continue;
+		int state = m->getComponentState(c);
+		if(state<0 || (state>>stateFieldBits[c])!=0) return false;
+		stateWord |= ((unsigned long long)state)<<stateFieldOffset[c];
+	}
+	return true;
+}
 
 
 void MoleculeType::addToObservables(Molecule *m)
 {
+	//The molecule is packed once, so that every template that only looks at this
+	//molecule is checked against the packed words rather than by a full compare
+	unsigned long long stateWord, bondWord;
+	bool isPacked = packState(m,stateWord,bondWord);
+
 	//Check each observable and see if this molecule should be counted
 	int o=0;
   	for(molObsIter = molObs.begin(); molObsIter != molObs.end(); molObsIter++)
   	{
 		//cout<<"Comparing(in add: ";
 		//cout<<m->getUniqueID()<<")"<<endl;
+		if(!(*molObsIter)->isOnTheFly()) { o++; continue; }
 
-		int matches = (*molObsIter)->isObservable(m);
+		int matches = isPacked ? (*molObsIter)->isObservable(m,stateWord,bondWord) : (*molObsIter)->isObservable(m);
 		m->setIsObs(o,matches);
 
 		(*molObsIter)->add(matches);
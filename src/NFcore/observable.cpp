@@ -18,6 +18,8 @@ Observable::Observable(string name)
 	this->dependentRxns= new ReactionClass *[n_dependentRxns];
 	this->count=0;
 	this->type=Observable::NO_TYPE;
+	this->readBetweenOutputs=false;
+	this->onTheFly=true;
 }
 
 Observable::~Observable()
@@ -135,18 +137,28 @@ void Observable::getTemplateMoleculeList(int &n_templates, TemplateMolecule **&t
 	n_templates = this->n_templates;
 	tmList = this->templateMolecules;
 }
+
+bool Observable::matchesOnlyBySignature() const
+{
+	for(int t=0; t<n_templates; t++)
+		if(!templateMolecules[t]->hasSignature()) return false;
+	return true;
+}
 // AS-2021
 void Observable::addReferenceToGlobalFunction(GlobalFunction *f) {
 	f->addCounterPointer(&count);
+	readBetweenOutputs=true;
 }
 // AS-2021
 void Observable::addReferenceToMyself(mu::Parser *p)
 {
 	p->DefineVar(obsName,&count);
+	readBetweenOutputs=true;
 }
 void Observable::addReferenceToMyself(string referenceName, mu::Parser *p)
 {
 	p->DefineVar(referenceName,&count);
+	readBetweenOutputs=true;
 }
 void Observable::addDependentRxn(ReactionClass *r)
 {
@@ -160,6 +172,7 @@ void Observable::addDependentRxn(ReactionClass *r)
 	delete [] dependentRxns;
 	dependentRxns = newDepRxns;
 	n_dependentRxns++;
+	readBetweenOutputs=true;
 }
 
 
@@ -240,7 +253,7 @@ int MoleculesObservable::isObservable(Molecule *m) const
 		//cout<<endl<<endl<<endl;
 		//cout<<"starting!"<<endl;
 
-		if ( templateMolecules[t]->compare(m) ) {
+		if ( templateMolecules[t]->compareOnce(m) ) {
 			//cout<<"  adding one"<<endl;
 			matches += m->getPopulation();
 			//return 1;
@@ -251,6 +264,23 @@ int MoleculesObservable::isObservable(Molecule *m) const
 	return matches;
 }
 
+int MoleculesObservable::isObservable(Molecule *m, unsigned long long stateWord, unsigned long long bondWord) const
+{
+	//templates that only look at this one molecule are decided from the packed
+	//words, and only patterns of several molecules need the full comparison
+	int matches = 0;
+	for(int t=0; t<n_templates; t++) {
+		if(templateMolecules[t]->hasSignature()) {
+			bool match = templateMolecules[t]->compareSignature(m,stateWord,bondWord);
+			templateMolecules[t]->rememberMatch(m,match);
+			if(match) matches += m->getPopulation();
+		} else if(templateMolecules[t]->compareOnce(m)) {
+			matches += m->getPopulation();
+		}
+	}
+	return matches;
+}
+
 int MoleculesObservable::isObservable(Complex *c) const
 {
 	cerr<<"Comparing a Molecules observable '"<<obsName<<"' to a complex!"<<endl;
@@ -368,32 +398,50 @@ int SpeciesObservable::isObservable(Complex *c) const
 			// reset iterator to beginning
 			c->molIter = c->complexMembers.begin();
 
-			if(relation[t]==EQUALS) {
-				if(localMatches==quantity[t]) matches += (*(c->molIter))->getPopulation();
-
-			} else if(relation[t]==NOT_EQUALS) {
-				if(localMatches!=quantity[t]) matches += (*(c->molIter))->getPopulation();
-
-			} else if(relation[t]==GREATER_THAN) {
-				if(localMatches>quantity[t])  matches += (*(c->molIter))->getPopulation();
-
-			} else if(relation[t]==LESS_THAN) {
-				if(localMatches<quantity[t])  matches += (*(c->molIter))->getPopulation();
-
-			} else if(relation[t]==GREATOR_OR_EQUAL_TO) {
-				if(localMatches>=quantity[t]) matches += (*(c->molIter))->getPopulation();
+			if(satisfiesRelation(t,localMatches)) matches += (*(c->molIter))->getPopulation();
+		}
+	}
+	return matches;
+}
 
-			} else if(relation[t]==LESS_THAN_OR_EQUAL_TO) {
-				if(localMatches<=quantity[t]) matches += (*(c->molIter))->getPopulation();
 
+int SpeciesObservable::isObservableBySignature(Complex *c, const vector <unsigned long long> &stateWords, const vector <unsigned long long> &bondWords) const
+{
+	//like isObservable(c), but with an iterator of its own, and without touching
+	//the templates or the molecules
+	int matches = 0;
+	for(int t=0; t<n_templates; t++) {
+		int localMatches = 0;
+		int k = 0;
+		for(list <Molecule *>::const_iterator it=c->complexMembers.begin(); it!=c->complexMembers.end(); it++, k++) {
+			if(!templateMolecules[t]->compareSignature(*it,stateWords[k],bondWords[k])) continue;
+			if(relation[t]==NO_RELATION) {
+				matches += (*it)->getPopulation();
+				break;
 			}
-
+			localMatches++;
 		}
+		if(relation[t]!=NO_RELATION && satisfiesRelation(t,localMatches))
+			matches += c->complexMembers.front()->getPopulation();
 	}
 	return matches;
 }
 
 
+bool SpeciesObservable::satisfiesRelation(int t, int localMatches) const
+{
+	switch(relation[t]) {
+		case EQUALS: return localMatches==quantity[t];
+		case NOT_EQUALS: return localMatches!=quantity[t];
+		case GREATER_THAN: return localMatches>quantity[t];
+		case LESS_THAN: return localMatches<quantity[t];
+		case GREATOR_OR_EQUAL_TO: return localMatches>=quantity[t];
+		case LESS_THAN_OR_EQUAL_TO: return localMatches<=quantity[t];
+	}
+	return false;
+}
+
+
 
 
 
@@ -97,10 +97,16 @@ namespace NFcore
 			int getType() const { return type; };
 
 			void getTemplateMoleculeList(int &n_templates, TemplateMolecule **&tmList);
+			/* true if every template only looks at a single molecule, so that matching
+			 * it to the packed words of a molecule only reads the molecule and can run
+			 * on any thread (see TemplateMolecule::hasSignature()) */
+			bool matchesOnlyBySignature() const;
 
 			void addReferenceToMyself(mu::Parser *p);
 			void addReferenceToMyself(string referenceName, mu::Parser *p);
 			void addDependentRxn(ReactionClass *r);
+			int getNumOfDependentRxns() const { return n_dependentRxns; };
+			ReactionClass * getDependentRxn(int rIndex) const { return dependentRxns[rIndex]; };
 			
 			// AS-2021
 			void addReferenceToGlobalFunction(GlobalFunction *f);
@@ -109,6 +115,15 @@ namespace NFcore
 			virtual int isObservable(Molecule *m) const = 0;
 			virtual int isObservable(Complex *c) const = 0;
 
+			/* An observable that a function, a reaction or the caller holds on to can be
+			 * read at any time, so it is updated after every event.  The others are only
+			 * read when they are output, and System::prepareForSimulation() sets them to
+			 * be counted then instead (see System::refreshObservables()) */
+			void setReadBetweenOutputs() { readBetweenOutputs=true; };
+			bool isReadBetweenOutputs() const { return readBetweenOutputs; };
+			void setOnTheFly(bool onTheFly) { this->onTheFly=onTheFly; };
+			bool isOnTheFly() const { return onTheFly; };
+
 
 			//Indentifiers
 			static const int NO_RELATION = -1;
@@ -146,6 +161,9 @@ namespace NFcore
 			int n_dependentRxns;
 			ReactionClass ** dependentRxns;
 
+			bool readBetweenOutputs;
+			bool onTheFly;
+
 	};
 
 
@@ -164,6 +182,9 @@ namespace NFcore
 			virtual int isObservable(Molecule *m) const;
 			virtual int isObservable(Complex *c) const;
 
+			//Same as isObservable(m), for a molecule already packed by MoleculeType::packState()
+			int isObservable(Molecule *m, unsigned long long stateWord, unsigned long long bondWord) const;
+
 
 		protected:
 
@@ -186,7 +207,14 @@ namespace NFcore
 			virtual int isObservable(Molecule *m) const;
 			virtual int isObservable(Complex *c) const;
 
+			/* Same as isObservable(c) for an observable that matchesOnlyBySignature(),
+			 * given the words MoleculeType::packState() gives for each member of the
+			 * complex, in order.  Only reads the complex, so it is safe to call on
+			 * several complexes at once */
+			int isObservableBySignature(Complex *c, const vector <unsigned long long> &stateWords, const vector <unsigned long long> &bondWords) const;
+
 		protected:
+			bool satisfiesRelation(int t, int localMatches) const;
 
 			// information for processing stochiometric observables
 			int *relation;
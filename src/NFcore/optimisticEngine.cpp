@@ -0,0 +1,678 @@
+#include "NFcore.hh"
+#include "../NFreactions/reactions/reaction.hh"
+
+#include <typeinfo>
+#include <chrono>
+
+
+using namespace std;
+using namespace NFcore;
+
+
+//takes the molecule at the given place out of a set, see OptimisticEngine::eligible
+static void dropFromSet(vector <Molecule *> &set, vector <int> &slotOf, int slot)
+{
+	slotOf[set[slot]->getUniqueID()] = -1;
+	set[slot] = set.back();
+	set.pop_back();
+	if(slot<(int)set.size()) slotOf[set[slot]->getUniqueID()] = slot;
+}
+
+static void addToSet(vector <Molecule *> &set, vector <int> &slotOf, Molecule *m)
+{
+	slotOf[m->getUniqueID()] = set.size();
+	set.push_back(m);
+}
+
+
+OptimisticEngine::OptimisticEngine(System *s, int nThreads, int batchSize)
+{
+	this->system = s;
+	this->nThreads = nThreads>0 ? nThreads : 1;
+	this->batchSize = batchSize>0 ? batchSize : 1;
+	this->totalBound = 0;
+	this->nGroups = 0;
+	this->round = 0;
+	this->nMoleculeIDs = 0;
+	this->maxTouches = 0;
+	this->headroom = 0;
+	this->seen = 0;
+	nCandidates = nScreened = nRejected = nNull = nFired = nDeferred = nWaves = waveWidth = 0;
+	waveTime = serialTime = 0;
+
+	checkSupport();
+	if(!isSupported()) return;
+
+	for(unsigned int r=0; r<system->allReactions.size(); r++)
+	{
+		RxnState rs;
+		rs.rxn = system->allReactions[r];
+		rs.bound = 0;
+		for(unsigned int j=0; j<rs.rxn->n_reactants; j++) {
+			TemplateMolecule *tm = rs.rxn->reactantTemplates[j];
+			rs.molecules.push_back(tm->getMoleculeType()->getMoleculeList());
+			rs.maxMappings.push_back(tm->getMaxMappingSets());
+			rs.lists.push_back(new ReactantList(j,rs.rxn->transformationSet,4));
+		}
+		rs.kept.resize(rs.rxn->n_reactants);
+		rs.chosen = new MappingSet *[rs.rxn->n_reactants];
+		rs.group = 0;
+		rxns.push_back(rs);
+
+		//an event changes the molecule of each of its mappings, and an unbinding
+		//also the partner, see recordTouched()
+		TransformationSet *ts = rs.rxn->transformationSet;
+		int touches = 0;
+		for(unsigned int j=0; j<rs.rxn->n_reactants; j++)
+			for(int t=0; t<ts->getNumOfTransformations(j); t++)
+				touches += ts->getTransformation(j,t)->getType()==(int)TransformationFactory::UNBINDING ? 2 : 1;
+		if(touches>maxTouches) maxTouches = touches;
+	}
+	cumulativeBound.assign(rxns.size(),0);
+	rxnFired.assign(rxns.size(),0);
+	groupReactions();
+
+	for(unsigned int t=0; t<system->allMoleculeTypes.size(); t++) {
+		MoleculeList *ml = system->allMoleculeTypes[t]->getMoleculeList();
+		for(int i=0; i<ml->size(); i++)
+			if(ml->at(i)->getUniqueID()>=nMoleculeIDs) nMoleculeIDs = ml->at(i)->getUniqueID()+1;
+	}
+	seenRound.assign(nMoleculeIDs,0);
+
+	//Claims are made on complexes with complex bookkeeping, otherwise on the
+	//molecules of a complex one by one
+	int nStamps = system->useComplex ? system->allComplexes.getNumOfComplexes() : nMoleculeIDs;
+	stampRound.assign(nStamps,0);
+	stampOwner.assign(nStamps,-1);
+
+	findPatterns(1);
+	for(unsigned int t=0; t<system->allMoleculeTypes.size(); t++) {
+		MoleculeList *ml = system->allMoleculeTypes[t]->getMoleculeList();
+		for(int i=0; i<ml->size(); i++)
+			checkEligible(ml->at(i),0);
+	}
+}
+
+
+OptimisticEngine::~OptimisticEngine()
+{
+	for(unsigned int r=0; r<rxns.size(); r++) {
+		for(unsigned int j=0; j<rxns[r].lists.size(); j++)
+			delete rxns[r].lists[j];
+		delete [] rxns[r].chosen;
+	}
+}
+
+
+void OptimisticEngine::checkSupport()
+{
+	if(system->selector==0) {
+		unsupportedReason = "the system has not been prepared for simulation";
+		return;
+	}
+	for(unsigned int r=0; r<system->allReactions.size(); r++)
+	{
+		ReactionClass *rxn = system->allReactions[r];
+		TransformationSet *ts = rxn->transformationSet;
+		string rule = "rule "+rxn->getName();
+		if(typeid(*rxn)!=typeid(BasicRxnClass)) {
+			unsupportedReason = rule+" does not have an elementary rate law";
+		} else if(rxn->totalRateFlag) {
+			unsupportedReason = rule+" uses the TotalRate convention";
+		} else if(rxn->n_reactants==0 || ts->getNumOfAddMoleculeTransforms()>0 || ts->getNumOfAddSpeciesTransforms()>0) {
+			unsupportedReason = rule+" creates molecules";
+		}
+		for(unsigned int j=0; j<rxn->n_reactants && unsupportedReason.empty(); j++)
+		{
+			if(rxn->isPopulationType[j]) {
+				unsupportedReason = rule+" has a population reactant";
+				break;
+			}
+			for(int t=0; t<ts->getNumOfTransformations(j); t++) {
+				if(ts->getTransformation(j,t)->getType()==(int)TransformationFactory::REMOVE)
+					unsupportedReason = rule+" deletes molecules";
+			}
+			vector <TemplateMolecule *> tmList;
+			TemplateMolecule::traverse(rxn->reactantTemplates[j],tmList,TemplateMolecule::FIND_ALL);
+			for(unsigned int k=0; k<tmList.size(); k++) {
+				if(tmList[k]->getN_connectedTo()>0)
+					unsupportedReason = rule+" has a reactant pattern with a dot (connected-to) bond";
+			}
+		}
+		if(!unsupportedReason.empty()) return;
+	}
+}
+
+
+void OptimisticEngine::groupReactions()
+{
+	//Reactions whose patterns share a TemplateMolecule can't be matched at the
+	//same time, because the template keeps the state of the match
+	NFutil::DisjointSets groups(rxns.size());
+	map <TemplateMolecule *, int> firstUser;
+	for(unsigned int r=0; r<rxns.size(); r++)
+	{
+		for(unsigned int j=0; j<rxns[r].rxn->n_reactants; j++) {
+			vector <TemplateMolecule *> tmList;
+			TemplateMolecule::traverse(rxns[r].rxn->reactantTemplates[j],tmList,TemplateMolecule::FIND_ALL);
+			for(unsigned int k=0; k<tmList.size(); k++) {
+				map <TemplateMolecule *, int>::iterator found = firstUser.find(tmList[k]);
+				if(found==firstUser.end()) firstUser[tmList[k]] = r;
+				else groups.join(r,found->second);
+			}
+		}
+	}
+
+	vector <int> groupOf(rxns.size(),-1);
+	nGroups = 0;
+	for(unsigned int r=0; r<rxns.size(); r++) {
+		int g = groups.find(r);
+		if(groupOf[g]<0) groupOf[g] = nGroups++;
+		rxns[r].group = groupOf[g];
+	}
+	buckets.resize(nGroups);
+}
+
+
+void OptimisticEngine::findPatterns(int nParts)
+{
+	//Every reactant of every reaction is a pattern of its own, with an empty set
+	//of molecules in each part
+	patternTemplates.clear();
+	patternsOfType.assign(system->allMoleculeTypes.size(),vector <int> ());
+	for(unsigned int r=0; r<rxns.size(); r++) {
+		rxns[r].patterns.clear();
+		for(unsigned int j=0; j<rxns[r].rxn->n_reactants; j++) {
+			TemplateMolecule *tm = rxns[r].rxn->reactantTemplates[j];
+			rxns[r].patterns.push_back(patternTemplates.size());
+			patternsOfType[tm->getMoleculeType()->getTypeID()].push_back(patternTemplates.size());
+			patternTemplates.push_back(tm);
+		}
+	}
+	eligible.assign(nParts,vector <vector <Molecule *> > (patternTemplates.size()));
+	eligibleSlot.assign(patternTemplates.size(),vector <int> (nMoleculeIDs,-1));
+}
+
+
+void OptimisticEngine::checkEligible(Molecule *m, int part)
+{
+	int id = m->getUniqueID();
+	vector <int> &mine = patternsOfType[m->getMoleculeType()->getTypeID()];
+	for(unsigned int p=0; p<mine.size(); p++) {
+		int k = mine[p];
+		bool matches = patternTemplates[k]->compareOwnSites(m);
+		if(matches && eligibleSlot[k][id]<0) addToSet(eligible[part][k],eligibleSlot[k],m);
+		else if(!matches && eligibleSlot[k][id]>=0) dropFromSet(eligible[part][k],eligibleSlot[k],eligibleSlot[k][id]);
+	}
+}
+
+
+void OptimisticEngine::moveEligible(Molecule *m, int from, int to)
+{
+	int id = m->getUniqueID();
+	vector <int> &mine = patternsOfType[m->getMoleculeType()->getTypeID()];
+	for(unsigned int p=0; p<mine.size(); p++) {
+		int k = mine[p];
+		if(eligibleSlot[k][id]<0) continue;
+		dropFromSet(eligible[from][k],eligibleSlot[k],eligibleSlot[k][id]);
+		addToSet(eligible[to][k],eligibleSlot[k],m);
+	}
+}
+
+
+double OptimisticEngine::boundOf(int r, int part, int headroom) const
+{
+	const RxnState &rs = rxns[r];
+	double bound = rs.rxn->baseRate;
+	for(unsigned int j=0; j<rs.patterns.size(); j++)
+		bound *= (double)(eligible[part][rs.patterns[j]].size()+headroom) * (double)rs.maxMappings[j];
+	return bound;
+}
+
+
+int OptimisticEngine::chooseBatchSize()
+{
+	//The molecules that a batch changes can add up to the headroom to the sets,
+	//so the batch is halved until the headroom adds at most a quarter to the
+	//bound.  Nothing can happen if no molecule matches, and nothing changes that.
+	double tight = 0;
+	for(unsigned int r=0; r<rxns.size(); r++) tight += boundOf(r,0,0);
+	if(tight<=0) return 0;
+	int n = batchSize;
+	while(n>1) {
+		double loose = 0;
+		for(unsigned int r=0; r<rxns.size(); r++) loose += boundOf(r,0,maxTouches*n);
+		if(loose<=1.25*tight) break;
+		n /= 2;
+	}
+	return n;
+}
+
+
+void OptimisticEngine::equilibrate(double duration)
+{
+	if(duration<=0) return;
+	double startTime = system->current_time;
+	bool onTheFly = system->onTheFlyObservables;
+	system->onTheFlyObservables = false;
+
+	advance(startTime+duration);
+
+	system->onTheFlyObservables = onTheFly;
+	rebuild();
+	system->current_time = startTime;
+}
+
+
+double OptimisticEngine::sim(double duration, long int sampleTimes)
+{
+	System::NULL_EVENT_COUNTER=0;
+	cout.setf(ios::scientific);
+	cout<<"simulating system for: "<<duration<<" second(s) with the optimistic engine on "<<nThreads<<" thread(s)."<<endl;
+	if(system->a_tot>0) {
+		double tight = 0;
+		for(unsigned int r=0; r<rxns.size(); r++) tight += boundOf(r,0,0);
+		cout<<"candidate events are drawn at "<<tight/system->a_tot<<" times the total propensity the system starts with, ";
+		cout<<"before the headroom."<<endl;
+	}
+	cout<<"\n";
+	if(sampleTimes<1) sampleTimes = 1;
+
+	nCandidates = nScreened = nRejected = nNull = nFired = nDeferred = nWaves = waveWidth = 0;
+	waveTime = serialTime = 0;
+	rxnFired.assign(rxns.size(),0);
+
+	clock_t start = clock();
+	chrono::steady_clock::time_point wallStart = chrono::steady_clock::now();
+
+	// observables are recounted for every output, since the events don't update them
+	bool onTheFly = system->onTheFlyObservables;
+	system->onTheFlyObservables = false;
+
+	double startTime = system->current_time;
+	double dSampleTime = duration / sampleTimes;
+	system->outputAllObservableCounts(startTime,system->globalEventCounter);
+	unsigned long long lastEvents = 0;
+	for(long int step=1; step<=sampleTimes; step++)
+	{
+		double sampleTime = startTime+dSampleTime*(double)step;
+		advance(sampleTime);
+		system->outputAllObservableCounts(sampleTime,system->globalEventCounter);
+
+		cout << "Sim time: " << sampleTime;
+		cout << "\tCPU time (total): " << ((double) (clock() - start) / (double) CLOCKS_PER_SEC) << "s";
+		cout << "\t events (step): " << (nFired+nNull-lastEvents) << endl;
+		lastEvents = nFired+nNull;
+	}
+
+	system->onTheFlyObservables = onTheFly;
+	rebuild();
+
+	double wall = chrono::duration <double> (chrono::steady_clock::now()-wallStart).count();
+	unsigned long long iteration = nFired+nNull;
+	System::NULL_EVENT_COUNTER += nNull;
+	system->printRunSummary(iteration,start,true);
+	cout<<"   Optimistic engine: "<<nCandidates<<" candidate events in "<<nWaves<<" batches, "<<wall<<"s of wall time"<<endl;
+	cout<<"   ( "<<100.0*(double)nRejected/(double)nCandidates<<"% rejected, ";
+	cout<<100.0*(double)nScreened/(double)nCandidates<<"% by their molecules alone, ";
+	cout<<100.0*(double)nDeferred/(double)nCandidates<<"% deferred by conflicts, ";
+	cout<<(double)waveWidth/(double)nWaves<<" run at once per batch )"<<endl;
+	cout<<"   ( "<<100.0*waveTime/(waveTime+serialTime)<<"% of the time spent running candidates at once, ";
+	cout<<"the rest on one thread )"<<endl;
+	cout.unsetf(ios::scientific);
+	return system->current_time;
+}
+
+
+void OptimisticEngine::advance(double stopTime)
+{
+	bool reachedStop = false;
+	while(!reachedStop)
+	{
+		chrono::steady_clock::time_point drawStart = chrono::steady_clock::now();
+		int n = drawBatch(stopTime,reachedStop);
+		serialTime += chrono::duration <double> (chrono::steady_clock::now()-drawStart).count();
+		if(n>0) runBatch(n);
+	}
+	system->current_time = stopTime;
+}
+
+
+int OptimisticEngine::drawBatch(double stopTime, bool &reachedStop)
+{
+	batch.clear();
+	reactants.clear();
+	picks.clear();
+	entrants.clear();
+	reachedStop = false;
+	int n = chooseBatchSize();
+	headroom = maxTouches*n;
+	totalBound = 0;
+	for(unsigned int r=0; r<rxns.size(); r++) {
+		rxns[r].bound = boundOf(r,0,headroom);
+		totalBound += rxns[r].bound;
+		cumulativeBound[r] = totalBound;
+	}
+	if(n==0 || totalBound<=0) {
+		reachedStop = true;
+		return 0;
+	}
+
+	//Every random number is drawn here, on this thread, so the trajectory does not
+	//depend on how the batch is run.  A candidate after the stopping time is thrown
+	//away, which is fine since the next one is drawn afresh from the stopping time.
+	double t = system->current_time;
+	while((int)batch.size()<n)
+	{
+		double dt = -log(NFutil::RANDOM_OPEN()) / totalBound;
+		if(t+dt>stopTime) {
+			reachedStop = true;
+			break;
+		}
+		t += dt;
+
+		Candidate c;
+		c.time = t;
+		c.rxn = lower_bound(cumulativeBound.begin(),cumulativeBound.end(),NFutil::RANDOM(totalBound))-cumulativeBound.begin();
+		if(c.rxn>=(int)rxns.size()) c.rxn = rxns.size()-1;
+		c.firstReactant = reactants.size();
+		c.deferred = false;
+		c.late = false;
+		c.nTouched = 0;
+		c.outcome = PENDING;
+
+		RxnState &rs = rxns[c.rxn];
+		for(unsigned int j=0; j<rs.molecules.size(); j++) {
+			vector <Molecule *> &set = eligible[0][rs.patterns[j]];
+			int pick = NFutil::RANDOM_INT(0,set.size()+headroom);
+			if(pick<(int)set.size()) {
+				reactants.push_back(set[pick]);
+				entrants.push_back(-1);
+			} else {
+				reactants.push_back(0);
+				entrants.push_back(pick-set.size());
+				c.late = true;
+			}
+			picks.push_back(rs.maxMappings[j]>1 ? NFutil::RANDOM_INT(0,rs.maxMappings[j]) : 0);
+		}
+		batch.push_back(c);
+	}
+	touched.resize(batch.size()*maxTouches);
+	system->current_time = t;
+	return batch.size();
+}
+
+
+bool OptimisticEngine::claimComplexOf(Molecule *m, int c)
+{
+	if(system->useComplex) {
+		int id = m->getComplexID();
+		if(stampRound[id]==round) return stampOwner[id]==c;
+		stampRound[id] = round;
+		stampOwner[id] = c;
+		return true;
+	}
+
+	//complexes are claimed whole, so if one molecule was claimed, they all were
+	int id = m->getUniqueID();
+	if(stampRound[id]==round) return stampOwner[id]==c;
+	list <Molecule *> members;
+	m->traverseBondedNeighborhood(members,ReactionClass::NO_LIMIT);
+	for(list <Molecule *>::iterator it=members.begin(); it!=members.end(); it++) {
+		stampRound[(*it)->getUniqueID()] = round;
+		stampOwner[(*it)->getUniqueID()] = c;
+	}
+	return true;
+}
+
+
+bool OptimisticEngine::isClaimed(Molecule *m) const
+{
+	if(system->useComplex) return stampRound[m->getComplexID()]==round;
+	return stampRound[m->getUniqueID()]==round;
+}
+
+
+bool OptimisticEngine::cannotMatch(int c) const
+{
+	//Only if no earlier candidate can have changed the molecule
+	const RxnState &rs = rxns[batch[c].rxn];
+	for(unsigned int j=0; j<rs.molecules.size(); j++) {
+		Molecule *m = reactants[batch[c].firstReactant+j];
+		if(m!=0 && !isClaimed(m) && !rs.rxn->reactantTemplates[j]->compareOwnSites(m)) return true;
+	}
+	return false;
+}
+
+
+bool OptimisticEngine::claim(int c)
+{
+	bool free = true;
+	for(unsigned int j=0; j<rxns[batch[c].rxn].molecules.size(); j++) {
+		Molecule *m = reactants[batch[c].firstReactant+j];
+		if(m!=0 && !claimComplexOf(m,c)) free = false;
+	}
+	return free && !batch[c].late;
+}
+
+
+void OptimisticEngine::runBatch(int n)
+{
+	//Claim in time order.  A candidate that finds a complex claimed by an earlier
+	//one has to wait for it, the others touch nothing earlier ones touch.
+	chrono::steady_clock::time_point serialStart = chrono::steady_clock::now();
+	round++;
+	for(int g=0; g<nGroups; g++) buckets[g].clear();
+	int width = 0, deferred = 0;
+	for(int c=0; c<n; c++) {
+		if(cannotMatch(c)) {
+			batch[c].outcome = REJECTED;
+			nScreened++;
+			continue;
+		}
+		batch[c].deferred = !claim(c);
+		deferred += batch[c].deferred;
+		if(batch[c].deferred) continue;
+		buckets[rxns[batch[c].rxn].group].push_back(c);
+		width++;
+	}
+
+	vector <int> busy;
+	for(int g=0; g<nGroups; g++)
+		if(!buckets[g].empty()) busy.push_back(g);
+	int workers = min(nThreads,(int)busy.size());
+	chrono::steady_clock::time_point waveStart = chrono::steady_clock::now();
+	serialTime += chrono::duration <double> (waveStart-serialStart).count();
+	if(workers>1) {
+		system->allComplexes.setConcurrent(true);
+		atomic <int> next(0);
+		NFutil::runInRanges(workers, workers, 1, [&](int begin, int end, int r) {
+			for(int b=next++; b<(int)busy.size(); b=next++)
+				for(unsigned int k=0; k<buckets[busy[b]].size(); k++)
+					runCandidate(batch[buckets[busy[b]][k]]);
+		});
+		system->allComplexes.setConcurrent(false);
+	} else {
+		for(unsigned int b=0; b<busy.size(); b++)
+			for(unsigned int k=0; k<buckets[busy[b]].size(); k++)
+				runCandidate(batch[buckets[busy[b]][k]]);
+	}
+	serialStart = chrono::steady_clock::now();
+	waveTime += chrono::duration <double> (serialStart-waveStart).count();
+
+	for(int c=0; c<n; c++)
+		if(batch[c].deferred) runCandidate(batch[c]);
+
+	for(int c=0; c<n; c++) {
+		if(batch[c].outcome==REJECTED) { nRejected++; continue; }
+		if(batch[c].outcome==NULL_EVENT) nNull++;
+		else nFired++;
+		rxnFired[batch[c].rxn]++;
+		system->globalEventCounter++;
+	}
+	updateEligible(n);
+	nCandidates += n;
+	nDeferred += deferred;
+	nWaves++;
+	waveWidth += width;
+	serialTime += chrono::duration <double> (chrono::steady_clock::now()-serialStart).count();
+}
+
+
+void OptimisticEngine::runCandidate(Candidate &c)
+{
+	//The candidate fires with the chance that its picks are real mappings of the
+	//reactants, which puts every mapping in at the rate of the reaction
+	RxnState &rs = rxns[c.rxn];
+	int index = &c-&batch[0];
+	c.outcome = FIRED;
+	for(unsigned int j=0; j<rs.molecules.size(); j++) {
+		Molecule *&m = reactants[c.firstReactant+j];
+		if(entrants[c.firstReactant+j]>=0) m = findEntrant(index,rs.patterns[j],entrants[c.firstReactant+j]);
+		if(m==0) {
+			c.outcome = REJECTED;
+			break;
+		}
+		int nMappings = mapReactant(rs,j,m);
+		int pick = picks[c.firstReactant+j];
+		if(pick>=nMappings) {
+			c.outcome = REJECTED;
+			break;
+		}
+		rs.chosen[j] = rs.kept[j][pick];
+	}
+
+	if(c.outcome==FIRED) {
+		if(!rs.rxn->transformationSet->checkMolecularity(rs.chosen)) {
+			c.outcome = NULL_EVENT;
+		} else {
+			c.nTouched = recordTouched(rs,touched.data()+index*maxTouches);
+			rs.rxn->transformationSet->transform(rs.chosen);
+		}
+	}
+	clearScratch(rs);
+}
+
+
+int OptimisticEngine::recordTouched(RxnState &rs, Molecule **touchedNow) const
+{
+	//Everything a transformation changes is on the molecule of its mapping, and
+	//for an unbinding, on the partner too, so this is called before the transform
+	TransformationSet *ts = rs.rxn->transformationSet;
+	int n = 0;
+	for(unsigned int j=0; j<rs.rxn->n_reactants; j++) {
+		for(int t=0; t<ts->getNumOfTransformations(j); t++) {
+			Mapping *mapping = rs.chosen[j]->get(t);
+			touchedNow[n++] = mapping->getMolecule();
+			if(ts->getTransformation(j,t)->getType()!=(int)TransformationFactory::UNBINDING) continue;
+			Molecule *partner = mapping->getMolecule()->getBondedMolecule(mapping->getIndex());
+			if(partner!=0) touchedNow[n++] = partner;
+		}
+	}
+	return n;
+}
+
+
+Molecule *OptimisticEngine::findEntrant(int c, int pattern, int index)
+{
+	//The molecules outside the set of the pattern that the candidates before c
+	//changed, each once and in the order they were changed.  The sets only change
+	//between batches, and c runs after all of the earlier candidates.
+	seen++;
+	MoleculeType *mt = patternTemplates[pattern]->getMoleculeType();
+	for(int e=0; e<c; e++) {
+		for(int i=0; i<batch[e].nTouched; i++) {
+			Molecule *m = touched[e*maxTouches+i];
+			int id = m->getUniqueID();
+			if(m->getMoleculeType()!=mt || seenRound[id]==seen) continue;
+			seenRound[id] = seen;
+			if(eligibleSlot[pattern][id]>=0) continue;
+			if(index==0) return m;
+			index--;
+		}
+	}
+	return 0;
+}
+
+
+void OptimisticEngine::updateEligible(int n)
+{
+	seen++;
+	for(int c=0; c<n; c++) {
+		for(int i=0; i<batch[c].nTouched; i++) {
+			Molecule *m = touched[c*maxTouches+i];
+			if(seenRound[m->getUniqueID()]==seen) continue;
+			seenRound[m->getUniqueID()] = seen;
+			checkEligible(m,0);
+		}
+	}
+}
+
+
+int OptimisticEngine::mapReactant(RxnState &rs, int r, Molecule *m)
+{
+	//The same mappings BasicRxnClass::tryToAdd() puts in the reactant list
+	ReactantList *rl = rs.lists[r];
+	vector <MappingSet *> &kept = rs.kept[r];
+	kept.clear();
+	MappingSet *ms = rl->pushNextAvailableMappingSet();
+	rs.symmetric.clear();
+	if(!rs.rxn->reactantTemplates[r]->compare(m,rl,ms,false,&rs.symmetric)) return 0;
+	if(rs.symmetric.empty()) {
+		kept.push_back(ms);
+		return 1;
+	}
+
+	for(unsigned int s=0; s<rs.symmetric.size(); s++) {
+		bool repeated = false;
+		for(unsigned int k=0; k<kept.size() && !repeated; k++)
+			repeated = MappingSet::checkForEquality(rs.symmetric[s],kept[k]);
+		if(!repeated) kept.push_back(rs.symmetric[s]);
+	}
+	if((int)kept.size()>rs.maxMappings[r]) {
+		cerr<<"Error in OptimisticEngine: rule "<<rs.rxn->getName()<<" mapped a molecule "<<kept.size();
+		cerr<<" times, but no more than "<<rs.maxMappings[r]<<" were expected.  Quitting."<<endl;
+		exit(1);
+	}
+	return kept.size();
+}
+
+
+void OptimisticEngine::clearScratch(RxnState &rs)
+{
+	for(unsigned int j=0; j<rs.lists.size(); j++) {
+		while(rs.lists[j]->size()>0) rs.lists[j]->popLastMappingSet();
+		rs.kept[j].clear();
+	}
+}
+
+
+void OptimisticEngine::rebuild()
+{
+	// recount the observables as they are now, so that each molecule remembers
+	// what it was counted as, then rebuild the reactant lists and observables the
+	// same way System::prepareForSimulation() does
+	bool onTheFly = system->onTheFlyObservables;
+	system->onTheFlyObservables = false;
+	system->refreshObservables();
+	system->onTheFlyObservables = onTheFly;
+
+	for(unsigned int t=0; t<system->allMoleculeTypes.size(); t++) {
+		MoleculeType *mt = system->allMoleculeTypes[t];
+		MoleculeList *ml = mt->getMoleculeList();
+		for(int i=0; i<ml->size(); i++) {
+			mt->removeFromObservables(ml->at(i));
+			mt->removeFromRxns(ml->at(i));
+		}
+	}
+	for(unsigned int t=0; t<system->allMoleculeTypes.size(); t++)
+		system->allMoleculeTypes[t]->prepareForSimulation();
+	system->countSpeciesObservables();
+	system->evaluateAllLocalFunctions();
+
+	for(unsigned int r=0; r<rxns.size(); r++) {
+		rxns[r].rxn->fireCounter += rxnFired[r];
+		rxnFired[r] = 0;
+	}
+	system->recompute_A_tot();
+}
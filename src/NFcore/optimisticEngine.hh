@@ -0,0 +1,176 @@
+#ifndef NFOPTIMISTICENGINE_HH_
+#define NFOPTIMISTICENGINE_HH_
+
+#include <string>
+#include <vector>
+
+
+namespace NFcore
+{
+	class System;
+	class Molecule;
+	class MoleculeList;
+	class ReactionClass;
+	class ReactantList;
+	class MappingSet;
+	class TemplateMolecule;
+
+
+	//!  Experimental engine that runs the events of one System on several threads
+	/*!
+	    The regular loop in System::sim picks one event at a time from the reactant
+	    lists, and every event changes the lists the next one is picked from, so there
+	    is nothing to run ahead.  This engine instead draws candidate events that do
+	    not depend on the current state: a reaction is chosen in proportion to an
+	    upper bound on its propensity, and then a molecule at random for each
+	    reactant.  The bound is the rate times, for each reactant, the most mappings
+	    one molecule can give and the number of molecules whose own sites match the
+	    reactant pattern (TemplateMolecule::compareOwnSites), plus some headroom.
+	    These sets are only brought up to date between batches, with the molecules
+	    the events of the batch changed.  A molecule that comes to match a pattern
+	    during a batch is picked through the headroom: the picks past the end of the
+	    set go to the molecules outside it that earlier candidates of the batch
+	    changed, in the order they were changed.  Every event changes at most a few
+	    molecules, so the headroom covers all of them as long as the batch is short
+	    enough, and batches are cut short so that it adds at most a quarter to the
+	    bound.  When its turn comes, a candidate is matched against the reactant
+	    patterns and fires with the probability that the picked molecules (and
+	    mappings) really are reactants, otherwise it is thrown away.  This thinning gives every reactant tuple the rate of the reaction, as
+	    in the regular loop, so the trajectories are exact samples of the same SSA.
+
+	    Candidates are drawn in batches, with all of their random numbers, on the
+	    calling thread.  A candidate whose molecule fails the states and bonds its
+	    pattern asks of that molecule alone is thrown away right there, as long as no
+	    earlier candidate of the batch can have changed the molecule.  Every other
+	    candidate claims the complexes of its molecules, which hold everything that
+	    matching it or firing it can read or change, by stamping them with the batch
+	    and its place in the batch.  A candidate whose complexes
+	    were already claimed by an earlier one of the batch is deferred, and so is
+	    one with a pick in the headroom.  The others
+	    don't touch anything an earlier candidate touches, so they run at the same
+	    time, split over the threads by groups of reactions that share no
+	    TemplateMolecules (templates keep the state of a match).  Then the deferred
+	    candidates run on the calling thread, in time order.  The result is the same
+	    as running the whole batch in time order, and doesn't depend on the number of
+	    threads.
+
+	    Reactant lists and observables are not kept up to date while the engine runs.
+	    Observables are recounted for output, and the lists are rebuilt at the end, so
+	    the regular loop can carry on from the final state.  Only models the thinning
+	    covers are supported: elementary rate laws (BasicRxnClass, no TotalRate) with
+	    no populations, no connected-to (dot) patterns, and no rules that add or
+	    delete molecules.  Use isSupported() before running.
+	*/
+	class OptimisticEngine
+	{
+		public:
+			OptimisticEngine(System *s, int nThreads, int batchSize);
+			virtual ~OptimisticEngine();
+
+			//! Whether the model can be run by this engine, and if not, why not
+			bool isSupported() const { return unsupportedReason.empty(); };
+			std::string getUnsupportedReason() const { return unsupportedReason; };
+
+			//! Runs the system for the given time without output, then sets the clock back
+			virtual void equilibrate(double duration);
+
+			//! Runs the system, writing the observables sampleTimes times, like System::sim
+			virtual double sim(double duration, long int sampleTimes);
+
+		protected:
+
+			//! What happened to a candidate event
+			enum Outcome { PENDING = 0, REJECTED, NULL_EVENT, FIRED };
+
+			struct Candidate {
+				double time;
+				int rxn;
+				int firstReactant;   // index of its first molecule and pick in reactants and picks
+				bool deferred;
+				bool late;           // a molecule is picked from the headroom, see findEntrant()
+				int nTouched;        // the molecules it changed, from maxTouches times its place in touched
+				Outcome outcome;
+			};
+
+			//! Everything one reaction needs to match candidates, only used by one thread at a time
+			struct RxnState {
+				ReactionClass *rxn;
+				std::vector <MoleculeList *> molecules;     // the molecules of each reactant's type
+				std::vector <int> maxMappings;              // the most mapping sets per molecule and reactant
+				std::vector <int> patterns;                 // the pattern of each reactant, see eligible
+				std::vector <ReactantList *> lists;         // scratch lists the mappings are made in
+				std::vector <std::vector <MappingSet *> > kept;
+				std::vector <MappingSet *> symmetric;
+				MappingSet **chosen;
+				double bound;
+				int group;
+			};
+
+			void checkSupport();
+			void groupReactions();
+			virtual void advance(double stopTime);
+			void findPatterns(int nParts);
+			void checkEligible(Molecule *m, int part);
+			void moveEligible(Molecule *m, int from, int to);
+			double boundOf(int r, int part, int headroom) const;
+			int chooseBatchSize();
+			int recordTouched(RxnState &rs, Molecule **touchedNow) const;
+			Molecule *findEntrant(int c, int pattern, int index);
+			void updateEligible(int n);
+			int drawBatch(double stopTime, bool &reachedStop);
+			bool isClaimed(Molecule *m) const;
+			bool cannotMatch(int c) const;
+			bool claim(int c);
+			bool claimComplexOf(Molecule *m, int c);
+			void runBatch(int n);
+			void runCandidate(Candidate &c);
+			int mapReactant(RxnState &rs, int r, Molecule *m);
+			void clearScratch(RxnState &rs);
+			void rebuild();
+
+			System *system;
+			int nThreads;
+			int batchSize;
+			std::string unsupportedReason;
+
+			std::vector <RxnState> rxns;
+			std::vector <double> cumulativeBound;
+			double totalBound;
+			int nGroups;
+
+			std::vector <Candidate> batch;
+			std::vector <Molecule *> reactants;
+			std::vector <int> picks;
+			std::vector <std::vector <int> > buckets;
+
+			// claims, by complex id with complex bookkeeping and by molecule id without
+			std::vector <unsigned int> stampRound;
+			std::vector <int> stampOwner;
+			unsigned int round;
+			int nMoleculeIDs;
+
+			// the molecules whose own sites match each reactant pattern, by part of the
+			// volume (one here, one per subvolume in SubvolumeEngine) and then pattern,
+			// and the place of each molecule id in the set of its pattern, or -1
+			std::vector <TemplateMolecule *> patternTemplates;
+			std::vector <std::vector <int> > patternsOfType;
+			std::vector <std::vector <std::vector <Molecule *> > > eligible;
+			std::vector <std::vector <int> > eligibleSlot;
+
+			// the molecules each candidate of the batch changed, and the headroom for them
+			int maxTouches;
+			int headroom;
+			std::vector <Molecule *> touched;
+			std::vector <int> entrants;   // per reactant, its pick in the headroom or -1
+			std::vector <unsigned int> seenRound;
+			unsigned int seen;
+
+			// statistics for the report at the end of sim()
+			unsigned long long nCandidates, nScreened, nRejected, nNull, nFired, nDeferred, nWaves, waveWidth;
+			double waveTime, serialTime;
+			std::vector <unsigned long long> rxnFired;
+	};
+}
+
+
+#endif /*NFOPTIMISTICENGINE_HH_*/
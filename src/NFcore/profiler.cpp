@@ -0,0 +1,318 @@
+#include "NFcore.hh"
+
+#include <iomanip>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+
+using namespace std;
+using namespace NFcore;
+
+
+bool Profiler::enabled = false;
+unsigned long long Profiler::phaseTicks[Profiler::N_PHASES];
+unsigned long long Profiler::phaseCalls[Profiler::N_PHASES];
+vector <unsigned long long> Profiler::rxnPhaseTicks;
+vector <unsigned long long> Profiler::rxnFires;
+vector <unsigned long long> Profiler::rxnNullEvents;
+int Profiler::currentRxn = -1;
+unsigned long long Profiler::compareCalls = 0;
+unsigned long long Profiler::bfsCalls = 0;
+unsigned long long Profiler::bfsMolecules = 0;
+unsigned long Profiler::bfsMaxSize = 0;
+unsigned long long Profiler::startTicks = 0;
+clock_t Profiler::startClock = 0;
+string Profiler::reportFile = "";
+bool Profiler::countersEnabled = false;
+int Profiler::counterGroupFd = -1;
+int Profiler::counterSlot[Profiler::N_COUNTERS];
+int Profiler::nCounterSlots = 0;
+unsigned long long Profiler::phaseCounters[Profiler::N_PHASES][Profiler::N_COUNTERS];
+
+
+bool Profiler::isCompiledIn()
+{
+#ifdef NFSIM_PROFILE
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+bool Profiler::enable(const string &flag)
+{
+	if(!isCompiledIn()) {
+		cout<<"Warning: -"<<flag<<" was given, but this NFsim executable was built without the"<<endl;
+		cout<<"profiler.  Rebuild with NFSIM_PROFILE defined (cmake -DNFSIM_PROFILE=ON)."<<endl;
+		return false;
+	}
+	enabled = true;
+	reset();
+	return true;
+}
+
+
+bool Profiler::enableCounters()
+{
+	if(!enabled) return false;
+	if(countersEnabled) return true;
+	for(int c=0; c<N_COUNTERS; c++) counterSlot[c] = -1;
+	nCounterSlots = 0;
+
+#ifdef __linux__
+	// the first counter that opens leads the group, so that all of them are
+	// scheduled onto the PMU together and can be read with a single read()
+	unsigned long long config[N_COUNTERS];
+	unsigned int type[N_COUNTERS];
+	type[CYCLES] = PERF_TYPE_HARDWARE;        config[CYCLES] = PERF_COUNT_HW_CPU_CYCLES;
+	type[INSTRUCTIONS] = PERF_TYPE_HARDWARE;  config[INSTRUCTIONS] = PERF_COUNT_HW_INSTRUCTIONS;
+	type[L1D_MISSES] = PERF_TYPE_HW_CACHE;
+	config[L1D_MISSES] = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ<<8) | (PERF_COUNT_HW_CACHE_RESULT_MISS<<16);
+	type[LLC_MISSES] = PERF_TYPE_HW_CACHE;
+	config[LLC_MISSES] = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ<<8) | (PERF_COUNT_HW_CACHE_RESULT_MISS<<16);
+	type[BRANCH_MISSES] = PERF_TYPE_HARDWARE; config[BRANCH_MISSES] = PERF_COUNT_HW_BRANCH_MISSES;
+
+	int firstError = 0;
+	for(int c=0; c<N_COUNTERS; c++) {
+		struct perf_event_attr attr;
+		memset(&attr,0,sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type[c];
+		attr.config = config[c];
+		attr.read_format = PERF_FORMAT_GROUP;
+		attr.disabled = (counterGroupFd<0) ? 1 : 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		int fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, counterGroupFd, 0);
+		if(fd<0) {
+			if(firstError==0) firstError = errno;
+			continue;
+		}
+		if(counterGroupFd<0) counterGroupFd = fd;
+		counterSlot[c] = nCounterSlots++;
+	}
+
+	if(counterGroupFd<0) {
+		cout<<"Warning: -perfcounters was given, but the hardware counters could not be opened ("
+			<<strerror(firstError)<<")."<<endl;
+		cout<<"Check /proc/sys/kernel/perf_event_paranoid.  Profiling without the counters."<<endl;
+		return false;
+	}
+	for(int c=0; c<N_COUNTERS; c++) {
+		if(counterSlot[c]<0)
+			cout<<"Warning: the "<<counterName(c)<<" counter is not available on this machine."<<endl;
+	}
+	ioctl(counterGroupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(counterGroupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	countersEnabled = true;
+	for(int p=0; p<N_PHASES; p++)
+		for(int c=0; c<N_COUNTERS; c++) phaseCounters[p][c] = 0;
+	return true;
+#else
+	cout<<"Warning: -perfcounters was given, but hardware counters are only supported on Linux."<<endl;
+	cout<<"Profiling without the counters."<<endl;
+	return false;
+#endif
+}
+
+
+void Profiler::readCounterGroup(unsigned long long *values)
+{
+#ifdef __linux__
+	// a group read returns the number of counters followed by their values
+	unsigned long long buffer[N_COUNTERS+1];
+	if(read(counterGroupFd, buffer, sizeof(buffer)) < (ssize_t)((nCounterSlots+1)*sizeof(unsigned long long))) {
+		for(int c=0; c<N_COUNTERS; c++) values[c] = 0;
+		return;
+	}
+	for(int c=0; c<N_COUNTERS; c++)
+		values[c] = (counterSlot[c]>=0) ? buffer[1+counterSlot[c]] : 0;
+#else
+	for(int c=0; c<N_COUNTERS; c++) values[c] = 0;
+#endif
+}
+
+
+void Profiler::addCounters(int phase, const unsigned long long *startCounters)
+{
+	unsigned long long now[N_COUNTERS];
+	readCounterGroup(now);
+	for(int c=0; c<N_COUNTERS; c++)
+		phaseCounters[phase][c] += now[c]-startCounters[c];
+}
+
+
+void Profiler::reset()
+{
+	for(int p=0; p<N_PHASES; p++) {
+		phaseTicks[p] = 0;
+		phaseCalls[p] = 0;
+		for(int c=0; c<N_COUNTERS; c++) phaseCounters[p][c] = 0;
+	}
+	rxnPhaseTicks.assign(rxnPhaseTicks.size(), 0);
+	rxnFires.assign(rxnFires.size(), 0);
+	rxnNullEvents.assign(rxnNullEvents.size(), 0);
+	currentRxn = -1;
+	compareCalls = 0;
+	bfsCalls = 0;
+	bfsMolecules = 0;
+	bfsMaxSize = 0;
+	startTicks = ticks();
+	startClock = clock();
+}
+
+
+void Profiler::growRxnTables(int n_rxns)
+{
+	rxnPhaseTicks.resize(n_rxns*N_PHASES, 0);
+	rxnFires.resize(n_rxns, 0);
+	rxnNullEvents.resize(n_rxns, 0);
+}
+
+
+const char * Profiler::phaseName(int phase)
+{
+	switch(phase) {
+		case SELECT:                return "select (getNextRxn)";
+		case PICK_MAPPING_SETS:     return "pickMappingSets";
+		case CHECK_MOLECULARITY:    return "checkMolecularity";
+		case GET_PRODUCTS:          return "getListOfProducts";
+		case OBS_REMOVE:            return "observables remove";
+		case TRANSFORM:             return "transform";
+		case OBS_ADD:               return "observables add";
+		case UPDATE_RXN_MEMBERSHIP: return "updateRxnMembership";
+		case TYPEII_FUNCTIONS:      return "type II functions";
+		case OUTPUT:                return "output";
+	}
+	return "unknown";
+}
+
+
+const char * Profiler::counterName(int counter)
+{
+	switch(counter) {
+		case CYCLES:        return "cycles";
+		case INSTRUCTIONS:  return "instructions";
+		case L1D_MISSES:    return "L1D misses";
+		case LLC_MISSES:    return "LLC misses";
+		case BRANCH_MISSES: return "branch misses";
+	}
+	return "unknown";
+}
+
+
+void Profiler::report(System *s)
+{
+	report(s, cout);
+	if(!reportFile.empty()) {
+		ofstream out(reportFile.c_str());
+		if(!out.is_open()) {
+			cerr<<"Could not open the profile report file: "<<reportFile<<endl;
+			return;
+		}
+		report(s, out);
+		out.close();
+		cout<<"   profile written to: "<<reportFile<<endl;
+	}
+}
+
+
+void Profiler::report(System *s, ostream &o)
+{
+	// estimate the length of a tick from the CPU clock over the whole run
+	unsigned long long totalTicks = ticks()-startTicks;
+	double cpuSeconds = ((double)(clock()-startClock))/CLOCKS_PER_SEC;
+	double secPerTick = (totalTicks>0) ? cpuSeconds/(double)totalTicks : 0;
+
+	unsigned long long profiledTicks = 0;
+	for(int p=0; p<N_PHASES; p++) profiledTicks += phaseTicks[p];
+
+	ios_base::fmtflags oldFlags = o.flags();
+	streamsize oldPrecision = o.precision();
+	o.unsetf(ios::scientific);
+	o<<fixed<<setprecision(2);
+
+	o<<"\n   profile by phase (ticks are cycle counter units, ~"
+	 <<setprecision(3)<<(secPerTick>0 ? 1e-9/secPerTick : 0)<<" GHz)"<<endl;
+	o<<setprecision(2);
+	o<<"   "<<left<<setw(24)<<"phase"<<right<<setw(14)<<"calls"<<setw(16)<<"ticks/call"
+	 <<setw(12)<<"seconds"<<setw(9)<<"%"<<endl;
+	for(int p=0; p<N_PHASES; p++) {
+		if(phaseCalls[p]==0) continue;
+		o<<"   "<<left<<setw(24)<<phaseName(p)<<right<<setw(14)<<phaseCalls[p]
+		 <<setw(16)<<((double)phaseTicks[p]/(double)phaseCalls[p])
+		 <<setw(12)<<setprecision(4)<<(phaseTicks[p]*secPerTick)<<setprecision(2)
+		 <<setw(9)<<(profiledTicks>0 ? 100.0*phaseTicks[p]/(double)profiledTicks : 0)<<endl;
+	}
+
+	if(countersEnabled) reportCounters(o);
+
+	unsigned long long events = 0;
+	for(unsigned int r=0; r<rxnFires.size(); r++) events += rxnFires[r];
+	o<<"\n   TemplateMolecule::compare calls: "<<compareCalls;
+	if(events>0) o<<"  ("<<((double)compareCalls/(double)events)<<" per event)";
+	o<<endl;
+	o<<"   breadth first searches: "<<bfsCalls;
+	if(bfsCalls>0) o<<"  (mean size "<<((double)bfsMolecules/(double)bfsCalls)<<", max size "<<bfsMaxSize<<")";
+	o<<endl;
+
+	// rank the rules by the total time spent firing them
+	vector < pair <unsigned long long, int> > ranked;
+	for(unsigned int r=0; r<rxnFires.size(); r++) {
+		unsigned long long t = 0;
+		for(int p=0; p<N_PHASES; p++) t += rxnPhaseTicks[r*N_PHASES+p];
+		if(rxnFires[r]>0) ranked.push_back(make_pair(t,(int)r));
+	}
+	sort(ranked.rbegin(), ranked.rend());
+
+	const unsigned int maxRulesToShow = 10;
+	o<<"\n   most costly rules:"<<endl;
+	o<<"   "<<left<<setw(32)<<"rule"<<right<<setw(12)<<"fired"<<setw(10)<<"null"
+	 <<setw(14)<<"ticks/fire"<<setw(9)<<"%"<<"  slowest phase"<<endl;
+	for(unsigned int i=0; i<ranked.size() && i<maxRulesToShow; i++) {
+		int r = ranked[i].second;
+		int worst = 0;
+		for(int p=1; p<N_PHASES; p++)
+			if(rxnPhaseTicks[r*N_PHASES+p] > rxnPhaseTicks[r*N_PHASES+worst]) worst = p;
+		string name = (s!=0 && r<s->getNumOfReactions()) ? s->getReaction(r)->getName() : "?";
+		o<<"   "<<left<<setw(32)<<name<<right<<setw(12)<<rxnFires[r]<<setw(10)<<rxnNullEvents[r]
+		 <<setw(14)<<((double)ranked[i].first/(double)rxnFires[r])
+		 <<setw(9)<<(profiledTicks>0 ? 100.0*ranked[i].first/(double)profiledTicks : 0)
+		 <<"  "<<phaseName(worst)<<endl;
+	}
+	if(ranked.size()>maxRulesToShow)
+		o<<"   ... and "<<(ranked.size()-maxRulesToShow)<<" more rules"<<endl;
+	o<<endl;
+
+	o.flags(oldFlags);
+	o.precision(oldPrecision);
+}
+
+
+void Profiler::reportCounters(ostream &o)
+{
+	o<<"\n   hardware counters by phase (user space events per call)"<<endl;
+	o<<"   "<<left<<setw(24)<<"phase"<<right;
+	for(int c=0; c<N_COUNTERS; c++) o<<setw(14)<<counterName(c);
+	o<<setw(8)<<"IPC"<<endl;
+	for(int p=0; p<N_PHASES; p++) {
+		if(phaseCalls[p]==0) continue;
+		o<<"   "<<left<<setw(24)<<phaseName(p)<<right;
+		for(int c=0; c<N_COUNTERS; c++) {
+			if(counterSlot[c]<0) o<<setw(14)<<"-";
+			else o<<setw(14)<<((double)phaseCounters[p][c]/(double)phaseCalls[p]);
+		}
+		if(counterSlot[CYCLES]>=0 && counterSlot[INSTRUCTIONS]>=0 && phaseCounters[p][CYCLES]>0)
+			o<<setw(8)<<((double)phaseCounters[p][INSTRUCTIONS]/(double)phaseCounters[p][CYCLES]);
+		else o<<setw(8)<<"-";
+		o<<endl;
+	}
+}
@@ -0,0 +1,201 @@
+#ifndef NFPROFILER_HH_
+#define NFPROFILER_HH_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+namespace NFcore
+{
+	class System;
+
+
+	//!  Per-phase cycle-counter profiler for the simulation hot path
+	/*!
+	    The profiler keeps a running total of cycle-counter ticks spent in each
+	    phase of the main loop (reaction selection, the steps of ReactionClass::fire
+	    and output), broken down per ReactionClass, together with the number of
+	    calls to TemplateMolecule::compare and the sizes of the breadth first
+	    searches through molecule complexes.  A summary naming the most costly
+	    rules is printed at the end of System::sim when the -profile flag is given.
+
+	    With -perfcounters, the hardware performance counters of the CPU (cycles,
+	    instructions, L1 data cache and last level cache read misses, and branch
+	    mispredictions) are also read at the start and end of every phase through
+	    the Linux perf_event_open interface, and reported per phase.  Only user
+	    space events of the NFsim process are counted.  If the counters can not be
+	    opened (not Linux, no permission, or a virtual machine without a PMU) a
+	    warning is printed and the profile is reported without them.
+
+	    The instrumentation is only compiled in when NFsim is built with the
+	    NFSIM_PROFILE definition (cmake -DNFSIM_PROFILE=ON).  Otherwise all of the
+	    NF_PROFILE_* macros below expand to nothing, so the regular build pays no
+	    cost at all.
+	*/
+	class Profiler
+	{
+		public:
+
+			//! Phases of the main simulation loop that are timed separately
+			enum Phase {
+				SELECT = 0,              // System::getNextRxn
+				PICK_MAPPING_SETS,       // ReactionClass::pickMappingSets
+				CHECK_MOLECULARITY,      // TransformationSet::checkMolecularity
+				GET_PRODUCTS,            // getListOfProducts and product complexes
+				OBS_REMOVE,              // removing products from observables
+				TRANSFORM,               // TransformationSet::transform
+				OBS_ADD,                 // adding products back to observables
+				UPDATE_RXN_MEMBERSHIP,   // Molecule::updateRxnMembership
+				TYPEII_FUNCTIONS,        // complex-scoped (type II) local functions
+				OUTPUT,                  // System::outputAllObservableCounts
+				N_PHASES
+			};
+
+			//! Hardware events read from the perf_event counters
+			enum Counter {
+				CYCLES = 0,
+				INSTRUCTIONS,
+				L1D_MISSES,
+				LLC_MISSES,
+				BRANCH_MISSES,
+				N_COUNTERS
+			};
+
+			//! Turns the profiler on.  Returns false, warning about the given flag, if NFsim was built without it.
+			static bool enable(const string &flag="profile");
+			static bool isCompiledIn();
+
+			//! Opens the hardware counters.  Returns false, and leaves them off, if they are not available
+			static bool enableCounters();
+
+			//! Clears all of the accumulated counts and restarts the clock
+			static void reset();
+
+			//! Prints the summary for the system, and also writes it to a file if one was set
+			static void report(System *s);
+			static void report(System *s, std::ostream &o);
+			static void setReportFile(std::string filename) { reportFile = filename; };
+
+			//! Reads the cycle counter (or the closest portable substitute)
+			static inline unsigned long long ticks()
+			{
+#if defined(__x86_64__) || defined(__i386__)
+				return __rdtsc();
+#elif defined(__aarch64__)
+				unsigned long long v;
+				asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+				return v;
+#else
+				return (unsigned long long) clock();
+#endif
+			};
+
+			static inline void setCurrentRxn(int rxnId)
+			{
+				currentRxn = rxnId;
+				if(rxnId >= (int)rxnFires.size()) growRxnTables(rxnId+1);
+				rxnFires[rxnId]++;
+			};
+
+			//! Reads the current value of each hardware counter into values, if they are on
+			static inline void readCounters(unsigned long long *values)
+			{
+				if(countersEnabled) readCounterGroup(values);
+			};
+
+			static inline void addGlobal(int phase, unsigned long long start, const unsigned long long *startCounters)
+			{
+				phaseTicks[phase] += ticks()-start;
+				phaseCalls[phase]++;
+				if(countersEnabled) addCounters(phase,startCounters);
+			};
+
+			static inline void addToRxn(int phase, unsigned long long start, const unsigned long long *startCounters)
+			{
+				unsigned long long t = ticks()-start;
+				phaseTicks[phase] += t;
+				phaseCalls[phase]++;
+				rxnPhaseTicks[currentRxn*N_PHASES+phase] += t;
+				if(countersEnabled) addCounters(phase,startCounters);
+			};
+
+			static inline void countNullEvent() { rxnNullEvents[currentRxn]++; };
+			static inline void countCompare() { compareCalls++; };
+			static inline void countBFS(unsigned long size)
+			{
+				bfsCalls++;
+				bfsMolecules += size;
+				if(size > bfsMaxSize) bfsMaxSize = size;
+			};
+
+			static bool enabled;
+			static bool countersEnabled;
+
+		protected:
+			static void growRxnTables(int n_rxns);
+			static const char * phaseName(int phase);
+			static const char * counterName(int counter);
+			static void readCounterGroup(unsigned long long *values);
+			static void addCounters(int phase, const unsigned long long *startCounters);
+			static void reportCounters(std::ostream &o);
+
+			static unsigned long long phaseTicks[N_PHASES];
+			static unsigned long long phaseCalls[N_PHASES];
+			static std::vector <unsigned long long> rxnPhaseTicks;
+			static std::vector <unsigned long long> rxnFires;
+			static std::vector <unsigned long long> rxnNullEvents;
+			static int currentRxn;
+
+			static unsigned long long compareCalls;
+			static unsigned long long bfsCalls;
+			static unsigned long long bfsMolecules;
+			static unsigned long bfsMaxSize;
+
+			static unsigned long long startTicks;
+			static clock_t startClock;
+			static std::string reportFile;
+
+			// file descriptor of the perf_event group leader, and for each
+			// counter its position in a group read, or -1 if it could not be opened
+			static int counterGroupFd;
+			static int counterSlot[N_COUNTERS];
+			static int nCounterSlots;
+			static unsigned long long phaseCounters[N_PHASES][N_COUNTERS];
+	};
+}
+
+
+#ifdef NFSIM_PROFILE
+#define NF_PROFILE_START(t) unsigned long long t##Counters[NFcore::Profiler::N_COUNTERS]; \
+	if(NFcore::Profiler::enabled) NFcore::Profiler::readCounters(t##Counters); \
+	unsigned long long t = NFcore::Profiler::enabled ? NFcore::Profiler::ticks() : 0
+#define NF_PROFILE_STOP(phase,t) do { if(NFcore::Profiler::enabled) NFcore::Profiler::addToRxn(NFcore::Profiler::phase,t,t##Counters); } while(0)
+#define NF_PROFILE_STOP_GLOBAL(phase,t) do { if(NFcore::Profiler::enabled) NFcore::Profiler::addGlobal(NFcore::Profiler::phase,t,t##Counters); } while(0)
+#define NF_PROFILE_RXN(rxnId) do { if(NFcore::Profiler::enabled) NFcore::Profiler::setCurrentRxn(rxnId); } while(0)
+#define NF_PROFILE_NULL_EVENT() do { if(NFcore::Profiler::enabled) NFcore::Profiler::countNullEvent(); } while(0)
+#define NF_PROFILE_COMPARE() do { if(NFcore::Profiler::enabled) NFcore::Profiler::countCompare(); } while(0)
+#define NF_PROFILE_BFS_BEGIN(v) unsigned long v = 1
+#define NF_PROFILE_BFS_VISIT(v) v++
+#define NF_PROFILE_BFS_END(v) do { if(NFcore::Profiler::enabled) NFcore::Profiler::countBFS(v); } while(0)
+#define NF_PROFILE_REPORT(s) do { if(NFcore::Profiler::enabled) NFcore::Profiler::report(s); } while(0)
+#else
+#define NF_PROFILE_START(t)
+#define NF_PROFILE_STOP(phase,t)
+#define NF_PROFILE_STOP_GLOBAL(phase,t)
+#define NF_PROFILE_RXN(rxnId)
+#define NF_PROFILE_NULL_EVENT()
+#define NF_PROFILE_COMPARE()
+#define NF_PROFILE_BFS_BEGIN(v)
+#define NF_PROFILE_BFS_VISIT(v)
+#define NF_PROFILE_BFS_END(v)
+#define NF_PROFILE_REPORT(s)
+#endif
+
+
+#endif /* NFPROFILER_HH_ */
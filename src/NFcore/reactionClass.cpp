@@ -373,16 +373,23 @@ void ReactionClass::fire(double random_A_number) {
 string ReactionClass::fire(double random_A_number, bool track) {
 	//cout<<endl<<">FIRE "<<getName()<<endl;
 	fireCounter++;
+	NF_PROFILE_RXN(rxnId);
 
 
 	// First randomly pick the reactants to fire by selecting the MappingSets
+	NF_PROFILE_START(profPick);
 	this->pickMappingSets(random_A_number);
+	NF_PROFILE_STOP(PICK_MAPPING_SETS,profPick);
 
 
 	// Check reactants for correct molecularity:
-	if ( ! transformationSet->checkMolecularity(mappingSet) ) {
+	NF_PROFILE_START(profMolecularity);
+	bool molecularityOk = transformationSet->checkMolecularity(mappingSet);
+	NF_PROFILE_STOP(CHECK_MOLECULARITY,profMolecularity);
+	if ( ! molecularityOk ) {
 		// wrong molecularity!  this is a NULL event
 		++(System::NULL_EVENT_COUNTER);
+		NF_PROFILE_NULL_EVENT();
 		// AS2023 - we need to return a string now that this can return 
 		// an event log if track is true
 		return string("");
@@ -404,9 +411,12 @@ string ReactionClass::fire(double random_A_number, bool track) {
 
 	// Generate the set of possible products that we need to update
 	// (excluding new molecules, we'll get those later --Justin)
+	NF_PROFILE_START(profProducts);
 	this->transformationSet->getListOfProducts(mappingSet,products,traversalLimit);
+	NF_PROFILE_STOP(GET_PRODUCTS,profProducts);
 
 	// Loop through the products (excluding added molecules) and remove from observables
+	NF_PROFILE_START(profObsRemove);
 	if (this->onTheFlyObservables) {
 
 		// molecule observables..
@@ -414,7 +424,7 @@ string ReactionClass::fire(double random_A_number, bool track) {
 			(*molIter)->removeFromObservables();
 
 		// species observables..
-		if(system->getNumOfSpeciesObs()>0) {
+		if(system->getNumOfOnTheFlySpeciesObs()>0) {
 			// we can find reactant complexes by following mappingSets to target molecules
 			int matches = 0;
 			Complex * c;
@@ -425,9 +435,9 @@ string ReactionClass::fire(double random_A_number, bool track) {
 					// complex has not been updated, so do it now.
 					updatedComplexes.push_back(complexId);
 					c = mappingSet[k]->get(0)->getMolecule()->getComplex();
-					for(int i=0; i<system->getNumOfSpeciesObs(); i++) {
-						matches = system->getSpeciesObs(i)->isObservable(c);
-						system->getSpeciesObs(i)->straightSubtract(matches);
+					for(int i=0; i<system->getNumOfOnTheFlySpeciesObs(); i++) {
+						matches = system->getOnTheFlySpeciesObs(i)->isObservable(c);
+						system->getOnTheFlySpeciesObs(i)->straightSubtract(matches);
 					}
 				}
 			}
@@ -444,29 +454,38 @@ string ReactionClass::fire(double random_A_number, bool track) {
 					// complex has not been updated, so do it now.
 					updatedComplexes.push_back(complexId);
 					c = addmol->getComplex();
-					for (int i=0; i < system->getNumOfSpeciesObs(); i++) {
-						matches = system->getSpeciesObs(i)->isObservable(c);
-						system->getSpeciesObs(i)->straightSubtract(matches);
+					for (int i=0; i < system->getNumOfOnTheFlySpeciesObs(); i++) {
+						matches = system->getOnTheFlySpeciesObs(i)->isObservable(c);
+						system->getOnTheFlySpeciesObs(i)->straightSubtract(matches);
 					}
 				}
 			}
 			updatedComplexes.clear();
 		}
 	}
+	NF_PROFILE_STOP(OBS_REMOVE,profObsRemove);
 
 	// Through the MappingSet, transform all the molecules as neccessary
 	//  This will also create new molecules, as required.  As a side effect,
 	//  deleted molecules will be removed from observables.
 	// AS2023 - if tracking is turned on, transform needs a string to build up
 	string logstr;
+	NF_PROFILE_START(profTransform);
 	if (this->system->getReactionTrackingStatus()) {
 		logstr = this->transformationSet->transform(this->mappingSet, true);
 		
 	} else {
 		logstr = this->transformationSet->transform(this->mappingSet);
 	}
+	NF_PROFILE_STOP(TRANSFORM,profTransform);
+
+	// From here on the molecules don't change until the next event, so matches
+	// of the same pattern to the same molecule can be shared by everything that
+	// gets updated (see TemplateMolecule::startMatchEvent)
+	TemplateMolecule::startMatchEvent();
 
 	// Add newly created molecules to the list of products
+	NF_PROFILE_START(profAddedProducts);
 	this->transformationSet->getListOfAddedMolecules(mappingSet,products,traversalLimit);
 
 	// if complex bookkeeping is on, find all product complexes
@@ -484,9 +503,11 @@ string ReactionClass::fire(double random_A_number, bool track) {
 				productComplexes.push_back(complex);
 		}
 	}
+	NF_PROFILE_STOP(GET_PRODUCTS,profAddedProducts);
 
 
 	// If we're handling observables on the fly, tell each molecule to add itself to observables.
+	NF_PROFILE_START(profObsAdd);
 	if (onTheFlyObservables) {
 
 		// molecule observables..
@@ -497,7 +518,7 @@ string ReactionClass::fire(double random_A_number, bool track) {
 		}
 
 		// species observables..
-		if (system->getNumOfSpeciesObs()>0) {
+		if (system->getNumOfOnTheFlySpeciesObs()>0) {
 			Complex * c;
 			int matches;
 			// we can assume that complex bookkeeping is enabled..
@@ -505,9 +526,9 @@ string ReactionClass::fire(double random_A_number, bool track) {
 				// update all species observables for this complex
 				c = *complexIter;
 				matches = 0;
-				for ( int i=0; i < system->getNumOfSpeciesObs(); i++ ) {
-					matches = system->getSpeciesObs(i)->isObservable(c);
-					system->getSpeciesObs(i)->straightAdd(matches);
+				for ( int i=0; i < system->getNumOfOnTheFlySpeciesObs(); i++ ) {
+					matches = system->getOnTheFlySpeciesObs(i)->isObservable(c);
+					system->getOnTheFlySpeciesObs(i)->straightAdd(matches);
 				}
 			}
 
@@ -515,9 +536,11 @@ string ReactionClass::fire(double random_A_number, bool track) {
 			//  among the product molecules
 		}
 	}
+	NF_PROFILE_STOP(OBS_ADD,profObsAdd);
 
 	// Now update reaction membership, functions, and update any DOR Groups
 	//  also, gather a list of typeII dependencies that will require updating
+	NF_PROFILE_START(profMembership);
 	typeII_products.clear();
 	for ( molIter = products.begin(); molIter != products.end(); molIter++ ) {
 		Molecule * mol = *molIter;
@@ -537,9 +560,11 @@ string ReactionClass::fire(double random_A_number, bool track) {
 		if ( mol->isAlive() )
 			mol->updateRxnMembership(this, useConnectivity);
 	}
+	NF_PROFILE_STOP(UPDATE_RXN_MEMBERSHIP,profMembership);
 
 	// update complex-scoped local functions for typeII dependencies
 	// NOTE: as a side-effect, dependent DOR reactions (via typeI molecule dependencies) will be updated
+	NF_PROFILE_START(profTypeII);
 	if (system->getEvaluateComplexScopedLocalFunctions()) {
 		// for each typeII product molecule, update all dependent local functions
 		if (system->isUsingComplex()) {
@@ -573,6 +598,8 @@ string ReactionClass::fire(double random_A_number, bool track) {
 			}
 		}
 	} // done updating complex-scoped local functions
+	NF_PROFILE_STOP(TYPEII_FUNCTIONS,profTypeII);
+	TemplateMolecule::endMatchEvent();
 
 	// update the last reaction firing time
 	// this is written to molecule_type_list.tsv at the end of the simulation
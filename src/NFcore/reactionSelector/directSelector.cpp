@@ -46,6 +46,13 @@ double DirectSelector::refactorPropensities()
 }
 
 
+double DirectSelector::restorePropensities(double Atot)
+{
+	this->Atot = Atot;
+	return Atot;
+}
+
+
 double DirectSelector::update(ReactionClass *r,double oldA, double newA)
 {
 	Atot-=oldA;
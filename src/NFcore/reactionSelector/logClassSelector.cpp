@@ -231,6 +231,30 @@ double LogClassSelector::refactorPropensities()
 }
 
 
+double LogClassSelector::restorePropensities(double Atot)
+{
+	//Same as refactorPropensities(), but the reactions already hold their a
+	int trla_index=0;
+	ReactionClass **tempRxnListArray = new ReactionClass *[n_reactions];
+	for(int i=-(totalLogClassCount-1)/2; i<=(totalLogClassCount-1)/2; i++) {
+		for(int k=0; k<logClassSize[i]; k++) {
+			tempRxnListArray[trla_index++] = logClassList[i][k];
+			logClassList[i][k] = 0;
+		}
+		logClassSize[i]=0;
+		logClassPropensity[i]=0;
+	}
+	for(int r=0; r<n_reactions; r++) {
+		double current_a = tempRxnListArray[r]->get_a();
+		place(tempRxnListArray[r],calculateClass(current_a),current_a);
+	}
+	delete [] tempRxnListArray;
+
+	this->Atot = Atot;
+	return Atot;
+}
+
+
 double LogClassSelector::update(ReactionClass *r,double oldA, double newA)
 {
 	int oldClass = mapRxnIdToLogClass[r->getRxnId()];
@@ -34,6 +34,9 @@ namespace NFcore
 
 			virtual double refactorPropensities() = 0;
 
+			// takes the sums back from the propensities the reactions hold and the total
+			// kept with them by System::snapshot(), without calling update_a()
+			virtual double restorePropensities(double Atot) = 0;
 
 			virtual double update(ReactionClass *r,double oldA, double newA) = 0;
 			virtual double getNextReactionClass(ReactionClass *&rc) = 0;
@@ -50,7 +53,7 @@ namespace NFcore
 			virtual ~DirectSelector();
 
 			virtual double refactorPropensities();
-
+			virtual double restorePropensities(double Atot);
 
 			virtual double update(ReactionClass *r,double oldA, double newA);
 			virtual double getNextReactionClass(ReactionClass *&rc);
@@ -73,7 +76,7 @@ namespace NFcore
 			virtual ~LogClassSelector();
 
 			virtual double refactorPropensities();
-
+			virtual double restorePropensities(double Atot);
 
 			virtual double update(ReactionClass *r,double oldA, double newA);
 			virtual double getNextReactionClass(ReactionClass *&rc);
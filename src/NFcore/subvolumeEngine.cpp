@@ -0,0 +1,353 @@
+#include "NFcore.hh"
+
+#include <cmath>
+#include <limits>
+
+
+using namespace std;
+using namespace NFcore;
+
+
+SubvolumeEngine::SubvolumeEngine(System *s, int nPerSide, int nDimensions, double hopRate)
+	: OptimisticEngine(s,1,1)
+{
+	this->nPerSide = nPerSide>0 ? nPerSide : 1;
+	this->nDimensions = nDimensions==2 ? 2 : 3;
+	this->nSubvolumes = (int)pow((double)this->nPerSide,(double)this->nDimensions);
+	this->hopRate = hopRate>0 ? hopRate : 0;
+	nHops = nHopTries = 0;
+	if(!isSupported()) return;
+
+	//The rates are for the whole volume, and each subvolume is a part of it
+	for(unsigned int r=0; r<rxns.size(); r++)
+		rateScale.push_back(pow((double)nSubvolumes,(double)rxns[r].rxn->n_reactants-1.0));
+
+	subvolumeOf.assign(nMoleculeIDs,-1);
+	slotOf.assign(nMoleculeIDs,-1);
+	contents.assign(nSubvolumes,vector <vector <Molecule *> > (system->allMoleculeTypes.size()));
+	moleculeCount.assign(nSubvolumes,0);
+	rxnBound.assign(nSubvolumes,vector <double> (rxns.size(),0));
+	totalRate.assign(nSubvolumes,0);
+	touched.resize(maxTouches);
+	findPatterns(nSubvolumes);
+	placeComplexes();
+
+	nextTime.assign(nSubvolumes,0);
+	heap.resize(nSubvolumes);
+	heapPos.resize(nSubvolumes);
+	for(int v=0; v<nSubvolumes; v++) {
+		heap[v] = v;
+		heapPos[v] = v;
+	}
+	for(int v=0; v<nSubvolumes; v++) {
+		updateRates(v);
+		schedule(v,system->current_time-log(NFutil::RANDOM_OPEN())/totalRate[v]);
+	}
+}
+
+
+SubvolumeEngine::~SubvolumeEngine()
+{
+}
+
+
+void SubvolumeEngine::placeComplexes()
+{
+	//Every complex goes to a random subvolume, all of its molecules together
+	for(unsigned int t=0; t<system->allMoleculeTypes.size(); t++) {
+		MoleculeList *ml = system->allMoleculeTypes[t]->getMoleculeList();
+		for(int i=0; i<ml->size(); i++) {
+			if(subvolumeOf[ml->at(i)->getUniqueID()]>=0) continue;
+			list <Molecule *> members;
+			ml->at(i)->traverseBondedNeighborhood(members,ReactionClass::NO_LIMIT);
+			int v = NFutil::RANDOM_INT(0,nSubvolumes);
+			for(list <Molecule *>::iterator it=members.begin(); it!=members.end(); it++) {
+				addToSubvolume(*it,v);
+				checkEligible(*it,v);
+			}
+		}
+	}
+}
+
+
+void SubvolumeEngine::equilibrate(double duration)
+{
+	if(duration<=0) return;
+	double startTime = system->current_time;
+	bool onTheFly = system->onTheFlyObservables;
+	system->onTheFlyObservables = false;
+
+	advance(startTime+duration);
+
+	system->onTheFlyObservables = onTheFly;
+	rebuild();
+	system->current_time = startTime;
+
+	//the order of the subvolumes in the queue stays the same
+	for(int v=0; v<nSubvolumes; v++) nextTime[v] -= duration;
+}
+
+
+double SubvolumeEngine::sim(double duration, long int sampleTimes)
+{
+	System::NULL_EVENT_COUNTER=0;
+	cout.setf(ios::scientific);
+	cout<<"simulating system for: "<<duration<<" second(s) in "<<nSubvolumes<<" subvolumes ";
+	cout<<"("<<nPerSide<<" per side in "<<nDimensions<<"D), where complexes jump at "<<hopRate<<"/s to each neighbour."<<endl;
+	cout<<"\n";
+	if(sampleTimes<1) sampleTimes = 1;
+
+	nCandidates = nRejected = nNull = nFired = nHops = nHopTries = 0;
+	rxnFired.assign(rxns.size(),0);
+
+	clock_t start = clock();
+
+	// observables are recounted for every output, since the events don't update them
+	bool onTheFly = system->onTheFlyObservables;
+	system->onTheFlyObservables = false;
+
+	double startTime = system->current_time;
+	double dSampleTime = duration / sampleTimes;
+	setComplexPositions();
+	system->outputAllObservableCounts(startTime,system->globalEventCounter);
+	unsigned long long lastEvents = 0;
+	for(long int step=1; step<=sampleTimes; step++)
+	{
+		double sampleTime = startTime+dSampleTime*(double)step;
+		advance(sampleTime);
+		setComplexPositions();
+		system->outputAllObservableCounts(sampleTime,system->globalEventCounter);
+
+		cout << "Sim time: " << sampleTime;
+		cout << "\tCPU time (total): " << ((double) (clock() - start) / (double) CLOCKS_PER_SEC) << "s";
+		cout << "\t events (step): " << (nFired+nNull-lastEvents) << endl;
+		lastEvents = nFired+nNull;
+	}
+
+	system->onTheFlyObservables = onTheFly;
+	rebuild();
+
+	unsigned long long iteration = nFired+nNull;
+	System::NULL_EVENT_COUNTER += nNull;
+	system->printRunSummary(iteration,start,true);
+	cout<<"   Subvolume engine: "<<nHops<<" jumps between subvolumes, ";
+	cout<<100.0*(double)nRejected/(double)max(nCandidates,1ULL)<<"% of "<<nCandidates<<" candidate reactions ";
+	cout<<"and "<<100.0*(double)(nHopTries-nHops)/(double)max(nHopTries,1ULL)<<"% of "<<nHopTries<<" candidate jumps rejected"<<endl;
+	cout.unsetf(ios::scientific);
+	return system->current_time;
+}
+
+
+void SubvolumeEngine::advance(double stopTime)
+{
+	//The next event of a subvolume that is past the stopping time is kept, since
+	//the waiting times are memoryless
+	while(nextTime[heap[0]]<=stopTime)
+	{
+		int v = heap[0];
+		system->current_time = nextTime[v];
+		runEvent(v);
+	}
+	system->current_time = stopTime;
+}
+
+
+void SubvolumeEngine::runEvent(int v)
+{
+	int to = -1;
+	double pick = NFutil::RANDOM(totalRate[v]);
+	unsigned int r = 0;
+	for(; r<rxns.size(); r++) {
+		if(pick<rxnBound[v][r]) break;
+		pick -= rxnBound[v][r];
+	}
+	bool changed = false;
+	if(r<rxns.size()) changed = react(v,r);
+	else if(nPerSide>1 && hopRate>0) to = hop(v);
+
+	//A reaction changes the rates of its subvolume, a jump those of the
+	//subvolume left and of the one reached
+	double now = system->current_time;
+	if(changed || to>=0) updateRates(v);
+	if(to>=0) {
+		updateRates(to);
+		schedule(to,now-log(NFutil::RANDOM_OPEN())/totalRate[to]);
+	}
+	schedule(v,now-log(NFutil::RANDOM_OPEN())/totalRate[v]);
+}
+
+
+bool SubvolumeEngine::react(int v, int r)
+{
+	//Thinning as in OptimisticEngine::runCandidate(), with molecules of this subvolume
+	RxnState &rs = rxns[r];
+	nCandidates++;
+	bool matched = true, fired = false;
+	for(unsigned int j=0; j<rs.molecules.size() && matched; j++) {
+		vector <Molecule *> &here = eligible[v][rs.patterns[j]];
+		Molecule *m = here[NFutil::RANDOM_INT(0,here.size())];
+		reactants.push_back(m);
+		int pick = rs.maxMappings[j]>1 ? NFutil::RANDOM_INT(0,rs.maxMappings[j]) : 0;
+		if(pick>=mapReactant(rs,j,m)) matched = false;
+		else rs.chosen[j] = rs.kept[j][pick];
+	}
+
+	//The bound scaled every reactant up as if it came from its own complex.  Reactants
+	//of one complex only get the rate of the model, as in the well mixed volume.
+	if(matched && rs.molecules.size()>1) {
+		round++;
+		int distinct = 0;
+		for(unsigned int j=0; j<reactants.size(); j++) {
+			if(isClaimed(reactants[j])) continue;
+			claimComplexOf(reactants[j],j);
+			distinct++;
+		}
+		if(distinct<(int)reactants.size() &&
+				NFutil::RANDOM(1.0)>=pow((double)nSubvolumes,(double)(distinct-(int)reactants.size())))
+			matched = false;
+	}
+	reactants.clear();
+
+	if(!matched) {
+		nRejected++;
+	} else {
+		if(!rs.rxn->transformationSet->checkMolecularity(rs.chosen)) {
+			nNull++;
+		} else {
+			int nTouched = recordTouched(rs,touched.data());
+			rs.rxn->transformationSet->transform(rs.chosen);
+			for(int i=0; i<nTouched; i++) checkEligible(touched[i],v);
+			nFired++;
+			fired = true;
+		}
+		rxnFired[r]++;
+		system->globalEventCounter++;
+	}
+	clearScratch(rs);
+	return fired;
+}
+
+
+int SubvolumeEngine::hop(int v)
+{
+	//A molecule is picked at random and takes its complex along with the chance one
+	//over its size, so that every complex jumps at the same rate
+	nHopTries++;
+	int pick = NFutil::RANDOM_INT(0,moleculeCount[v]);
+	unsigned int t = 0;
+	while(pick>=(int)contents[v][t].size()) pick -= contents[v][t++].size();
+	list <Molecule *> members;
+	contents[v][t][pick]->traverseBondedNeighborhood(members,ReactionClass::NO_LIMIT);
+	if(members.size()>1 && NFutil::RANDOM_INT(0,members.size())!=0) return -1;
+
+	int direction = NFutil::RANDOM_INT(0,2*nDimensions);
+	int stride = direction/2==0 ? 1 : (direction/2==1 ? nPerSide : nPerSide*nPerSide);
+	int coordinate = (v/stride)%nPerSide;
+	int next = (coordinate+(direction%2==0 ? 1 : nPerSide-1))%nPerSide;
+	int to = v+(next-coordinate)*stride;
+	if(to==v) return -1;
+	nHops++;
+	moveComplex(members,to);
+	return to;
+}
+
+
+void SubvolumeEngine::moveComplex(list <Molecule *> &members, int to)
+{
+	for(list <Molecule *>::iterator it=members.begin(); it!=members.end(); it++) {
+		moveEligible(*it,subvolumeOf[(*it)->getUniqueID()],to);
+		removeFromSubvolume(*it);
+		addToSubvolume(*it,to);
+	}
+}
+
+
+void SubvolumeEngine::addToSubvolume(Molecule *m, int v)
+{
+	vector <Molecule *> &here = contents[v][m->getMoleculeType()->getTypeID()];
+	subvolumeOf[m->getUniqueID()] = v;
+	slotOf[m->getUniqueID()] = here.size();
+	here.push_back(m);
+	moleculeCount[v]++;
+}
+
+
+void SubvolumeEngine::removeFromSubvolume(Molecule *m)
+{
+	int v = subvolumeOf[m->getUniqueID()];
+	vector <Molecule *> &here = contents[v][m->getMoleculeType()->getTypeID()];
+	int slot = slotOf[m->getUniqueID()];
+	here[slot] = here.back();
+	slotOf[here[slot]->getUniqueID()] = slot;
+	here.pop_back();
+	moleculeCount[v]--;
+}
+
+
+void SubvolumeEngine::updateRates(int v)
+{
+	//with one subvolume there is nowhere to jump to
+	totalRate[v] = nPerSide>1 ? hopRate*2.0*(double)nDimensions*(double)moleculeCount[v] : 0;
+	for(unsigned int r=0; r<rxns.size(); r++) {
+		rxnBound[v][r] = rateScale[r]*boundOf(r,v,0);
+		totalRate[v] += rxnBound[v][r];
+	}
+}
+
+
+void SubvolumeEngine::setComplexPositions()
+{
+	if(!system->useComplex) return;
+	for(unsigned int t=0; t<system->allMoleculeTypes.size(); t++) {
+		MoleculeList *ml = system->allMoleculeTypes[t]->getMoleculeList();
+		for(int i=0; i<ml->size(); i++) {
+			int v = subvolumeOf[ml->at(i)->getUniqueID()];
+			double z = nDimensions==3 ? (double)(v/(nPerSide*nPerSide))+0.5 : 0;
+			ml->at(i)->getComplex()->setPosition((double)(v%nPerSide)+0.5,(double)((v/nPerSide)%nPerSide)+0.5,z);
+		}
+	}
+}
+
+
+void SubvolumeEngine::schedule(int v, double time)
+{
+	//A subvolume with nothing that can happen waits forever
+	if(!(time<numeric_limits<double>::max())) time = numeric_limits<double>::max();
+	double old = nextTime[v];
+	nextTime[v] = time;
+	if(time<old) siftUp(heapPos[v]);
+	else siftDown(heapPos[v]);
+}
+
+
+void SubvolumeEngine::siftUp(int i)
+{
+	while(i>0 && nextTime[heap[(i-1)/2]]>nextTime[heap[i]]) {
+		swapInHeap(i,(i-1)/2);
+		i = (i-1)/2;
+	}
+}
+
+
+void SubvolumeEngine::siftDown(int i)
+{
+	while(true) {
+		int smallest = i;
+		int left = 2*i+1, right = 2*i+2;
+		if(left<nSubvolumes && nextTime[heap[left]]<nextTime[heap[smallest]]) smallest = left;
+		if(right<nSubvolumes && nextTime[heap[right]]<nextTime[heap[smallest]]) smallest = right;
+		if(smallest==i) return;
+		swapInHeap(i,smallest);
+		i = smallest;
+	}
+}
+
+
+void SubvolumeEngine::swapInHeap(int i, int j)
+{
+	int v = heap[i];
+	heap[i] = heap[j];
+	heap[j] = v;
+	heapPos[heap[i]] = i;
+	heapPos[heap[j]] = j;
+}
@@ -0,0 +1,103 @@
+#ifndef NFSUBVOLUMEENGINE_HH_
+#define NFSUBVOLUMEENGINE_HH_
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "optimisticEngine.hh"
+
+
+namespace NFcore
+{
+	class System;
+	class Molecule;
+
+
+	//!  Experimental engine that runs one System on a grid of well-mixed subvolumes
+	/*!
+	    The volume of the model is cut into a square (2D, for membranes) or cubic (3D)
+	    grid of subvolumes with periodic edges.  Every complex sits in one subvolume,
+	    and reactions only happen between molecules of the same subvolume.  Complexes
+	    start in a random subvolume and jump to each of the neighbouring ones at a
+	    given rate, whatever their size.  The rates of the model are for the whole
+	    volume, so a rule with n reactants from different complexes runs at its rate
+	    times the number of subvolumes to the power n-1 in each subvolume.  Reactants
+	    of one complex are already together, so they keep the rate of the model.  With
+	    very fast jumps the model is well mixed again.
+
+	    This is the next subvolume method: each subvolume has the time of its next
+	    event, and an indexed priority queue over the subvolumes gives the earliest.
+	    The event is a jump or a reaction of that subvolume, chosen and matched with
+	    the thinning of OptimisticEngine, with a set of the molecules whose own sites
+	    match each reactant pattern for every subvolume.  Events run one at a time,
+	    so the sets are always up to date and need no headroom.  A reaction only
+	    changes the rates of its own subvolume, and a jump those of the two
+	    subvolumes it joins.  With a single subvolume nothing jumps.
+
+	    The reactant lists and observables of the system are not used while the engine
+	    runs, and are rebuilt at the end like in OptimisticEngine.  With complex
+	    bookkeeping (-cb), the position of every complex, the centre of its subvolume
+	    in units of the subvolume width, can be read with Complex::getXpos() and the
+	    others after each output.  The same models as OptimisticEngine are supported.
+
+	    Events run on the calling thread.  Running far apart parts of the grid on
+	    several threads (domain decomposition) is not done here.
+	*/
+	class SubvolumeEngine : public OptimisticEngine
+	{
+		public:
+			SubvolumeEngine(System *s, int nPerSide, int nDimensions, double hopRate);
+			virtual ~SubvolumeEngine();
+
+			//! Runs the system for the given time without output, then sets the clock back
+			virtual void equilibrate(double duration);
+
+			//! Runs the system, writing the observables sampleTimes times, like System::sim
+			virtual double sim(double duration, long int sampleTimes);
+
+		protected:
+
+			void placeComplexes();
+			virtual void advance(double stopTime);
+			void runEvent(int v);
+			int hop(int v);
+			bool react(int v, int r);
+			void moveComplex(std::list <Molecule *> &members, int to);
+			void addToSubvolume(Molecule *m, int v);
+			void removeFromSubvolume(Molecule *m);
+			void updateRates(int v);
+			void setComplexPositions();
+
+			// the indexed priority queue over the next event times of the subvolumes
+			void schedule(int v, double time);
+			void siftUp(int i);
+			void siftDown(int i);
+			void swapInHeap(int i, int j);
+
+			int nPerSide;
+			int nDimensions;
+			int nSubvolumes;
+			double hopRate;
+			std::vector <double> rateScale;   // per reaction, nSubvolumes to the power n-1
+
+			// the molecules of each subvolume by type, and where each molecule is
+			std::vector <std::vector <std::vector <Molecule *> > > contents;
+			std::vector <int> subvolumeOf;
+			std::vector <int> slotOf;
+			std::vector <int> moleculeCount;
+
+			// the rate bound of each reaction in each subvolume, and of all events
+			std::vector <std::vector <double> > rxnBound;
+			std::vector <double> totalRate;
+
+			std::vector <double> nextTime;
+			std::vector <int> heap;
+			std::vector <int> heapPos;
+
+			unsigned long long nHops, nHopTries;
+	};
+}
+
+
+#endif /*NFSUBVOLUMEENGINE_HH_*/
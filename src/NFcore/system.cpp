@@ -7,6 +7,9 @@
 
 #include <math.h>
 #include <fstream>
+#include <iomanip>
+#include <thread>
+#include <unordered_map>
 #include "../NFscheduler/NFstream.h"
 #include "../NFscheduler/Scheduler.h"
 
@@ -15,7 +18,7 @@
 using namespace std;
 using namespace NFcore;
 
-int System::NULL_EVENT_COUNTER = 0;
+thread_local int System::NULL_EVENT_COUNTER = 0;
 
 
 System::System(string name)
@@ -36,12 +39,17 @@ System::System(string name)
 	outputEventCounter=false;
 	globalEventCounter=0;
 	onTheFlyObservables=true;
+	anyLazyObservables=false;
+	onTheFlyVersion=0;
+	observableThreads=thread::hardware_concurrency();
+	if(observableThreads<1) observableThreads=1;
 	universalTraversalLimit=-1;
 	ds=0;
 	selector = 0;
 	csvFormat = false;
 	anyRxnTagged = false;
 	max_cpu_time = -1;
+	max_events = -1;
 }
 
 
@@ -63,6 +71,10 @@ System::System(string name, bool useComplex)
 	rxnIndexMap=0;
 	useBinaryOutput=false;
 	onTheFlyObservables=true;
+	anyLazyObservables=false;
+	onTheFlyVersion=0;
+	observableThreads=thread::hardware_concurrency();
+	if(observableThreads<1) observableThreads=1;
 	outputEventCounter=false;
 	globalEventCounter=0;
 	universalTraversalLimit=-1;
@@ -71,6 +83,7 @@ System::System(string name, bool useComplex)
 	csvFormat = false;
 	anyRxnTagged = false;
 	max_cpu_time = -1;
+	max_events = -1;
 }
 
 System::System(string name, bool useComplex, int globalMoleculeLimit)
@@ -92,12 +105,17 @@ System::System(string name, bool useComplex, int globalMoleculeLimit)
 	outputEventCounter=false;
 	globalEventCounter=0;
 	onTheFlyObservables=true;
+	anyLazyObservables=false;
+	onTheFlyVersion=0;
+	observableThreads=thread::hardware_concurrency();
+	if(observableThreads<1) observableThreads=1;
 	universalTraversalLimit=-1;
 	ds=0;
 	selector = 0;
 	csvFormat = false;
 	anyRxnTagged = false;
 	max_cpu_time = -1;
+	max_events = -1;
 }
 
 
@@ -460,6 +478,21 @@ void System::tryToDump() {
 }
 
 
+void System::setEnsembleStats(EnsembleStats *es) {
+	this->ensembleStats=es;
+	this->ensembleSample=0;
+	if(es==0) return;
+
+	vector <string> names;
+	for(obsIter = obsToOutput.begin(); obsIter != obsToOutput.end(); obsIter++)
+		names.push_back((*obsIter)->getName());
+	if(outputGlobalFunctionValues)
+		for( functionIter = globalFunctions.begin(); functionIter != globalFunctions.end(); functionIter++ )
+			names.push_back((*functionIter)->getNiceName());
+	es->setColumns(names);
+}
+
+
 
 bool System::addGlobalFunction(GlobalFunction *gf)
 {
@@ -644,6 +677,12 @@ void System::prepareForSimulation()
 	//cout<<"here 6..."<<endl;
 
 
+  	//see which parts of the model could be simulated on their own
+  	if(!subsystemsFound) findIndependentSubsystems();
+
+  	//decide which observables events have to update before the molecules are counted
+  	chooseOnTheFlyObservables();
+
   	//prep each molecule type for the simulation
   	for( molTypeIter = allMoleculeTypes.begin(); molTypeIter != allMoleculeTypes.end(); molTypeIter++ ) {
   		(*molTypeIter)->prepareForSimulation();
@@ -661,24 +700,7 @@ void System::prepareForSimulation()
   	//}
 
   	//Add the complexes to Species observables
-  	int match = 0;
-  	for(obsIter = speciesObservables.begin(); obsIter != speciesObservables.end(); obsIter++)
-  	  	(*obsIter)->clear();
-
-  	// NETGEN -- this bit replaces the commented block below
-  	Complex * complex;
-  	allComplexes.resetComplexIter();
-  	while(  (complex = allComplexes.nextComplex()) )
-  	{
-  		if( complex->isAlive() )
-  		{
-  			for(obsIter = speciesObservables.begin(); obsIter != speciesObservables.end(); obsIter++)
-  			{
-  				match = (*obsIter)->isObservable( complex );
-  				for (int k=0; k<match; k++) (*obsIter)->straightAdd();
-  			}
-  		}
-  	}
+  	countSpeciesObservables();
   	/*
   	for(complexIter = allComplexes.allComplexes.begin(); complexIter != allComplexes.end(); complexIter++) {
   		if((*complexIter)->isAlive()) {
@@ -797,11 +819,15 @@ void System::prepareForSimulation()
 		this->getReactionFileStream() <<
 		  "    \"firings\": [" << endl;
 	}
+
+	if(memoryReport) outputMemoryReport("prepare",current_time);
 }
 
 
 void System::update_A_tot(ReactionClass *r, double old_a, double new_a)
 {
+	//the selector only holds the reactions of the subsystem this system is restricted to
+	if(restrictedSubsystem>=0 && subsystemOfReaction[r->getRxnId()]!=restrictedSubsystem) return;
 	a_tot = selector->update(r,old_a,new_a);
 
 	//BUILT IN DIRECT SEARCH
@@ -835,13 +861,16 @@ double System::recompute_A_tot()
 /* select the next reaction, given a_tot has been calculated */
 double System::getNextRxn()
 {
+	NF_PROFILE_START(profSelect);
 	nextReaction = 0;
 	double x = selector->getNextReactionClass(nextReaction);
 	if((int)x==-1) {
 		this->printAllReactions();
 		exit(1);
 	}
-	return selector->getNextReactionClass(nextReaction);
+	x = selector->getNextReactionClass(nextReaction);
+	NF_PROFILE_STOP_GLOBAL(SELECT,profSelect);
+	return x;
 
 
 //  BUILT IN DIRECT SEARCH
@@ -891,8 +920,7 @@ double System::sim(double duration, long int sampleTimes, bool verbose)
 
 
 	//////////////////////////////
-	clock_t start,finish;
-	double time;
+	clock_t start;
 	start = clock();
 	//////////////////////////////
 
@@ -909,7 +937,7 @@ double System::sim(double duration, long int sampleTimes, bool verbose)
 	tryToDump();
 
 	// AS2023 - depending on the tracking status we'll need a log string to build
-	string logstr;
+	rxnLogBuffer = "";
 	bool logged = false;
 
 	while(current_time<end_time)
@@ -986,15 +1014,15 @@ double System::sim(double duration, long int sampleTimes, bool verbose)
 		// AS2023 - if we are tracking events, this needs to be dealt with here
 		if (this->getReactionTrackingStatus()) {
 			// AS2023 - getting the log for the event
-			logstr += nextReaction->fire(randElement, true);
+			rxnLogBuffer += nextReaction->fire(randElement, true);
 			// AS2023 - only write if we have a positive value for
 			// buffer size in events
 			if (this->getLogBufferSize()>0) {
 				// AS2023 - write if we have enough events stored in buffer
 				if ( (globalEventCounter % this->getLogBufferSize()) == 0) {
-					this->getReactionFileStream() << logstr;
+					this->getReactionFileStream() << rxnLogBuffer;
 					// AS2023 - empty out the buffer
-					logstr = "";
+					rxnLogBuffer = "";
 					logged = true;
 				}
 			}
@@ -1004,32 +1032,21 @@ double System::sim(double duration, long int sampleTimes, bool verbose)
 		}
 		tryToDump();
 
+		if ( max_events > 0 && iteration >= (unsigned long long) max_events ) {
+			cout << "Max event count (" << max_events << ") reached, quitting." << endl;
+			break;
+		}
 	}
 	if(curSampleTime-dSampleTime<(end_time-0.5*dSampleTime)) {
 		outputAllObservableCounts(curSampleTime,globalEventCounter);
 	}
 	// AS2023 - if we missed a firing log, write what we have
 	if (!logged) {
-		this->getReactionFileStream() << logstr;
-		logstr = "";
+		this->getReactionFileStream() << rxnLogBuffer;
+		rxnLogBuffer = "";
 	}
-	// Write list of molecule_types and reactions along with reaction firing counts
-	// TODO: Make this optional!
-	if (this->outputMoleculeTypesFile) {
-		outputAllMoleculeTypes();
-	}
-	if (this->outputRxnFiringCountsFile) {
-		outputAllRxnFiringCounts();
-	}
-
-	finish = clock();
-    time = (double(finish)-double(start))/CLOCKS_PER_SEC;
-    if(verbose) cout<<"\n";
-    cout<<"   You just simulated "<< iteration <<" reactions in "<< time << "s\n";
-    cout<<"   ( "<<((double)iteration)/time<<" reactions/sec, ";
-    cout<<(time/((double)iteration))<<" CPU seconds/event )"<< endl;
-    cout<<"   Null events: "<< System::NULL_EVENT_COUNTER;
-    cout<<"   ("<<(time)/((double)iteration-(double)System::NULL_EVENT_COUNTER)<<" CPU seconds/non-null event )"<< endl;
+	printRunSummary(iteration,start,verbose);
+    NF_PROFILE_REPORT(this);
 
 	// AS2023 - if we were tracking reactions, we should close the 
 	// JSON file. We close the firing array, then the simulation 
@@ -1044,6 +1061,26 @@ double System::sim(double duration, long int sampleTimes, bool verbose)
 	return current_time;
 }
 
+void System::printRunSummary(unsigned long long iteration, clock_t start, bool verbose)
+{
+	// Write list of molecule_types and reactions along with reaction firing counts
+	// TODO: Make this optional!
+	if (this->outputMoleculeTypesFile) {
+		outputAllMoleculeTypes();
+	}
+	if (this->outputRxnFiringCountsFile) {
+		outputAllRxnFiringCounts();
+	}
+
+	double time = (double(clock())-double(start))/CLOCKS_PER_SEC;
+	if(verbose) cout<<"\n";
+	cout<<"   You just simulated "<< iteration <<" reactions in "<< time << "s\n";
+	cout<<"   ( "<<((double)iteration)/time<<" reactions/sec, ";
+	cout<<(time/((double)iteration))<<" CPU seconds/event )"<< endl;
+	cout<<"   Null events: "<< System::NULL_EVENT_COUNTER;
+	cout<<"   ("<<(time)/((double)iteration-(double)System::NULL_EVENT_COUNTER)<<" CPU seconds/non-null event )"<< endl;
+}
+
 double System::stepTo(double stoppingTime)
 {
 	double delta_t = 0;
@@ -1243,43 +1280,27 @@ void System::outputAllObservableCounts(double time)
 
 void System::outputAllObservableCounts(double cSampleTime, int eventCounter)
 {
-	if(!onTheFlyObservables)
-	{
-		for(obsIter = obsToOutput.begin(); obsIter != obsToOutput.end(); obsIter++)
-		{	(*obsIter)->clear();   }
+	NF_PROFILE_START(profOutput);
+	refreshObservables();
+	writeObservableCounts(cSampleTime,eventCounter);
 
-		for(molTypeIter = allMoleculeTypes.begin(); molTypeIter != allMoleculeTypes.end(); molTypeIter++ )
-		{	(*molTypeIter)->addAllToObservables(); 	}
-
-		int match = 0;
-
-	  	// NETGEN -- this bit replaces the commented block below
-	  	Complex * complex;
-	  	allComplexes.resetComplexIter();
-	  	while(  (complex = allComplexes.nextComplex()) )
-	  	{
-	  		if( complex->isAlive() )
-	  		{
-	  			for(obsIter = speciesObservables.begin(); obsIter != speciesObservables.end(); obsIter++)
-	  			{
-	  				match = (*obsIter)->isObservable( complex );
-	  				for (int k=0; k<match; k++) (*obsIter)->straightAdd();
-	  			}
-	  		}
-	  	}
-		/*
-		for(complexIter = allComplexes.begin(); complexIter != allComplexes.end(); complexIter++) {
-			if((*complexIter)->isAlive()) {
-				for(obsIter = speciesObservables.begin(); obsIter != speciesObservables.end(); obsIter++) {
-					match = (*obsIter)->isObservable((*complexIter));
-					for(int k=0; k<match; k++) (*obsIter)->straightAdd();
-				}
-			}
-		}
-		*/
+	if(ensembleStats!=0) {
+		vector <double> values;
+		for(obsIter = obsToOutput.begin(); obsIter != obsToOutput.end(); obsIter++)
+			values.push_back((double)(*obsIter)->getCount());
+		if(outputGlobalFunctionValues)
+			for( functionIter = globalFunctions.begin(); functionIter != globalFunctions.end(); functionIter++ )
+				values.push_back(FuncFactory::Eval((*functionIter)->p));
+		ensembleStats->add(ensembleSample++, cSampleTime, values);
 	}
+	NF_PROFILE_STOP_GLOBAL(OUTPUT,profOutput);
 
+	if(memoryReport) outputMemoryReport("output",cSampleTime);
+}
 
+
+void System::writeObservableCounts(double cSampleTime, int eventCounter)
+{
 	if(useBinaryOutput) {
 		double count=0.0; int oTot=0;
 
@@ -1349,11 +1370,132 @@ void System::outputAllObservableCounts(double cSampleTime, int eventCounter)
 			outputFileStream<<endl;
 		}
 	}
+}
+
+void System::turnOnMemoryReport(string filename)
+{
+	memoryReport = true;
+	if(filename.empty()) return;
+	memoryReportStream.open(filename.c_str());
+	if(!memoryReportStream.is_open()) {
+		cerr<<"Could not open the memory report file: "<<filename<<endl;
+		cerr<<"The memory report will only be printed to the console."<<endl;
+		return;
+	}
+	memoryReportStream<<"when\ttime\tcategory\tlive\tallocated\tbytes"<<endl;
+}
 
 
+void System::outputMemoryReport(string when, double time)
+{
+	// each row is: category name, live objects, allocated objects, bytes
+	vector <string> names;
+	vector <unsigned long> live, allocated, bytes;
+
+	// molecules, their per-reaction membership sets and the molecule lists
+	unsigned long n_mol=0, n_molAlloc=0, molBytes=0;
+	unsigned long n_rxnSets=0, n_rxnEntries=0, rxnSetBytes=0;
+	unsigned long listLive=0, listCapacity=0, listBytes=0;
+	for(unsigned int mt=0; mt<allMoleculeTypes.size(); mt++) {
+		MoleculeList *ml = allMoleculeTypes.at(mt)->getMoleculeList();
+		listLive += ml->size();
+		listCapacity += ml->getCapacity();
+		listBytes += ml->getMemoryUsage();
+		n_mol += ml->size();
+		for(int i=0; i<ml->getCapacity(); i++) {
+			Molecule *m = ml->at(i);
+			unsigned long entries = 0;
+			molBytes += m->getMemoryUsage();
+			rxnSetBytes += m->getRxnMembershipMemoryUsage(entries);
+			n_rxnEntries += entries;
+			n_molAlloc++;
+		}
+		n_rxnSets += ml->getCapacity()*allMoleculeTypes.at(mt)->getReactionCount();
+	}
+	names.push_back("molecules"); live.push_back(n_mol); allocated.push_back(n_molAlloc); bytes.push_back(molBytes);
+	names.push_back("molecule rxn membership"); live.push_back(n_rxnEntries); allocated.push_back(n_rxnSets); bytes.push_back(rxnSetBytes);
+	names.push_back("molecule lists"); live.push_back(listLive); allocated.push_back(listCapacity); bytes.push_back(listBytes);
 
+	// the mapping sets held by the reactant lists and trees of each reaction
+	unsigned long msUsed[2]={0,0}, msCapacity[2]={0,0}, msBytes[2]={0,0};
+	vector < pair <unsigned long, string> > containers;
+	for(unsigned int r=0; r<allReactions.size(); r++) {
+		ReactionClass *rxn = allReactions.at(r);
+		for(int i=0; i<rxn->getNumOfReactants(); i++) {
+			ReactantContainer *rc = rxn->getReactantContainer(i);
+			if(rc==0) continue;
+			int isTree = (dynamic_cast<ReactantTree *>(rc)!=0) ? 1 : 0;
+			unsigned long b = rc->getMemoryUsage();
+			msUsed[isTree] += rc->size();
+			msCapacity[isTree] += rc->getCapacity();
+			msBytes[isTree] += b;
+
+			stringstream row;
+			row<<rxn->getName()<<"["<<i<<"]\t"<<rc->size()<<"\t"<<rc->getCapacity();
+			containers.push_back(make_pair(b,row.str()));
+		}
+	}
+	names.push_back("mapping sets (lists)"); live.push_back(msUsed[0]); allocated.push_back(msCapacity[0]); bytes.push_back(msBytes[0]);
+	names.push_back("mapping sets (trees)"); live.push_back(msUsed[1]); allocated.push_back(msCapacity[1]); bytes.push_back(msBytes[1]);
+
+	// complexes are never deleted, only reused, so count how many are alive
+	unsigned long n_cplxAlive=0, cplxBytes=0;
+	for(int c=0; c<allComplexes.getNumOfComplexes(); c++) {
+		Complex *cplx = allComplexes.getComplex(c);
+		if(cplx->isAlive()) n_cplxAlive++;
+		cplxBytes += cplx->getMemoryUsage();
+	}
+	names.push_back("complexes"); live.push_back(n_cplxAlive); allocated.push_back(allComplexes.getNumOfComplexes()); bytes.push_back(cplxBytes);
+
+	// the connectivity map of the system (one bit per pair of reactions) and
+	// the lists of connected reactions kept by each reaction
+	unsigned long n_connected=0, connectedBytes=0;
+	for(unsigned int r=0; r<connectedReactions.size(); r++)
+		connectedBytes += sizeof(vector <bool>) + (connectedReactions[r].capacity()+7)/8;
+	for(unsigned int r=0; r<allReactions.size(); r++) {
+		n_connected += allReactions.at(r)->getNumConnectedRxns();
+		connectedBytes += allReactions.at(r)->getConnectedRxnMemoryUsage();
+	}
+	names.push_back("connected reactions"); live.push_back(n_connected); allocated.push_back(n_connected); bytes.push_back(connectedBytes);
+
+	// string buffers of the reaction firing log
+	names.push_back("string log buffers");
+	live.push_back(rxnLogBuffer.size()+speciesLog.size());
+	allocated.push_back(rxnLogBuffer.capacity()+speciesLog.capacity());
+	bytes.push_back(rxnLogBuffer.capacity()+speciesLog.capacity());
+
+	unsigned long total = 0;
+	for(unsigned int k=0; k<bytes.size(); k++) total += bytes[k];
+
+
+	ios_base::fmtflags oldFlags = cout.flags();
+	cout.unsetf(ios::scientific);
+	cout<<"\n   memory report ("<<when<<", time "<<time<<"):"<<endl;
+	cout<<"   "<<left<<setw(28)<<"category"<<right<<setw(14)<<"live"<<setw(14)<<"allocated"<<setw(16)<<"bytes"<<endl;
+	for(unsigned int k=0; k<names.size(); k++)
+		cout<<"   "<<left<<setw(28)<<names[k]<<right<<setw(14)<<live[k]<<setw(14)<<allocated[k]<<setw(16)<<bytes[k]<<endl;
+	cout<<"   "<<left<<setw(28)<<"total"<<right<<setw(44)<<total<<endl;
+
+	const unsigned int maxContainersToShow = 5;
+	sort(containers.rbegin(),containers.rend());
+	if(!containers.empty()) cout<<"   largest reactant containers (reactant: used, capacity, bytes):"<<endl;
+	for(unsigned int k=0; k<containers.size() && k<maxContainersToShow; k++) {
+		string row = containers[k].second;
+		replace(row.begin(),row.end(),'\t',' ');
+		cout<<"      "<<row<<" "<<containers[k].first<<endl;
+	}
+	cout.flags(oldFlags);
+
+	if(memoryReportStream.is_open()) {
+		for(unsigned int k=0; k<names.size(); k++)
+			memoryReportStream<<when<<"\t"<<time<<"\t"<<names[k]<<"\t"<<live[k]<<"\t"<<allocated[k]<<"\t"<<bytes[k]<<endl;
+		memoryReportStream<<when<<"\t"<<time<<"\ttotal\t\t\t"<<total<<endl;
+		for(unsigned int k=0; k<containers.size(); k++)
+			memoryReportStream<<when<<"\t"<<time<<"\treactants:"<<containers[k].second<<"\t"<<containers[k].first<<endl;
+	}
 }
 
+
 void System::printAllObservableCounts()
 {
 	printAllObservableCounts(current_time,globalEventCounter);
@@ -1366,6 +1508,7 @@ void System::printAllObservableCounts(double cSampleTime)
 
 void System::printAllObservableCounts(double cSampleTime,int eventCounter)
 {	
+	refreshObservables();
 	cout<<"Time";
 	for(obsIter = obsToOutput.begin(); obsIter != obsToOutput.end(); obsIter++)
 		cout<<"\t"<<(*obsIter)->getName();
@@ -1398,165 +1541,628 @@ void System::printAllObservableCounts(double cSampleTime,int eventCounter)
 }
 
 
-// NETGEN  moved to ComplexList
-/*
-void System::printAllComplexes()
+void System::chooseOnTheFlyObservables()
 {
-	cout<<"All System Complexes:"<<endl;
-	for(complexIter = allComplexes.begin(); complexIter != allComplexes.end(); complexIter++ )
-		(*complexIter)->printDetails();
-	cout<<endl;
+	//With -notf nothing is updated on the fly anyway, and refreshObservables()
+	//recounts everything
+	onTheFlySpeciesObservables.clear();
+	anyLazyObservables=false;
+	onTheFlyVersion++;
+	for(obsIter = obsToOutput.begin(); obsIter != obsToOutput.end(); obsIter++) {
+		Observable *o = *obsIter;
+		o->setOnTheFly(!onTheFlyObservables || o->isReadBetweenOutputs());
+		if(!o->isOnTheFly()) anyLazyObservables=true;
+		else if(o->getType()==Observable::SPECIES) onTheFlySpeciesObservables.push_back(o);
+	}
 }
-*/
 
 
-bool System::saveSpecies(string filename)
+void System::keepOnTheFly(Observable *o)
 {
-	bool debugOut = false;
+	o->setReadBetweenOutputs();
+	if(o->isOnTheFly()) return;
+
+	//count it now and from here on let the events update it
+	o->setOnTheFly(true);
+	onTheFlyVersion++;
+	o->clear();
+	if(o->getType()==Observable::SPECIES) {
+		onTheFlySpeciesObservables.push_back(o);
+		Complex * complex;
+		allComplexes.resetComplexIter();
+		while( (complex = allComplexes.nextComplex()) )
+			if( complex->isAlive() ) o->straightAdd( o->isObservable( complex ) );
+	} else {
+		for(molTypeIter = allMoleculeTypes.begin(); molTypeIter != allMoleculeTypes.end(); molTypeIter++ )
+			(*molTypeIter)->addAllToObservable((MoleculesObservable *)o);
+	}
+}
 
-	//open the output filestream
-	ofstream speciesFile;
-	speciesFile.open(filename.c_str());
-	if(!speciesFile.is_open()) {
-		cerr<<"Error in System when calling System::saveSpecies(string)!  Cannot open output stream to file "<<filename<<". "<<endl;
-		cerr<<"quitting."<<endl;
+
+void System::refreshObservables()
+{
+	if(onTheFlyObservables) {
+		//only the observables that nothing reads between outputs are behind
+		if(!anyLazyObservables) return;
+		for(obsIter = obsToOutput.begin(); obsIter != obsToOutput.end(); obsIter++)
+			if(!(*obsIter)->isOnTheFly()) (*obsIter)->clear();
+
+		for(unsigned int t=0; t<allMoleculeTypes.size(); t++)
+			if(isCountedInSubsystem(t)) allMoleculeTypes[t]->addAllToLazyObservables();
+
+		if(speciesObservables.size()>onTheFlySpeciesObservables.size()) {
+			vector <Observable *> lazySpeciesObs;
+			for(obsIter = speciesObservables.begin(); obsIter != speciesObservables.end(); obsIter++)
+				if(!(*obsIter)->isOnTheFly()) lazySpeciesObs.push_back(*obsIter);
+			addComplexesToSpeciesObservables(lazySpeciesObs);
+		}
+		return;
+	}
+
+	for(obsIter = obsToOutput.begin(); obsIter != obsToOutput.end(); obsIter++)
+	{	(*obsIter)->clear();   }
+
+	for(unsigned int t=0; t<allMoleculeTypes.size(); t++)
+	{	if(isCountedInSubsystem(t)) allMoleculeTypes[t]->addAllToObservables(); 	}
+
+	countSpeciesObservables();
+}
+
+
+void System::countSpeciesObservables()
+{
+  	for(obsIter = speciesObservables.begin(); obsIter != speciesObservables.end(); obsIter++)
+  	  	(*obsIter)->clear();
+  	addComplexesToSpeciesObservables(speciesObservables);
+}
+
+
+//Fewer complexes than this are not worth starting another thread for
+static const int MIN_COMPLEXES_PER_THREAD = 5000;
+
+//packs every member of the complex, in order, see MoleculeType::packState()
+static bool packComplex(Complex *c, vector <unsigned long long> &stateWords, vector <unsigned long long> &bondWords)
+{
+	stateWords.resize(c->complexMembers.size());
+	bondWords.resize(c->complexMembers.size());
+	int k = 0;
+	for(list <Molecule *>::const_iterator it=c->complexMembers.begin(); it!=c->complexMembers.end(); it++, k++)
+		if(!(*it)->getMoleculeType()->packState(*it,stateWords[k],bondWords[k])) return false;
+	return true;
+}
+
+void System::addComplexesToSpeciesObservables(vector <Observable *> &obs)
+{
+  	//Observables of single-molecule templates are matched on several threads, each
+  	//over its own range of complexes and with its own tally.  The rest mark the
+  	//templates and molecules they visit, so they are matched on this thread.
+  	vector <SpeciesObservable *> packed;
+  	vector <Observable *> full;
+  	for(unsigned int k=0; k<obs.size(); k++) {
+  		if(obs[k]->matchesOnlyBySignature()) packed.push_back((SpeciesObservable *)obs[k]);
+  		else full.push_back(obs[k]);
+  	}
+
+  	// NETGEN -- walk the live complexes, in a single pass when on one thread
+  	Complex * complex;
+  	allComplexes.resetComplexIter();
+  	if(packed.empty()) {
+  		while(  (complex = allComplexes.nextComplex()) )
+  		{
+  			if( !complex->isAlive() ) continue;
+  			for(unsigned int k=0; k<obs.size(); k++)
+  				obs[k]->straightAdd(obs[k]->isObservable(complex));
+  		}
+  		return;
+  	}
+
+  	//the list also holds the complexes that are not in use, which are left out of
+  	//the ranges so that every thread gets as many live complexes
+  	vector <Complex *> complexes;
+  	while(  (complex = allComplexes.nextComplex()) )
+  		if( complex->isAlive() ) complexes.push_back(complex);
+  	if(NFutil::countRanges(complexes.size(),observableThreads,MIN_COMPLEXES_PER_THREAD)==1) {
+  		for(unsigned int i=0; i<complexes.size(); i++)
+  			for(unsigned int k=0; k<obs.size(); k++)
+  				obs[k]->straightAdd(obs[k]->isObservable(complexes[i]));
+  		return;
+  	}
+
+  	vector <vector <int> > tally(observableThreads, vector <int> (packed.size(),0));
+  	vector <vector <Complex *> > unpacked(observableThreads);
+  	int nRanges = NFutil::runInRanges(complexes.size(), observableThreads, MIN_COMPLEXES_PER_THREAD,
+  		[&](int begin, int end, int r) {
+  			vector <unsigned long long> stateWords, bondWords;
+  			for(int i=begin; i<end; i++) {
+  				if(!packComplex(complexes[i],stateWords,bondWords)) {
+  					unpacked[r].push_back(complexes[i]);
+  					continue;
+  				}
+  				for(unsigned int k=0; k<packed.size(); k++)
+  					tally[r][k] += packed[k]->isObservableBySignature(complexes[i],stateWords,bondWords);
+  			}
+  		});
+
+  	//add up the ranges in order, then match what the threads left over
+  	for(unsigned int k=0; k<packed.size(); k++) {
+  		for(int r=0; r<nRanges; r++) {
+  			packed[k]->straightAdd(tally[r][k]);
+  			for(unsigned int i=0; i<unpacked[r].size(); i++)
+  				packed[k]->straightAdd(packed[k]->isObservable(unpacked[r][i]));
+  		}
+  	}
+  	if(!full.empty()) {
+  		for(unsigned int i=0; i<complexes.size(); i++)
+  			for(unsigned int k=0; k<full.size(); k++)
+  				full[k]->straightAdd(full[k]->isObservable(complexes[i]));
+  	}
+}
+
+
+void System::snapshot()
+{
+	if(selector==0) {
+		cerr<<"Error in System::snapshot()!  The system has to be prepared for simulation"<<endl;
+		cerr<<"before a snapshot can be taken.  quitting."<<endl;
 		exit(1);
 	}
 
-	cout<<"\n\nsaving list of final molecular species..."<<endl;
+	image.time = current_time;
+	image.eventCounter = globalEventCounter;
+	image.listIds.assign(allMoleculeTypes.size(), vector <int> ());
+	image.nLive.assign(allMoleculeTypes.size(), 0);
+	image.populations.clear();
+	image.states.clear();
+	image.bondMolecule.clear();
+	image.bondSite.clear();
+	image.obsMatches.clear();
+	image.localFunctionValues.clear();
+	image.rxnMemberships.clear();
+
+	// everything a live molecule carries, including which observables it matches,
+	// its local function values and the MappingSets it has in each reaction
+	for(unsigned int t=0; t<allMoleculeTypes.size(); t++) {
+		MoleculeType *mt = allMoleculeTypes.at(t);
+		MoleculeList *ml = mt->getMoleculeList();
+		ml->getOrder(image.listIds.at(t));
+		image.nLive.at(t) = ml->size();
+		for(int i=0; i<ml->size(); i++) {
+			Molecule *m = ml->at(i);
+			image.populations.push_back(m->getPopulation());
+			for(int c=0; c<mt->getNumOfComponents(); c++) {
+				image.states.push_back(m->getComponentState(c));
+				if(m->isBindingSiteBonded(c)) {
+					image.bondMolecule.push_back(m->getBondedMolecule(c));
+					image.bondSite.push_back(m->getBondedMoleculeBindingSiteIndex(c));
+				} else {
+					image.bondMolecule.push_back(0);
+					image.bondSite.push_back(-1);
+				}
+			}
+			for(int o=0; o<mt->getNumOfMolObs(); o++)
+				image.obsMatches.push_back(m->isObs(o));
+			for(int lf=0; lf<mt->getNumOfTypeIFunctions(); lf++)
+				image.localFunctionValues.push_back(m->getLocalFunctionValue(lf));
+			for(int r=0; r<mt->getReactionCount(); r++) {
+				const set <int> &ids = m->getRxnListMappingSet(r);
+				image.rxnMemberships.push_back(ids.size());
+				image.rxnMemberships.insert(image.rxnMemberships.end(), ids.begin(), ids.end());
+			}
+		}
+	}
+	allComplexes.saveImage(image.complexMembers, image.availableComplexes);
 
-	// create a couple data structures to store results as we go
-	list <Molecule *> molecules;
-	list <Molecule *>::iterator iter;
-	map <int,bool> reportedMolecules;
-    map <string,int> reportedSpecies;
+	// the reactant lists and trees; a DORN rule may keep several reactants in one tree
+	image.containers.clear();
+	for(unsigned int r=0; r<allReactions.size(); r++) {
+		ReactionClass *rxn = allReactions.at(r);
+		unsigned int first = image.containers.size();
+		for(int k=0; k<rxn->getNumOfReactants(); k++) {
+			ReactantContainer *rc = rxn->getReactantContainer(k);
+			if(rc!=0 && find(image.containers.begin()+first, image.containers.end(), rc)==image.containers.end())
+				image.containers.push_back(rc);
+		}
+	}
+	image.reactants.resize(image.containers.size());
+	for(unsigned int k=0; k<image.containers.size(); k++)
+		image.containers[k]->saveImage(image.reactants[k]);
 
+	image.obsCounts.clear();
+	for(unsigned int t=0; t<allMoleculeTypes.size(); t++)
+		for(int o=0; o<allMoleculeTypes.at(t)->getNumOfMolObs(); o++)
+			image.obsCounts.push_back(allMoleculeTypes.at(t)->getMolObs(o)->getCount());
+	for(unsigned int o=0; o<speciesObservables.size(); o++)
+		image.obsCounts.push_back(speciesObservables.at(o)->getCount());
 
-	// loop over all the types of molecules that exist
-	for( unsigned int k=0; k<allMoleculeTypes.size(); k++)
-	{
-		// retrieve the MoleculeType
-		MoleculeType *mt = allMoleculeTypes.at(k);
+	image.propensities.resize(allReactions.size());
+	image.fireCounts.resize(allReactions.size());
+	for(unsigned int r=0; r<allReactions.size(); r++) {
+		image.propensities[r] = allReactions.at(r)->get_a();
+		image.fireCounts[r] = allReactions.at(r)->getFireCounter();
+	}
+	image.aTot = a_tot;
 
-		// loop over every individual molecule
-		for(int j=0; j<mt->getMoleculeCount(); j++)
-		{
-			// check if we have looked this molecule before, and skip it if we have
-			if(reportedMolecules.find(mt->getMolecule(j)->getUniqueID())!=reportedMolecules.end()) {
-				continue;
+	image.taken = true;
+}
+
+
+bool System::restore()
+{
+	if(!image.taken) return false;
+
+	// Everything is written back as it was, nothing is matched again.  Molecule
+	// objects are never freed, so the image can point at them.  The molecule lists
+	// get their old order back, so that a seeded run from the restored state makes
+	// the same choices as one from the moment of the snapshot.
+	for(unsigned int t=0; t<allMoleculeTypes.size(); t++)
+		allMoleculeTypes.at(t)->getMoleculeList()->restoreOrder(image.listIds.at(t), image.nLive.at(t));
+
+	allComplexes.restoreImage(image.complexMembers, image.availableComplexes);
+	if(allComplexes.isUsingComplex()) {
+		// molecule objects made since the snapshot each brought a complex along
+		int c_id = image.complexMembers.size();
+		for(unsigned int t=0; t<allMoleculeTypes.size(); t++) {
+			MoleculeList *ml = allMoleculeTypes.at(t)->getMoleculeList();
+			for(int i=image.listIds.at(t).size(); i<ml->getCapacity(); i++)
+				allComplexes.getComplex(c_id++)->resetToSingleton(ml->at(i));
+		}
+	}
+
+	unsigned int p = 0, s = 0, o = 0, lf = 0, rm = 0;
+	for(unsigned int t=0; t<allMoleculeTypes.size(); t++) {
+		MoleculeType *mt = allMoleculeTypes.at(t);
+		MoleculeList *ml = mt->getMoleculeList();
+		for(int i=0; i<ml->size(); i++) {
+			Molecule *m = ml->at(i);
+			if(m->isPopulationType()) m->setPopulation(image.populations[p]);
+			p++;
+			for(int c=0; c<mt->getNumOfComponents(); c++, s++) {
+				m->setComponentState(c, image.states[s]);
+				m->restoreBond(c, image.bondMolecule[s], image.bondSite[s]);
 			}
+			for(int k=0; k<mt->getNumOfMolObs(); k++)
+				m->setIsObs(k, image.obsMatches[o++]);
+			for(int k=0; k<mt->getNumOfTypeIFunctions(); k++)
+				m->setLocalFunctionValue(image.localFunctionValues[lf++], k);
+			for(int r=0; r<mt->getReactionCount(); r++) {
+				m->setRxnListMappingId(r, Molecule::NOT_IN_RXN);
+				for(int n=image.rxnMemberships[rm++]; n>0; n--)
+					m->setRxnListMappingId(r, image.rxnMemberships[rm++]);
+			}
+			m->setAlive(true);
+		}
 
+		// molecules that were not live then forget what they have been through since
+		for(int i=ml->size(); i<ml->getCapacity(); i++) {
+			if(!ml->at(i)->isAlive()) continue;
+			ml->at(i)->recycle();
+			ml->at(i)->setAlive(false);
+		}
+	}
 
+	for(unsigned int k=0; k<image.containers.size(); k++)
+		image.containers[k]->restoreImage(image.reactants[k]);
 
-			//otherwise, we have not visited this particular species before, so loop over the molecules
-			//that make up the species
-			string speciesString = "";
-			molecules.clear();
-			mt->getMolecule(j)->traverseBondedNeighborhood(molecules,ReactionClass::NO_LIMIT);
+	o = 0;
+	for(unsigned int t=0; t<allMoleculeTypes.size(); t++) {
+		for(int k=0; k<allMoleculeTypes.at(t)->getNumOfMolObs(); k++) {
+			allMoleculeTypes.at(t)->getMolObs(k)->clear();
+			allMoleculeTypes.at(t)->getMolObs(k)->straightAdd(image.obsCounts[o++]);
+		}
+	}
+	for(unsigned int k=0; k<speciesObservables.size(); k++) {
+		speciesObservables.at(k)->clear();
+		speciesObservables.at(k)->straightAdd(image.obsCounts[o++]);
+	}
+
+	current_time = image.time;
+	globalEventCounter = image.eventCounter;
+	for(unsigned int r=0; r<allReactions.size(); r++) {
+		allReactions.at(r)->restore_a(image.propensities[r]);
+		allReactions.at(r)->setFireCounter(image.fireCounts[r]);
+	}
+	a_tot = selector->restorePropensities(image.aTot);
+	return true;
+}
 
-			// key: partnerID1, bsiteID1, partnerID2, bsiteID2
-			vector <vector <int> * > bondNumberMap;
 
-			bool isFirst = true;
-			for( iter = molecules.begin(); iter != molecules.end(); iter++ )
-			{
-				Molecule *m = (*iter);
-				reportedMolecules.insert(pair <int,bool> (m->getUniqueID(),true));
+//adds the types of every molecule in the pattern of the template to the list
+static void addTypesOfPattern(TemplateMolecule *tm, vector <int> &types)
+{
+	vector <TemplateMolecule *> tmList;
+	TemplateMolecule::traverse(tm,tmList,TemplateMolecule::FIND_ALL);
+	for(unsigned int k=0; k<tmList.size(); k++)
+		types.push_back(tmList[k]->getMoleculeType()->getTypeID());
+}
 
-				//Fist, output the molecule name
-				if(isFirst) { speciesString += m->getMoleculeTypeName()+"("; isFirst=false; }
-				else { speciesString += "."+m->getMoleculeTypeName()+"("; }
+void System::findIndependentSubsystems()
+{
+	int nTypes = allMoleculeTypes.size();
+	NFutil::DisjointSets sets(nTypes);
 
-				//Go through each component of the molecule
-				for(int s=0; s<m->getMoleculeType()->getNumOfComponents(); s++)
-				{
-					// output the component name
-					string compName = m->getMoleculeType()->getComponentName(s);
-					if(m->getMoleculeType()->isEquivalentComponent(s)) {
-						// symmetric site, so we need to look up its sym name
-						compName = m->getMoleculeType()->getEquivalenceClassComponentNameFromComponentIndex(s);
-					}
-					if(s==0) speciesString += compName;
-					else speciesString += ","+compName;
+	//a reaction joins the types of all the molecules it reads and writes
+	vector < vector <int> > typesOfRxn(allReactions.size());
+	unordered_map <ReactionClass *,int> rxnIndex;
+	for(unsigned int r=0; r<allReactions.size(); r++) {
+		ReactionClass *rxn = allReactions[r];
+		rxnIndex[rxn] = r;
+		for(unsigned int k=0; k<rxn->getAllReactantTemplates().size(); k++)
+			addTypesOfPattern(rxn->getAllReactantTemplates()[k],typesOfRxn[r]);
+		for(unsigned int k=0; k<rxn->getAllProductTemplates().size(); k++)
+			addTypesOfPattern(rxn->getAllProductTemplates()[k],typesOfRxn[r]);
+		for(unsigned int k=0; k<rxn->getNumOfReactants(); k++)
+			typesOfRxn[r].push_back(rxn->getMoleculeTypeOfReactantTemplate(k)->getTypeID());
+	}
+
+	//an observable joins the types of its patterns, and a reaction whose rate
+	//reads the observable through a function joins them as well
+	vector < vector <int> > typesOfObs(obsToOutput.size());
+	for(unsigned int o=0; o<obsToOutput.size(); o++) {
+		int n_templates = 0; TemplateMolecule **tmList = 0;
+		obsToOutput[o]->getTemplateMoleculeList(n_templates,tmList);
+		for(int k=0; k<n_templates; k++)
+			addTypesOfPattern(tmList[k],typesOfObs[o]);
+		for(int k=0; k<obsToOutput[o]->getNumOfDependentRxns(); k++) {
+			unordered_map <ReactionClass *,int>::iterator it = rxnIndex.find(obsToOutput[o]->getDependentRxn(k));
+			if(it!=rxnIndex.end())
+				typesOfRxn[it->second].insert(typesOfRxn[it->second].end(),typesOfObs[o].begin(),typesOfObs[o].end());
+		}
+	}
 
+	for(unsigned int r=0; r<typesOfRxn.size(); r++)
+		for(unsigned int k=1; k<typesOfRxn[r].size(); k++) sets.join(typesOfRxn[r][0],typesOfRxn[r][k]);
+	for(unsigned int o=0; o<typesOfObs.size(); o++)
+		for(unsigned int k=1; k<typesOfObs[o].size(); k++) sets.join(typesOfObs[o][0],typesOfObs[o][k]);
 
-					//output the state of the component, if it is set
-					if(m->getComponentState(s)>=0) {
-						speciesString += "~" + m->getMoleculeType()->getComponentStateName(s,m->getComponentState(s));
-					}
+	//molecules that start out bonded are on the same complex
+	for(int t=0; t<nTypes; t++) {
+		MoleculeType *mt = allMoleculeTypes[t];
+		for(int m=0; m<mt->getMoleculeCount(); m++) {
+			Molecule *mol = mt->getMolecule(m);
+			for(int c=0; c<mt->getNumOfComponents(); c++)
+				if(mol->isBindingSiteBonded(c))
+					sets.join(t,mol->getBondedMolecule(c)->getMoleculeType()->getTypeID());
+		}
+	}
 
+	//functions that read from a file are indexed by an observable that the
+	//function doesn't list, so a model with them is kept whole
+	bool keepWhole = false;
+	for(unsigned int f=0; f<globalFunctions.size(); f++)
+		if(globalFunctions[f]->fileFunc) keepWhole = true;
+	for(unsigned int f=0; f<compositeFunctions.size(); f++)
+		if(compositeFunctions[f]->fileFunc) keepWhole = true;
+	if(keepWhole)
+		for(int t=1; t<nTypes; t++) sets.join(0,t);
 
-					// check if the component is bound, if so we have to output a bond
-					// we will label the bond incrementally, but we have to check to make
-					// sure the bond wasn't declared earlier.  that's what the vector of int vectors is for.
-					if(m->isBindingSiteBonded(s)) {
-						if(debugOut) cout<<"binding site is bonded"<<endl;
-						int partnerID = m->getBondedMolecule(s)->getUniqueID();
-						int partnerSite = m->getBondedMoleculeBindingSiteIndex(s);
-						int thisBondNumber = -1;
-
-						// create the key
-						vector <int> *key = new vector<int>(4);
-						if(partnerID<m->getUniqueID()) {
-							key->at(0) = partnerID; key->at(1) = partnerSite;
-							key->at(2) = m->getUniqueID(); key->at(3)=s;
-						} else {
-							key->at(2) = partnerID; key->at(3) = partnerSite;
-							key->at(0) = m->getUniqueID(); key->at(1)=s;
-						}
-
-						//search if that key was already inserted
-						bool foundExistingBond = false;
-						for(unsigned int bnmIndex =0; bnmIndex < bondNumberMap.size(); bnmIndex++) {
-							if( key->at(0)==bondNumberMap.at(bnmIndex)->at(0) &&
-								key->at(1)==bondNumberMap.at(bnmIndex)->at(1) &&
-							    key->at(2)==bondNumberMap.at(bnmIndex)->at(2) &&
-							    key->at(3)==bondNumberMap.at(bnmIndex)->at(3) ) {
-								    thisBondNumber = bnmIndex+1;
-									foundExistingBond = true;
-									if(debugOut) cout<<"Found bond number: "<<thisBondNumber<<endl;
-									break;
-							}
-						}
-
-						//If it was not found, then insert it
-						if(!foundExistingBond) {
-							bondNumberMap.push_back(key);
-							thisBondNumber = bondNumberMap.size();
-							if(debugOut) cout<<"Creating bond number: "<<bondNumberMap.size()<<endl;
-						}
-						speciesString += "!" + NFutil::toString(thisBondNumber);
-					}
+	//number the sets that reactions change, in the order of their first reaction
+	vector <int> subsystemOfSet(nTypes,-1);
+	n_subsystems = 0;
+	subsystemOfReaction.assign(allReactions.size(),0);
+	for(unsigned int r=0; r<typesOfRxn.size(); r++) {
+		if(typesOfRxn[r].empty()) continue;
+		int set = sets.find(typesOfRxn[r][0]);
+		if(subsystemOfSet[set]<0) subsystemOfSet[set] = n_subsystems++;
+		subsystemOfReaction[r] = subsystemOfSet[set];
+	}
+	//reactions that touch no molecules at all go with the first subsystem
+	if(n_subsystems==0 && !allReactions.empty()) n_subsystems = 1;
 
-				}
+	subsystemOfMoleculeType.assign(nTypes,-1);
+	for(int t=0; t<nTypes; t++)
+		subsystemOfMoleculeType[t] = subsystemOfSet[sets.find(t)];
+	subsystemOfObservable.assign(obsToOutput.size(),-1);
+	for(unsigned int o=0; o<typesOfObs.size(); o++)
+		if(!typesOfObs[o].empty()) subsystemOfObservable[o] = subsystemOfMoleculeType[typesOfObs[o][0]];
+
+	subsystemsFound = true;
+}
 
 
-				speciesString += ")";
+void System::restrictToSubsystem(int subsystem)
+{
+	if(selector==0) {
+		cerr<<"Error in System::restrictToSubsystem()!  The system has to be prepared for simulation"<<endl;
+		cerr<<"before it can be restricted to a subsystem.  quitting."<<endl;
+		exit(1);
+	}
+	vector <ReactionClass *> rxns;
+	for(unsigned int r=0; r<allReactions.size(); r++)
+		if(subsystemOfReaction[r]==subsystem) rxns.push_back(allReactions[r]);
+	delete selector;
+	selector = new DirectSelector(rxns);
+	restrictedSubsystem = subsystem;
+	recompute_A_tot();
+}
+
+
+void System::sampleSubsystem(double sampleTime)
+{
+	stepTo(sampleTime);
+	refreshObservables();
+	//as in sim(), propensities are refreshed after every output
+	recompute_A_tot();
+}
+
+
+void System::outputSubsystemCounts(double cSampleTime, vector <System *> &subsystemSystems)
+{
+	int eventCounter = 0;
+	for(unsigned int k=0; k<subsystemSystems.size(); k++)
+		eventCounter += subsystemSystems[k]->getGlobalEventCounter();
+
+	//the functions of this system read these observables, so that they give the
+	//values of the whole model when written out
+	for(unsigned int o=0; o<obsToOutput.size(); o++) {
+		int k = subsystemOfObservable[o];
+		System *from = subsystemSystems.at(k<0 ? 0 : k);
+		obsToOutput[o]->clear();
+		obsToOutput[o]->straightAdd(from->obsToOutput[o]->getCount());
+	}
+	writeObservableCounts(cSampleTime,eventCounter);
+}
+
+
+// NETGEN  moved to ComplexList
+/*
+void System::printAllComplexes()
+{
+	cout<<"All System Complexes:"<<endl;
+	for(complexIter = allComplexes.begin(); complexIter != allComplexes.end(); complexIter++ )
+		(*complexIter)->printDetails();
+	cout<<endl;
+}
+*/
+
+
+//Fewer species than this are not worth starting another thread for
+static const int MIN_SPECIES_PER_THREAD = 1000;
+
+//Writes the BNGL string of one species, with its members in the order they
+//were found from the first one.  Bonds are numbered in the order they are
+//first seen; memberOf gives the position of a molecule in the species, and
+//siteBond holds room for the bond number of every site of every member.
+static void writeSpeciesString(Molecule **members, int nMembers, const vector <int> &memberOf,
+		const vector <vector <string> > &componentNames, vector <int> &siteOffset, vector <int> &siteBond,
+		string &speciesString)
+{
+	siteOffset.resize(nMembers);
+	int nSites = 0;
+	for(int i=0; i<nMembers; i++) {
+		siteOffset[i] = nSites;
+		nSites += members[i]->getMoleculeType()->getNumOfComponents();
+	}
+	siteBond.assign(nSites,0);
+
+	speciesString.clear();
+	int nBonds = 0;
+	for(int i=0; i<nMembers; i++)
+	{
+		Molecule *m = members[i];
+		MoleculeType *mt = m->getMoleculeType();
+		if(i>0) speciesString += ".";
+		speciesString += mt->getName();
+		speciesString += "(";
+		const vector <string> &names = componentNames[mt->getTypeID()];
+		for(int c=0; c<mt->getNumOfComponents(); c++)
+		{
+			if(c>0) speciesString += ",";
+			speciesString += names[c];
+			if(m->getComponentState(c)>=0) {
+				speciesString += "~";
+				speciesString += mt->getComponentStateName(c,m->getComponentState(c));
 			}
 
-			if(reportedSpecies.find(speciesString) != reportedSpecies.end()) {
-				reportedSpecies[speciesString] = reportedSpecies[speciesString] + mt->getMolecule(j)->getPopulation();
-			} else {
-				reportedSpecies.insert(pair <string,int> (speciesString, mt->getMolecule(j)->getPopulation()));
+			// a bond keeps the number it got at whichever of its sites came first,
+			// except one between two sites of the same molecule, which has always
+			// been given a new number at each of its sites
+			if(m->isBindingSiteBonded(c)) {
+				Molecule *partner = m->getBondedMolecule(c);
+				if(siteBond[siteOffset[i]+c]==0) {
+					siteBond[siteOffset[i]+c] = ++nBonds;
+					if(partner!=m)
+						siteBond[siteOffset[memberOf[partner->getUniqueID()]]+m->getBondedMoleculeBindingSiteIndex(c)] = nBonds;
+				}
+				speciesString += "!";
+				speciesString += NFutil::toString(siteBond[siteOffset[i]+c]);
 			}
+		}
+		speciesString += ")";
+	}
+}
 
-			//speciesString += "  1";
-			//cout<<speciesString<<endl;
 
-			if(debugOut) cout<<endl<<endl;
+bool System::saveSpecies(string filename)
+{
+	//open the output filestream, with a large buffer for gels
+	vector <char> buffer(1<<20);
+	ofstream speciesFile;
+	speciesFile.rdbuf()->pubsetbuf(&buffer[0],buffer.size());
+	speciesFile.open(filename.c_str());
+	if(!speciesFile.is_open()) {
+		cerr<<"Error in System when calling System::saveSpecies(string)!  Cannot open output stream to file "<<filename<<". "<<endl;
+		cerr<<"quitting."<<endl;
+		exit(1);
+	}
 
-			//delete elements of the map
-			while(bondNumberMap.size()>0) {
-				vector <int> *v = bondNumberMap.at(bondNumberMap.size()-1);
-				bondNumberMap.pop_back();
-				delete v;
-			}
+	cout<<"\n\nsaving list of final molecular species..."<<endl;
 
-			if(debugOut) cout<<endl<<endl;
+	// the names the components are written with, symmetric sites under their sym name
+	int maxID = -1;
+	vector <vector <string> > componentNames(allMoleculeTypes.size());
+	for( unsigned int k=0; k<allMoleculeTypes.size(); k++)
+	{
+		MoleculeType *mt = allMoleculeTypes.at(k);
+		vector <string> &names = componentNames.at(mt->getTypeID());
+		for(int c=0; c<mt->getNumOfComponents(); c++) {
+			if(mt->isEquivalentComponent(c)) names.push_back(mt->getEquivalenceClassComponentNameFromComponentIndex(c));
+			else names.push_back(mt->getComponentName(c));
+		}
+		for(int j=0; j<mt->getMoleculeCount(); j++)
+			maxID = max(maxID,mt->getMolecule(j)->getUniqueID());
+	}
 
+	// Split the molecules into species, in the order of the types and of the
+	// molecules in each type.  Each species lists its members in the order a
+	// breadth first search from its first molecule finds them, all in one array.
+	vector <Molecule *> members;
+	vector <int> speciesStart;
+	vector <int> memberOf(maxID+1,-1);
+	for( unsigned int k=0; k<allMoleculeTypes.size(); k++)
+	{
+		MoleculeType *mt = allMoleculeTypes.at(k);
+		for(int j=0; j<mt->getMoleculeCount(); j++)
+		{
+			Molecule *first = mt->getMolecule(j);
+			if(memberOf[first->getUniqueID()]>=0) continue;
+
+			int start = members.size();
+			speciesStart.push_back(start);
+			memberOf[first->getUniqueID()] = 0;
+			members.push_back(first);
+			for(unsigned int next=start; next<members.size(); next++)
+			{
+				Molecule *m = members[next];
+				for(int c=0; c<m->getMoleculeType()->getNumOfComponents(); c++)
+				{
+					if(!m->isBindingSiteBonded(c)) continue;
+					Molecule *neighbor = m->getBondedMolecule(c);
+					if(memberOf[neighbor->getUniqueID()]>=0) continue;
+					memberOf[neighbor->getUniqueID()] = members.size()-start;
+					members.push_back(neighbor);
+				}
+			}
 		}
 	}
+	speciesStart.push_back(members.size());
+	int nSpecies = speciesStart.size()-1;
+
+	// Write and intern the species on several threads.  Each range of species
+	// gets its own table from species string to an integer id, and the count of
+	// each id, which are added up in range order afterwards.
+	int maxRanges = observableThreads;
+	vector <unordered_map <string,int> > speciesIds(maxRanges);
+	vector <vector <int> > speciesCounts(maxRanges);
+	int nRanges = NFutil::runInRanges(nSpecies, maxRanges, MIN_SPECIES_PER_THREAD,
+		[&](int begin, int end, int r) {
+			vector <int> siteOffset, siteBond;
+			string speciesString;
+			for(int sp=begin; sp<end; sp++)
+			{
+				Molecule **first = &members[speciesStart[sp]];
+				writeSpeciesString(first, speciesStart[sp+1]-speciesStart[sp], memberOf,
+						componentNames, siteOffset, siteBond, speciesString);
+				pair <unordered_map <string,int>::iterator,bool> id =
+						speciesIds[r].insert(pair <string,int> (speciesString, speciesCounts[r].size()));
+				if(id.second) speciesCounts[r].push_back(0);
+				speciesCounts[r][id.first->second] += (*first)->getPopulation();
+			}
+		});
 
+	map <string,int> reportedSpecies;
+	for(int r=0; r<nRanges; r++)
+		for(unordered_map <string,int>::iterator it=speciesIds[r].begin(); it!=speciesIds[r].end(); it++)
+			reportedSpecies[it->first] += speciesCounts[r][it->second];
 
 	speciesFile<<"# nfsim generated species list for system: '"<< this->name <<"'\n";
 	speciesFile<<"# warning! this feature is not yet fully tested! \n";
@@ -1834,8 +2440,10 @@ bool System::addCompositeFunction(CompositeFunction *cf) {
 
 Observable * System::getObservableByName(string obsName)
 {
+	//whoever asks for an observable may read it at any time
 	for(unsigned int i=0; i<obsToOutput.size(); i++) {
 		if(obsToOutput.at(i)->getName().compare(obsName)==0) {
+			keepOnTheFly(obsToOutput.at(i));
 			return obsToOutput.at(i);
 		}
 	}
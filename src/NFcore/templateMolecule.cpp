@@ -7,10 +7,12 @@ using namespace NFcore;
 
 
 
-queue <TemplateMolecule *> TemplateMolecule::q;
-queue <int> TemplateMolecule::d;
-vector <TemplateMolecule *>::iterator TemplateMolecule::tmVecIter;
-list <TemplateMolecule *>::iterator TemplateMolecule::tmIter;
+thread_local queue <TemplateMolecule *> TemplateMolecule::q;
+thread_local queue <int> TemplateMolecule::d;
+thread_local vector <TemplateMolecule *>::iterator TemplateMolecule::tmVecIter;
+thread_local list <TemplateMolecule *>::iterator TemplateMolecule::tmIter;
+thread_local unsigned long TemplateMolecule::currentMatchEvent=0;
+thread_local unsigned long TemplateMolecule::lastMatchEvent=0;
 
 int TemplateMolecule::TotalTemplateMoleculeCount=0;
 
@@ -78,6 +80,20 @@ TemplateMolecule::TemplateMolecule(MoleculeType * moleculeType){
 	this->matchMolecule=0;
 	this->hasVisitedThis=false;
 
+	this->signatureStatus=SIGNATURE_UNKNOWN;
+	this->sigStateMask=0;
+	this->sigStateValue=0;
+	this->sigEmptyMask=0;
+	this->sigOccupiedMask=0;
+
+	this->canonicalPattern=this;
+	this->patternId=-1;
+	for(int k=0; k<MATCH_SLOTS; k++) {
+		matchSlotMolecule[k]=0;
+		matchSlotEvent[k]=0;
+		matchSlotResult[k]=false;
+	}
+
 	//finally, we have to register this template molecule with the molecule
 	//type so that we can easily destroy them at the end.
 	this->moleculeType->addTemplateMolecule(this);
@@ -764,6 +780,127 @@ void TemplateMolecule::clearTemplateOnly() {
 
 
 
+bool TemplateMolecule::hasSignature()
+{
+	if(signatureStatus!=SIGNATURE_UNKNOWN) return signatureStatus==SIGNATURE_READY;
+
+	signatureStatus=SIGNATURE_NONE;
+	if(n_bonds>0 || n_connectedTo>0 || n_symComps>0 || !moleculeType->canPackState()) return false;
+
+	unsigned long long stateMask=0, stateValue=0, emptyMask=0, occupiedMask=0;
+	for(int c=0; c<n_compStateConstraint; c++) {
+		int cIndex = compStateConstraint_Comp[c];
+		int bits = moleculeType->getStateFieldBits(cIndex);
+		int value = compStateConstraint_Constraint[c];
+		if(bits==0 || value<0 || (value>>bits)!=0) return false;
+		unsigned long long fieldMask = ((1ULL<<bits)-1) << moleculeType->getStateFieldOffset(cIndex);
+		unsigned long long fieldValue = ((unsigned long long)value) << moleculeType->getStateFieldOffset(cIndex);
+		//two different constraints on one component can't be folded into a mask
+		if((stateMask & fieldMask)!=0 && (stateValue & fieldMask)!=fieldValue) return false;
+		stateMask |= fieldMask;
+		stateValue |= fieldValue;
+	}
+	for(int c=0; c<n_emptyComps; c++) emptyMask |= 1ULL<<emptyComps[c];
+	for(int c=0; c<n_occupiedComps; c++) occupiedMask |= 1ULL<<occupiedComps[c];
+
+	sigStateMask=stateMask;
+	sigStateValue=stateValue;
+	sigEmptyMask=emptyMask;
+	sigOccupiedMask=occupiedMask;
+	signatureStatus=SIGNATURE_READY;
+	return true;
+}
+
+
+bool TemplateMolecule::compareSignature(Molecule *m, unsigned long long stateWord, unsigned long long bondWord) const
+{
+	if(m->getMoleculeType()!=moleculeType) return false;
+	if((stateWord & sigStateMask)!=sigStateValue) return false;
+	if((bondWord & sigEmptyMask)!=0) return false;
+	if((bondWord & sigOccupiedMask)!=sigOccupiedMask) return false;
+	for(int c=0; c<n_compStateExclusion; c++)
+		if(m->getComponentState(compStateExclusion_Comp[c]) == compStateExclusion_Exclusion[c]) return false;
+	return true;
+}
+
+
+void TemplateMolecule::startMatchEvent()
+{
+	//event 0 means no event, so a slot that was never written can't look current
+	currentMatchEvent = ++lastMatchEvent;
+}
+
+
+void TemplateMolecule::endMatchEvent()
+{
+	currentMatchEvent = 0;
+}
+
+
+bool TemplateMolecule::getSignatureKey(vector <unsigned long long> &key)
+{
+	key.clear();
+	if(!hasSignature()) return false;
+	key.push_back(sigStateMask);
+	key.push_back(sigStateValue);
+	key.push_back(sigEmptyMask);
+	key.push_back(sigOccupiedMask);
+	//the exclusions can be given in any order, and one of them twice
+	vector <unsigned long long> exclusions;
+	for(int c=0; c<n_compStateExclusion; c++)
+		exclusions.push_back((((unsigned long long)compStateExclusion_Comp[c])<<32) | (unsigned int)compStateExclusion_Exclusion[c]);
+	sort(exclusions.begin(),exclusions.end());
+	exclusions.erase(unique(exclusions.begin(),exclusions.end()),exclusions.end());
+	key.insert(key.end(),exclusions.begin(),exclusions.end());
+	return true;
+}
+
+
+bool TemplateMolecule::matchesAnyMolecule()
+{
+	return hasSignature() && sigStateMask==0 && sigEmptyMask==0 && sigOccupiedMask==0 && n_compStateExclusion==0;
+}
+
+
+void TemplateMolecule::setCanonicalPattern(TemplateMolecule *canonical, int patternId)
+{
+	this->canonicalPattern=canonical;
+	this->patternId=patternId;
+}
+
+
+bool TemplateMolecule::findRememberedMatch(Molecule *m, bool &matches) const
+{
+	if(currentMatchEvent==0) return false;
+	const TemplateMolecule *p = canonicalPattern;
+	int slot = m->getUniqueID() & (MATCH_SLOTS-1);
+	if(p->matchSlotEvent[slot]!=currentMatchEvent || p->matchSlotMolecule[slot]!=m) return false;
+	matches = p->matchSlotResult[slot];
+	return true;
+}
+
+
+void TemplateMolecule::rememberMatch(Molecule *m, bool matches)
+{
+	if(currentMatchEvent==0) return;
+	TemplateMolecule *p = canonicalPattern;
+	int slot = m->getUniqueID() & (MATCH_SLOTS-1);
+	p->matchSlotMolecule[slot]=m;
+	p->matchSlotEvent[slot]=currentMatchEvent;
+	p->matchSlotResult[slot]=matches;
+}
+
+
+bool TemplateMolecule::compareOnce(Molecule *m)
+{
+	bool matches;
+	if(findRememberedMatch(m,matches)) return matches;
+	matches = compare(m);
+	rememberMatch(m,matches);
+	return matches;
+}
+
+
 bool TemplateMolecule::compare(Molecule *m)
 {
 	// I think we need a 4th argument?  To be safe. --Justin
@@ -1043,10 +1180,63 @@ bool TemplateMolecule::isSymMapValid()
 }
 
 
+bool TemplateMolecule::compareOwnSites(Molecule *m) const
+{
+	if(m->getMoleculeType()!=this->moleculeType) return false;
+	for(int c=0; c<n_compStateConstraint; c++)
+		if(m->getComponentState(compStateConstraint_Comp[c]) != compStateConstraint_Constraint[c]) return false;
+	for(int c=0; c<n_compStateExclusion; c++)
+		if(m->getComponentState(compStateExclusion_Comp[c]) == compStateExclusion_Exclusion[c]) return false;
+	for(int c=0; c<n_emptyComps; c++)
+		if(!m->isBindingSiteOpen(emptyComps[c])) return false;
+	for(int c=0; c<n_occupiedComps; c++)
+		if(!m->isBindingSiteBonded(occupiedComps[c])) return false;
+	for(int b=0; b<n_bonds; b++)
+		if(m->isBindingSiteOpen(bondComp[b])) return false;
+
+	//a symmetric component can go to any site of its class, so the molecule only
+	//needs as many sites that fit it as the template has components just like it
+	for(int c=0; c<n_symComps; c++)
+	{
+		int wanted = 0;
+		for(int k=0; k<n_symComps; k++) {
+			if(symCompBoundState[k]==symCompBoundState[c] && symCompStateConstraint[k]==symCompStateConstraint[c] &&
+					symCompName[k]==symCompName[c]) wanted++;
+		}
+		int *molEqComp; int n_molEqComp=0;
+		moleculeType->getEquivalencyClass(molEqComp,n_molEqComp,symCompName[c]);
+		for(int sc=0; sc<n_molEqComp && wanted>0; sc++) {
+			if(symCompBoundState[c]==TemplateMolecule::EMPTY && !m->isBindingSiteOpen(molEqComp[sc])) continue;
+			if(symCompBoundState[c]==TemplateMolecule::OCCUPIED && !m->isBindingSiteBonded(molEqComp[sc])) continue;
+			if(symCompStateConstraint[c]!=TemplateMolecule::NO_CONSTRAINT &&
+					m->getComponentState(molEqComp[sc])!=symCompStateConstraint[c]) continue;
+			wanted--;
+		}
+		if(wanted>0) return false;
+	}
+	return true;
+}
+
+
+//compare() starts a new mapping set for each equivalent site of a symmetric
+//component that is bound in the pattern, and only one if there are none
+int TemplateMolecule::getMaxMappingSets() const
+{
+	int n = 0;
+	for(int c=0; c<n_symComps; c++)
+	{
+		if(symBondPartner[c]==0) continue;
+		int *molEqComp; int n_molEqComp=0;
+		moleculeType->getEquivalencyClass(molEqComp,n_molEqComp,this->symCompName[c]);
+		n += n_molEqComp;
+	}
+	return n>0 ? n : 1;
+}
 
 
 bool TemplateMolecule::compare(Molecule *m, ReactantContainer *rc, MappingSet *ms, bool holdMolClearToEnd, vector<MappingSet*> *symmetricMappingSet)
 {
+	NF_PROFILE_COMPARE();
 	//bool de=false;
 	//if(this->uniqueTemplateID==5 ) cout<<"\n\n---\n";
 	//if( this->uniqueTemplateID==5 || this->uniqueTemplateID==6 || this->uniqueTemplateID==7) {
@@ -51,6 +51,10 @@ namespace NFcore
 			return symCompBondCounter;
 		}
 		int getN_mapGenerators() const { return n_mapGenerators; }
+
+		/* the most mapping sets that compare() can give for one molecule when it
+		 * is asked for every symmetric mapping, see BasicRxnClass::tryToAdd() */
+		int getMaxMappingSets() const;
 		int getN_connectedTo() const { return n_connectedTo; };
 
 		/* functions that allow you to set constraints */
@@ -102,6 +106,39 @@ namespace NFcore
 		/* functions that are needed to match to a molecule instance */
 		bool compare(Molecule *m);
 		bool compare(Molecule *m, ReactantContainer *rc, MappingSet *ms,bool holdMolClearToEnd=false,vector<MappingSet*>* v = 0);
+
+		/* only the states and bonds that this template asks of the molecule's own
+		 * components, without following bonds or marking anything (for symmetric
+		 * components, that the molecule has enough sites that fit them).  A molecule
+		 * that fails this can't match, one that passes still has to go through compare() */
+		bool compareOwnSites(Molecule *m) const;
+
+		/* A template that only constrains the states and bonds of its own molecule (no
+		 * bonds to other templates, nothing connected with the dot operator and no
+		 * symmetric sites) can also be matched against the words that
+		 * MoleculeType::packState() gives for a molecule, with a few masks.  The masks
+		 * are built the first time they are asked for, so only once the template is
+		 * complete.  hasSignature() returns false for any other template, which has
+		 * to go through compare() */
+		bool hasSignature();
+		bool compareSignature(Molecule *m, unsigned long long stateWord, unsigned long long bondWord) const;
+
+		/* Templates with a signature that ask for exactly the same states and bonds are
+		 * one pattern.  MoleculeType::findSamePatterns() gives every template a pattern
+		 * id and points it at the first template with that pattern, its canonical one.
+		 * Between startMatchEvent() and endMatchEvent(), which ReactionClass::fire() puts
+		 * around the updates of its products, the result of matching a molecule is kept
+		 * on the canonical template, so the reactions, observables and local functions
+		 * that share a pattern match each molecule against it only once */
+		static void startMatchEvent();
+		static void endMatchEvent();
+		bool getSignatureKey(vector <unsigned long long> &key);
+		bool matchesAnyMolecule();
+		void setCanonicalPattern(TemplateMolecule *canonical, int patternId);
+		int getPatternId() const { return patternId; };
+		bool findRememberedMatch(Molecule *m, bool &matches) const;
+		void rememberMatch(Molecule *m, bool matches);
+		bool compareOnce(Molecule *m);
 		void clear();
 		void clearTemplateOnly();
 		bool tryToMap(Molecule *toMap, string toMapComponent,
@@ -219,15 +256,36 @@ namespace NFcore
 
 
 		//For depth first traversals on a template molecule
-		static queue <TemplateMolecule *> q;
-		static queue <int> d;
-		static vector <TemplateMolecule *>::iterator tmVecIter;
-		static list <TemplateMolecule *>::iterator tmIter;
+		static thread_local queue <TemplateMolecule *> q;
+		static thread_local queue <int> d;
+		static thread_local vector <TemplateMolecule *>::iterator tmVecIter;
+		static thread_local list <TemplateMolecule *>::iterator tmIter;
 
 		// For tracking the reactant or product that this TemplateMolecule is
 		// transformed into
 		TemplateMolecule * mappedTm;
 
+		// The masks used by compareSignature(), see hasSignature()
+		const static int SIGNATURE_UNKNOWN=-1;
+		const static int SIGNATURE_NONE=0;
+		const static int SIGNATURE_READY=1;
+		int signatureStatus;
+		unsigned long long sigStateMask;
+		unsigned long long sigStateValue;
+		unsigned long long sigEmptyMask;
+		unsigned long long sigOccupiedMask;
+
+		// The pattern this template shares with others, and the matches remembered
+		// for it during the current event, one slot per (unique id mod MATCH_SLOTS)
+		TemplateMolecule *canonicalPattern;
+		int patternId;
+		const static int MATCH_SLOTS=8;
+		Molecule *matchSlotMolecule[MATCH_SLOTS];
+		unsigned long matchSlotEvent[MATCH_SLOTS];
+		bool matchSlotResult[MATCH_SLOTS];
+		static thread_local unsigned long currentMatchEvent;
+		static thread_local unsigned long lastMatchEvent;
+
 	};
 
 }
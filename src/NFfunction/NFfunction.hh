@@ -144,6 +144,14 @@ namespace NFcore {
 
 			void updateParameters(System *s);
 
+			/*!
+				Evaluates the function, unless none of the observables it reads have changed
+				since the last time this was called, in which case the last value is given
+				back without running the parser.  Functions that read a file are always
+				evaluated.
+			*/
+			double getValue();
+
 
 
 			/*!
@@ -221,6 +229,12 @@ namespace NFcore {
 			vector <vector <double> > data;
 			string filePath;
 			// AS-2021
+
+			//the variables of the parser, and their values when lastValue was computed
+			vector <double *> inputs;
+			vector <double> lastInputs;
+			double lastValue;
+			bool isLastValueKnown;
 	};
 
 
@@ -301,6 +315,10 @@ namespace NFcore {
 
 
 			double getValue(Molecule *m, int scope);
+			// the value stored on m, which must be one of the type I molecules, if not
+			// this gives false where getValue() throws a LocalFunctionException
+			bool getSpeciesValue(Molecule *m, double &value);
+			vector <MoleculeType *> * getTypeIMolecules() { return &typeI_mol; };
 			double evaluateOn(Molecule *m, int scope);
 			// this version evaluates local fcn on a complex with SPECIES scope
 			double evaluateOn(Complex *c);
@@ -343,8 +361,8 @@ namespace NFcore {
 			Observable **varLocalObservables;
 
 
-			static list <Molecule *> molList;
-			static list <Molecule *>::iterator molIter;
+			static thread_local list <Molecule *> molList;
+			static thread_local list <Molecule *>::iterator molIter;
 
 			//Here we store back pointers into both type I and type II molecules
 			//Remember that type I molecules must store the value of this function
@@ -389,6 +407,11 @@ namespace NFcore {
 				void setGlobalObservableDependency(ReactionClass *r, System *s);
 
 				double evaluateOn(Molecule **molList, int *scope, int *curReactantCounts, int n_reactants);
+				/* Same as above, but instead of throwing a LocalFunctionException gives back
+				 * the index of the first local function that could not be read from the
+				 * molecule it was given, or -1 once value is set */
+				int evaluateOn(Molecule **molList, int *scope, int *curReactantCounts, int n_reactants, double &value);
+				vector <MoleculeType *> * getTypeIMolecules(int refLfIndex) { return lfs[refLfInds[refLfIndex]]->getTypeIMolecules(); };
 
 				void printDetails(System *s);
 
@@ -431,47 +431,46 @@ void CompositeFunction::addTypeIMoleculeDependency(MoleculeType *mt) {
 
 
 double CompositeFunction::evaluateOn(Molecule **molList, int *scope, int *curReactantCounts, int n_reactants) {
+	double value;
+	int failed = evaluateOn(molList, scope, curReactantCounts, n_reactants, value);
+	if(failed>=0) {
+		//the parameter that we sent in is incorrect
+		LocalFunctionException lfe;
+		lfe.setType1_Mol(getTypeIMolecules(failed));
+		lfe.setIndex(failed);
+		throw lfe;
+	}
+	return value;
+}
+
+
+int CompositeFunction::evaluateOn(Molecule **molList, int *scope, int *curReactantCounts, int n_reactants, double &value) {
 	//cout << "CompositeFunction::evaluateOn()" << endl;
 
-	//1 evaluate all global functions
-	//cout << "n_gfs=" << n_gfs << endl;
+	//1 get the values of all global functions, which are only evaluated again
+	//once the observables they read have changed
 	for(int f=0; f<n_gfs; f++) {
-		// AS-2021
-		if (gfs[f]->fileFunc==true) {
-			gfs[f]->fileUpdate();
-		}
-		// AS-2021
-		gfValues[f]=FuncFactory::Eval(gfs[f]->p);
+		gfValues[f]=gfs[f]->getValue();
 	}
 
 	//2 evaluate all local functions
-	//cout << "n_lfs=" << n_lfs << endl;
-	//cout << "scope[0]=" << scope[0] << endl;
-	//cout << "molList[0]" << molList[0]->getMoleculeTypeName() << endl;
-	
 	if(n_lfs>0) {
 
 		//cout<<"evaluating composite function with local dependencies."<<endl;
 		if(molList!=0 && scope!=0) {
 
-			//cout << "n_refLfs=" << n_refLfs << endl;
 			for(int i=0; i<n_refLfs; i++) {
 				//cout<<"--- evaluating: "<<lfs[refLfInds[i]]->getNiceName()<<" with scope: "<<scope[refLfScopes[i]]<<endl;
-				try{
-					this->refLfValues[i] = this->lfs[refLfInds[i]]->getValue(molList[refLfScopes[i]],scope[refLfScopes[i]]);
-				}
-				catch (LocalFunctionException &lfe){
-					//the parameter that we sent in is incorrect
-					lfe.setIndex(i);
-					throw lfe;
+				Molecule *m = molList[refLfScopes[i]];
+				int lfScope = scope[refLfScopes[i]];
+				if(lfScope==LocalFunction::SPECIES) {
+					if(!lfs[refLfInds[i]]->getSpeciesValue(m,refLfValues[i])) return i;
+				} else {
+					refLfValues[i] = lfs[refLfInds[i]]->getValue(m,lfScope);
 				}
 				//cout<<"answer: "<<this->refLfValues[i]<<endl;
 			}
 
-			//for (n_refLfs)  set the value by calling the correct local function to evaluate on the specified scope
-			//which we reference through the given molList.
-			//this->refLfValues[i] = this->lfs[refLfInds[i]]->evaluateOn(molList[refLfScopes[i]],scope[refLfScopes[i]]);
-
 		} else {
 
 			cout<<"Error evaluating composite function: "<<name<<endl;
@@ -498,8 +497,8 @@ double CompositeFunction::evaluateOn(Molecule **molList, int *scope, int *curRea
 		this->fileUpdate();
 	} 
 	// AS-2021
-	return FuncFactory::Eval(p);
-	//evaluate this function
+	value = FuncFactory::Eval(p);
+	return -1;
 }
 
 // AS-2021
@@ -37,6 +37,8 @@ GlobalFunction::GlobalFunction(string name,
 		this->paramNames[i]=paramNames.at(i);
 	}
 	p=0;
+	lastValue=0;
+	isLastValueKnown=false;
 
 	// AS-2021
 	this->fileFunc = false;
@@ -85,6 +87,12 @@ void GlobalFunction::prepareForSimulation(System *s)
 		}
 		p->SetExpr(this->funcExpression);
 
+		inputs.clear();
+		const mu::varmap_type &vars = p->GetVar();
+		for(mu::varmap_type::const_iterator v=vars.begin(); v!=vars.end(); v++)
+			inputs.push_back(v->second);
+		lastInputs.assign(inputs.size(),0);
+		isLastValueKnown=false;
 	}
 	catch (mu::Parser::exception_type &e)
 	{
@@ -100,7 +108,29 @@ void GlobalFunction::updateParameters(System *s) {
 	for(unsigned int i=0; i<n_params; i++) {
 		p->DefineConst(paramNames[i],s->getParameter(paramNames[i]));
 	}
+	isLastValueKnown=false;
+}
+
+
+double GlobalFunction::getValue()
+{
+	if(fileFunc) {
+		fileUpdate();
+		return FuncFactory::Eval(p);
+	}
 
+	bool changed = !isLastValueKnown;
+	for(unsigned int i=0; i<inputs.size(); i++) {
+		if(*inputs[i]!=lastInputs[i]) {
+			lastInputs[i] = *inputs[i];
+			changed = true;
+		}
+	}
+	if(changed) {
+		lastValue = FuncFactory::Eval(p);
+		isLastValueKnown = true;
+	}
+	return lastValue;
 }
 
 
@@ -19,8 +19,8 @@ using namespace mu;
 
 
 
-list <Molecule *> LocalFunction::molList;
-list <Molecule *>::iterator LocalFunction::molIter;
+thread_local list <Molecule *> LocalFunction::molList;
+thread_local list <Molecule *>::iterator LocalFunction::molIter;
 
 
 string LocalFunction::getName() const {
@@ -216,6 +216,20 @@ void LocalFunction::prepareForSimulation(System *s) {
 }
 
 
+bool LocalFunction::getSpeciesValue(Molecule *m, double &value)
+{
+	for(unsigned int ti=0; ti<typeI_mol.size(); ti++) {
+		//cout << "this molecule has type: " << m->getMoleculeTypeName() << endl;
+		//cout << "current typeI_mol is: " << typeI_mol.at(ti)->getName() << endl;
+		if(m->getMoleculeType()==typeI_mol[ti]) {
+			value = m->getLocalFunctionValue(typeI_localFunctionIndex[ti]);
+			return true;
+		}
+	}
+	return false;
+}
+
+
 double LocalFunction::getValue(Molecule *m, int scope)
 {
 	//cout<<"getting local function value: "<<this->nicename<<endl;
@@ -223,13 +237,8 @@ double LocalFunction::getValue(Molecule *m, int scope)
 
 	if(scope==LocalFunction::SPECIES) {
 		//cout<<"Species scope"<<endl;
-		for(unsigned int ti=0; ti<typeI_mol.size(); ti++) {
-			//cout << "this molecule has type: " << m->getMoleculeTypeName() << endl;
-			//cout << "current typeI_mol is: " << typeI_mol.at(ti)->getName() << endl;
-			if(m->getMoleculeType()==typeI_mol.at(ti)) {
-				return m->getLocalFunctionValue(typeI_localFunctionIndex.at(ti));
-			}
-		}
+		double value;
+		if(getSpeciesValue(m,value)) return value;
 		LocalFunctionException lfe;
 		lfe.setType1_Mol(&typeI_mol);
 		throw lfe;
@@ -312,6 +312,7 @@ namespace NFinput {
 
 	bool readRNFfile(map<string,string> &argMap, vector<string> &commands, bool verbose);
 	bool runRNFcommands(System *s, map<string,string> &argMap, vector<string> &commands, bool verbose);
+	bool runRNFcommand(System *s, string command, bool verbose); /* false if the command is not known */
 
 
 	//bool runRNFscript(map<string,string> argMap) {};
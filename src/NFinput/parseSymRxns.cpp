@@ -576,46 +576,6 @@ void assembleFullSymmetryListOnRxnCenter(
 
 
 
-//Checks only at reaction center (Assumes all symmetries are at reaction center!)
-bool isMoleculePermuationValid(
-		int mId,
-		vector <vector <vector <component> > > &symmetries,
-		vector <vector <int> > &originalPosition,
-		vector <string> &uniqueComponents,
-		vector <int> &currentPosition,
-		vector <map <string,component> > &thisMoleculeSymMap
-		)
-{
-	//First check if this permutation is self consistent (meaning each
-	//unique component is mapped to only one symmetric component)
-	vector <string> usedNames;
-	for(unsigned int k=0; k<currentPosition.size(); k++) {
-		component *c;
-		c = &symmetries.at(mId).at(0).at(originalPosition.at(k).at(currentPosition.at(k)));
-
-		for(unsigned int u=0; u<usedNames.size(); u++) {
-			if(usedNames.at(u).compare(c->symPermutationName)==0) {
-				return false;
-			}
-		}
-		usedNames.push_back(c->symPermutationName);
-	}
-
-	return true;
-
-
-
-	///// Output for debugging
-	//cout<<"currentPosition (originalPosition) Array"<<endl;
-	//for(unsigned int k=0; k<currentPosition.size(); k++) {
-	//	cout<<currentPosition.at(k)<<" (";
-	//	cout<<originalPosition.at(k).at(currentPosition.at(k))<<") ";
-	//}
-	//cout<<endl;
-}
-
-
-
 //
 void assembleOffRxnCenterSymClasses(
 		vector <vector <vector <string> > > &offRxnCenterSymClasses, //the output
@@ -728,6 +688,54 @@ void assembleOffRxnCenterSymClasses(
 
 
 
+//Fills in the choices for unique components k and on, depth first.  A name
+//that an earlier component of the same class already took is skipped right
+//away, so only the valid permutations are ever visited, in the same order
+//that counting through all of the combinations would give them.
+static void enumerateSymmetricChoices(
+		vector <string> &className,
+		vector <int> &classSize,
+		vector <int> &choice,
+		unsigned int k,
+		vector <vector <int> > &choices)
+{
+	if(k==choice.size()) {
+		choices.push_back(choice);
+		return;
+	}
+	for(int e=0; e<classSize.at(k); e++) {
+		bool isTaken = false;
+		for(unsigned int j=0; j<k && !isTaken; j++)
+			isTaken = (choice.at(j)==e && className.at(j)==className.at(k));
+		if(isTaken) continue;
+		choice.at(k) = e;
+		enumerateSymmetricChoices(className,classSize,choice,k+1,choices);
+	}
+}
+
+
+//Returns, for a molecule whose unique components are in the given equivalency
+//classes, every valid choice of a name for each of them (as the position of the
+//name in the class).  The same molecule pattern shows up in many rules and
+//observables, so the choices are computed only once for each set of classes.
+static vector <vector <int> > & getSymmetricChoices(vector <string> &className, vector <int> &classSize)
+{
+	static thread_local map <string, vector <vector <int> > > cache;
+
+	stringstream key;
+	for(unsigned int k=0; k<className.size(); k++)
+		key<<className.at(k)<<"/"<<classSize.at(k)<<";";
+
+	map <string, vector <vector <int> > >::iterator found = cache.find(key.str());
+	if(found!=cache.end()) return found->second;
+
+	vector <vector <int> > &choices = cache[key.str()];
+	vector <int> choice(className.size(),0);
+	enumerateSymmetricChoices(className,classSize,choice,0,choices);
+	return choices;
+}
+
+
 bool NFinput::generateRxnPermutations(vector<map<string,component> > &permutations,
 		map<string,component> &symComps,
 		map<string,component> &symRxnCenter,
@@ -815,58 +823,25 @@ bool NFinput::generateRxnPermutations(vector<map<string,component> > &permutatio
 		//} cout<<endl;
 
 
-		vector <int> currentPosition;
-		for(unsigned int i=0; i<uniqueComponents.size(); i++) currentPosition.push_back(0);
-
+		// Each valid permutation gives every unique component one of the names in
+		// its equivalency class, without using a name twice.  Which choices are
+		// valid only depends on the classes, so they are looked up in a cache
+		// that is shared by all the rules and patterns.
+		vector <string> className;
+		vector <int> classSize;
+		for(unsigned int i=0; i<uniqueComponents.size(); i++) {
+			className.push_back(symRxnCenterComp.at(originalPosition.at(i).at(0)).name);
+			classSize.push_back(originalPosition.at(i).size());
+		}
+		vector <vector <int> > &choices = getSymmetricChoices(className,classSize);
 
-		bool isDone = false;
-		while(!isDone)
+		for(unsigned int p=0; p<choices.size(); p++)
 		{
-			//Determine if the current permutation is valid...
-			bool isValid = isMoleculePermuationValid(mId,
-					symmetries,originalPosition,uniqueComponents,currentPosition,
-					thisMoleculeSymMap);
-
-			//If it is valid, then we have to add it to the list of permutations on this molecule
-			if(isValid) {
-
-				//Create the sym Map for this molecule
-				map <string,component> moleculeSymMapForThisPermutation;
-				createMoleculeSymMap(moleculeSymMapForThisPermutation,mId,
-						symmetries,isRxnCenter,originalPosition,currentPosition);
-				thisMoleculeSymMap.push_back(moleculeSymMapForThisPermutation);
-
-				/// Output for debugging
-				//cout<<"   [ ";
-				//for(unsigned int k=0; k<currentPosition.size(); k++) {
-				//	component *c;
-				//	if(isRxnCenter.at(k)) {
-				//		c = &symmetries.at(mId).at(0).at(originalPosition.at(k).at(currentPosition.at(k)));
-				//		cout<<"*";
-				//	} else {
-				//		c = &symmetries.at(mId).at(1).at(originalPosition.at(k).at(currentPosition.at(k)));
-				//	}
-				//	cout<<c->symPermutationName<<" ";
-				//}
-				//cout<<" ]"<<endl;
-			}
-
-
-			// go to the next permutation, by ratcheting up like an odometer
-			int currentComponent = uniqueComponents.size()-1;
-			do {
-				currentPosition.at(currentComponent)++;
-				if(currentPosition.at(currentComponent)>=(int)originalPosition.at(currentComponent).size()) {
-					currentPosition.at(currentComponent) = 0;
-					currentComponent--;
-				} else {
-					break;
-				}
-				if(currentComponent<0) {
-					isDone = true; break;
-				}
-			} while(true);
-
+			//Create the sym Map for this molecule
+			map <string,component> moleculeSymMapForThisPermutation;
+			createMoleculeSymMap(moleculeSymMapForThisPermutation,mId,
+					symmetries,isRxnCenter,originalPosition,choices.at(p));
+			thisMoleculeSymMap.push_back(moleculeSymMapForThisPermutation);
 		}
 
 		//Finally, add the symmetric maps of this molecule to the list...
@@ -312,38 +312,67 @@ void setParameter(string command, System *s) {
 
 
 
+void resetSystem(string command, System *s) {
+
+	int id1=command.find("reset");
+	string seedString = command.substr(id1+5);
+	NFutil::trim(seedString);
+
+	s->restore();
+	cout<<"system reset to the snapshot at time "<<s->getCurrentTime()<<endl;
+
+	// an optional seed restarts the random number stream as well
+	if(seedString.size()>0) {
+		try {
+			int seed = NFutil::convertToInt(seedString);
+			cout<<"reseeding the random number generator with: "<<seed<<endl;
+			NFutil::SEED_RANDOM(seed);
+		} catch (std::runtime_error e) {
+			cout<<"\nError in RNF execution command. \n";
+			cout<<"   >> "+command+"\n";
+			cout<<"   Could not convert the seed to an integer.\n"<<endl;
+			cerr<<e.what()<<endl;
+		}
+	}
+}
+
+
+
+// The verb of an RNF command, read from its first word only, so that 'set kreset 1'
+// is a set and 'echo reset' an echo.  The verbs are looked for in this order, so
+// that 'reset' is found before the 'set' it contains.
+static string rnfVerb(const string &com)
+{
+	static const char *verbs[] = { "echo", "print", "snapshot", "reset", "eq", "sim", "set", "update" };
+	size_t start = com.find_first_not_of(" \t");
+	if(start==string::npos) return "";
+	string word = com.substr(start, com.find_first_of(" \t", start)-start);
+	for(unsigned int v=0; v<sizeof(verbs)/sizeof(verbs[0]); v++)
+		if(word.find(verbs[v])!=string::npos) return verbs[v];
+	return "";
+}
+
+
 bool NFinput::runRNFcommands(System *s, map<string,string> &argMap, vector<string> &commands, bool verbose)
 {
 	cout<<"\n\nrunning RNF commands\n-----------------"<<endl;
-	string com = "";
+
+	// a script that resets before it takes a snapshot of its own goes back to the
+	// state the model was loaded in
 	for(int c=0; c<(int)commands.size(); c++) {
-		com = commands.at(c);
-	//	cout<<"Parsing command: "<<com<<endl;
-
-
-		if(com.find("echo")!=string::npos) {
-			echo(com,s);
-			continue;
-		} else if(com.find("print")!=string::npos) {
-			print(com,s);
-			continue;
-		} else if(com.find("eq")!=string::npos) {
-			equilibrate(com,s);
-			continue;
-		} else if(com.find("sim")!=string::npos) {
-			simulate(com,s,verbose);
-			continue;
-		} else if(com.find("set")!=string::npos) {
-			setParameter(com,s);
-			continue;
-		}  else if(com.find("update")!=string::npos) {
-			s->updateSystemWithNewParameters();
-			continue;
-		} else {
-			cout<<"could not figure out what you wanted to do for command:\n";
-			cout<<com<<endl;
+		string verb = rnfVerb(commands.at(c));
+		if(verb=="snapshot") break;
+		if(verb=="reset") {
+			s->snapshot();
+			break;
 		}
+	}
 
+	for(int c=0; c<(int)commands.size(); c++) {
+		if(!runRNFcommand(s,commands.at(c),verbose)) {
+			cout<<"could not figure out what you wanted to do for command:\n";
+			cout<<commands.at(c)<<endl;
+		}
 	}
 
 
@@ -351,6 +380,33 @@ bool NFinput::runRNFcommands(System *s, map<string,string> &argMap, vector<strin
 }
 
 
+bool NFinput::runRNFcommand(System *s, string com, bool verbose)
+{
+	string verb = rnfVerb(com);
+	if(verb=="echo") {
+		echo(com,s);
+	} else if(verb=="print") {
+		print(com,s);
+	} else if(verb=="snapshot") {
+		cout<<"taking a snapshot of the system at time "<<s->getCurrentTime()<<endl;
+		s->snapshot();
+	} else if(verb=="reset") {
+		resetSystem(com,s);
+	} else if(verb=="eq") {
+		equilibrate(com,s);
+	} else if(verb=="sim") {
+		simulate(com,s,verbose);
+	} else if(verb=="set") {
+		setParameter(com,s);
+	} else if(verb=="update") {
+		s->updateSystemWithNewParameters();
+	} else {
+		return false;
+	}
+	return true;
+}
+
+
 
 
 
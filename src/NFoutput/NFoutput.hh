@@ -107,6 +107,57 @@ namespace NFcore
 
 
 
+
+	//! Running mean and variance of the output columns over an ensemble of replicate runs
+	/*!
+	    An EnsembleStats object is attached to each replicate System with
+	    System::setEnsembleStats().  Every time the system writes a line of
+	    observable output, the values are folded into a running mean and sum of
+	    squared deviations for that sample time and column with Welford's update,
+	    so the replicates never have to be stored.  The statistics of replicates
+	    run in separate processes are combined with merge(), using the pairwise
+	    update of Chan et al., after sending them between processes with
+	    serialize() and deserialize().
+
+	    The summary has one line per sample time with the time, the number of
+	    replicates that reached it, and the mean and the sample standard deviation
+	    of each column.  It is written by the -replicates flag, see NFsim.cpp.
+	*/
+	class EnsembleStats {
+
+		public:
+			EnsembleStats();
+			~EnsembleStats();
+
+			//! Sets the names of the output columns.  Has no effect once columns are set.
+			void setColumns(const vector <string> &names);
+			int getNumOfColumns() const { return (int)columnNames.size(); };
+			int getNumOfSamples() const { return (int)sampleCount.size(); };
+
+			//! Adds the values of all columns at the given sample of one replicate
+			void add(unsigned int sample, double time, const vector <double> &values);
+
+			//! Folds in the statistics of another set of replicates of the same model
+			bool merge(const EnsembleStats &other);
+
+			//! Packs the statistics into a byte string, and reads them back
+			void serialize(string &buffer) const;
+			bool deserialize(const string &buffer);
+
+			//! Writes the summary file, returns false if it could not be opened
+			bool writeSummary(string filename) const;
+
+		protected:
+			void growTo(unsigned int nSamples);
+
+			vector <string> columnNames;
+			vector <double> sampleTime;           /*!< time of each sample */
+			vector <unsigned long> sampleCount;   /*!< replicates that reached each sample */
+			vector <double> mean;                 /*!< running means, sample major */
+			vector <double> m2;                   /*!< running sums of squared deviations */
+	};
+
+
 }
 
 
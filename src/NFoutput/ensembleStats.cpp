@@ -0,0 +1,175 @@
+#include "NFoutput.hh"
+
+#include <cstring>
+#include <iomanip>
+#include <cmath>
+
+using namespace NFcore;
+
+
+EnsembleStats::EnsembleStats()
+{
+}
+
+EnsembleStats::~EnsembleStats()
+{
+}
+
+
+void EnsembleStats::setColumns(const vector <string> &names)
+{
+	if(!columnNames.empty()) return;
+	columnNames = names;
+}
+
+
+void EnsembleStats::growTo(unsigned int nSamples)
+{
+	if(nSamples<=sampleCount.size()) return;
+	unsigned int nCols = columnNames.size();
+	sampleTime.resize(nSamples,0);
+	sampleCount.resize(nSamples,0);
+	mean.resize(nSamples*nCols,0);
+	m2.resize(nSamples*nCols,0);
+}
+
+
+void EnsembleStats::add(unsigned int sample, double time, const vector <double> &values)
+{
+	if(values.size()!=columnNames.size()) {
+		cerr<<"Error in EnsembleStats!  A replicate gave "<<values.size()<<" output values, but"<<endl;
+		cerr<<"the ensemble has "<<columnNames.size()<<" columns.  quitting."<<endl;
+		exit(1);
+	}
+	growTo(sample+1);
+	if(sampleCount[sample]==0) sampleTime[sample] = time;
+
+	unsigned long n = ++sampleCount[sample];
+	unsigned int nCols = columnNames.size();
+	for(unsigned int c=0; c<nCols; c++) {
+		unsigned int i = sample*nCols+c;
+		double delta = values[c]-mean[i];
+		mean[i] += delta/(double)n;
+		m2[i] += delta*(values[c]-mean[i]);
+	}
+}
+
+
+bool EnsembleStats::merge(const EnsembleStats &other)
+{
+	if(other.columnNames.empty()) return true;
+	if(columnNames.empty()) setColumns(other.columnNames);
+	if(other.columnNames.size()!=columnNames.size()) return false;
+
+	growTo(other.sampleCount.size());
+	unsigned int nCols = columnNames.size();
+	for(unsigned int s=0; s<other.sampleCount.size(); s++) {
+		unsigned long nB = other.sampleCount[s];
+		if(nB==0) continue;
+		unsigned long nA = sampleCount[s];
+		if(nA==0) sampleTime[s] = other.sampleTime[s];
+		double n = (double)(nA+nB);
+		for(unsigned int c=0; c<nCols; c++) {
+			unsigned int i = s*nCols+c;
+			double delta = other.mean[i]-mean[i];
+			mean[i] += delta*(double)nB/n;
+			m2[i] += other.m2[i] + delta*delta*(double)nA*(double)nB/n;
+		}
+		sampleCount[s] = nA+nB;
+	}
+	return true;
+}
+
+
+void EnsembleStats::serialize(string &buffer) const
+{
+	unsigned long header[2];
+	header[0] = columnNames.size();
+	header[1] = sampleCount.size();
+	buffer.clear();
+	buffer.append((const char *)header, sizeof(header));
+	for(unsigned int c=0; c<columnNames.size(); c++) {
+		unsigned long len = columnNames[c].size();
+		buffer.append((const char *)&len, sizeof(len));
+		buffer.append(columnNames[c]);
+	}
+	if(sampleCount.empty()) return;
+	buffer.append((const char *)&sampleTime[0], sampleTime.size()*sizeof(double));
+	buffer.append((const char *)&sampleCount[0], sampleCount.size()*sizeof(unsigned long));
+	if(mean.empty()) return;
+	buffer.append((const char *)&mean[0], mean.size()*sizeof(double));
+	buffer.append((const char *)&m2[0], m2.size()*sizeof(double));
+}
+
+
+bool EnsembleStats::deserialize(const string &buffer)
+{
+	size_t pos = 0;
+	unsigned long header[2];
+	if(buffer.size()<sizeof(header)) return false;
+	memcpy(header, buffer.data(), sizeof(header));
+	pos += sizeof(header);
+
+	columnNames.clear();
+	for(unsigned long c=0; c<header[0]; c++) {
+		unsigned long len;
+		if(pos+sizeof(len)>buffer.size()) return false;
+		memcpy(&len, buffer.data()+pos, sizeof(len));
+		pos += sizeof(len);
+		if(pos+len>buffer.size()) return false;
+		columnNames.push_back(buffer.substr(pos,len));
+		pos += len;
+	}
+
+	unsigned long nSamples = header[1];
+	unsigned long nValues = nSamples*header[0];
+	size_t expected = nSamples*(sizeof(double)+sizeof(unsigned long)) + 2*nValues*sizeof(double);
+	if(buffer.size()-pos != expected) return false;
+
+	sampleTime.assign(nSamples,0);
+	sampleCount.assign(nSamples,0);
+	mean.assign(nValues,0);
+	m2.assign(nValues,0);
+	if(nSamples==0) return true;
+	memcpy(&sampleTime[0], buffer.data()+pos, nSamples*sizeof(double)); pos += nSamples*sizeof(double);
+	memcpy(&sampleCount[0], buffer.data()+pos, nSamples*sizeof(unsigned long)); pos += nSamples*sizeof(unsigned long);
+	if(nValues==0) return true;
+	memcpy(&mean[0], buffer.data()+pos, nValues*sizeof(double)); pos += nValues*sizeof(double);
+	memcpy(&m2[0], buffer.data()+pos, nValues*sizeof(double));
+	return true;
+}
+
+
+bool EnsembleStats::writeSummary(string filename) const
+{
+	ofstream out(filename.c_str());
+	if(!out.is_open()) {
+		cerr<<"Error in EnsembleStats!  cannot open output stream to file "<<filename<<". "<<endl;
+		return false;
+	}
+
+	// same layout as the gdat files, with a mean and a standard deviation per column
+	out<<"#          time               n";
+	for(unsigned int c=0; c<columnNames.size(); c++) {
+		string nm = columnNames[c];
+		out<<" "<<setw(16)<<(nm+"_mean")<<" "<<setw(16)<<(nm+"_sd");
+	}
+	out<<endl;
+
+	out.setf(ios::scientific);
+	out.precision(8);
+	unsigned int nCols = columnNames.size();
+	for(unsigned int s=0; s<sampleCount.size(); s++) {
+		unsigned long n = sampleCount[s];
+		if(n==0) continue;
+		out<<sampleTime[s]<<"\t"<<n;
+		for(unsigned int c=0; c<nCols; c++) {
+			unsigned int i = s*nCols+c;
+			double sd = (n>1) ? sqrt(m2[i]/(double)(n-1)) : 0.0;
+			out<<"\t"<<mean[i]<<"\t"<<sd;
+		}
+		out<<endl;
+	}
+	out.close();
+	return true;
+}
@@ -73,6 +73,29 @@ void MappingSet::clone(MappingSet *original, MappingSet *newClone)
 
 
 
+void MappingSet::saveImage(ReactantImage &image) const
+{
+	for(unsigned int i=0; i<n_mappings; i++)
+		image.molecules.push_back(mappings[i]->getMolecule());
+	image.clones.push_back(clonedMappingSet);
+}
+
+
+void MappingSet::restoreImage(const ReactantImage &image, unsigned int setIndex, unsigned int &moleculeIndex)
+{
+	for(unsigned int i=0; i<n_mappings; i++)
+		mappings[i]->setMolecule(image.molecules[moleculeIndex++]);
+	clonedMappingSet = image.clones[setIndex];
+}
+
+
+
+
+unsigned long MappingSet::getMemoryUsage() const
+{
+	return sizeof(MappingSet) + n_mappings*(sizeof(Mapping *) + sizeof(Mapping));
+}
+
 
 void MappingSet::printDetails() const {
 	printDetails(cout);
@@ -108,8 +131,8 @@ int MappingSet::getPopulation() const
 
 
 
-vector <Molecule *> MappingSet::molList;
-vector <Molecule *>::iterator  MappingSet::molIter;
+thread_local vector <Molecule *> MappingSet::molList;
+thread_local vector <Molecule *>::iterator MappingSet::molIter;
 
 bool MappingSet::checkForCollisions( MappingSet * ms1, MappingSet * ms2 )
 {
@@ -157,6 +180,17 @@ bool MappingSet::checkForEquality( MappingSet * ms1, MappingSet * ms2 )
 	return true;
 }
 
+bool MappingSet::checkForSameMappings( MappingSet * ms1, MappingSet * ms2 )
+{
+	if ( ms1->n_mappings != ms2->n_mappings ) return false;
+	for ( unsigned int imap = 0; imap < ms1->n_mappings;  ++imap )
+	{
+		if ( (ms1->mappings)[imap]->getMolecule() != (ms2->mappings)[imap]->getMolecule() )
+			return false;
+	}
+	return true;
+}
+
 
 
 // These functions defined inline with no checking in this faster version
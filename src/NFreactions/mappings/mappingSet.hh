@@ -112,15 +112,28 @@ namespace NFcore
 
 			static void clone(MappingSet *original, MappingSet *newClone);
 
+			/*!
+			 	Appends the Molecules this set maps onto and its clone to the image of
+			 	the container the set lives in, and sets them back from there, starting
+			 	at the given Molecule of the image.  See ReactantContainer::saveImage().
+			 */
+			void saveImage(ReactantImage &image) const;
+			void restoreImage(const ReactantImage &image, unsigned int setIndex, unsigned int &moleculeIndex);
+
 			void printDetails() const;
 			void printDetails(ostream &o) const;
 
+			// approximate bytes used by this MappingSet and its Mappings
+			unsigned long getMemoryUsage() const;
+
 			// get the ID of the complex that this mappingSet is pointing to.
 			int getComplexID() const;
 
 			// check if two mappingsets point to any common molecules
 			static bool checkForCollisions( MappingSet * ms1, MappingSet * ms2 );
 			static bool checkForEquality( MappingSet * ms1, MappingSet * ms2 );
+			// check if two mappingsets map every position onto the same molecule
+			static bool checkForSameMappings( MappingSet * ms1, MappingSet * ms2 );
 
 		protected:
 
@@ -153,8 +166,8 @@ namespace NFcore
 
 		private:
 
-			static vector <Molecule *>           molList;
-			static vector <Molecule *>::iterator molIter;
+			static thread_local vector <Molecule *> molList;
+			static thread_local vector <Molecule *>::iterator molIter;
 	};
 
 }
@@ -11,9 +11,22 @@ namespace NFcore
 	//Forward Declarations
 	class TransformationSet;
 	class MappingSet;
+	class Molecule;
 	class ReactantContainer;
 
 
+	//!  The contents of a ReactantContainer at one moment, see saveImage() and restoreImage()
+	struct ReactantImage {
+		int capacity;                   /* MappingSets allocated */
+		int size;                       /* MappingSets in use */
+		vector <unsigned int> ids;      /* the id of the MappingSet at each position */
+		vector <Molecule *> molecules;  /* what the Mappings of the sets in use point to, in position order */
+		vector <unsigned int> clones;   /* the cloned MappingSet of each set in use */
+		vector <int> indexArrays;       /* the other index arrays of the container, as they are */
+		vector <double> rateFactorSums; /* the sums in a ReactantTree */
+	};
+
+
 	//!  Interface for all containers of Reactants (MappingSets) needed by ReactionClasses
 	/*!
 	 *
@@ -52,6 +65,27 @@ namespace NFcore
 			 */
 			virtual void printDetails() const = 0;;
 
+			/*!
+				Returns the number of MappingSets that are allocated, whether or not
+				they are currently in use.
+			 */
+			virtual int getCapacity() const = 0;
+
+			/*!
+				Returns the approximate number of bytes used by this container,
+				including all of its allocated MappingSets and Mappings.
+			 */
+			virtual unsigned long getMemoryUsage() const = 0;
+
+			/*!
+				Copies which MappingSets are in use, in which order, and what they map
+				onto into the image, and puts it all back later.  System::restore() uses
+				this so that nothing has to be matched again.  Restoring also gives the
+				container back the capacity it had.
+			 */
+			virtual void saveImage(ReactantImage &image) const = 0;
+			virtual void restoreImage(const ReactantImage &image) = 0;
+
 			/*!
 			 */
 			void notifyPresenceOfClonedMappings() { hasClonedMappings=true; };
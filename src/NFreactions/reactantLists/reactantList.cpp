@@ -227,6 +227,63 @@ void ReactantList::removeMappingSet(unsigned int mappingSetId)
 }
 
 
+unsigned long ReactantList::getMemoryUsage() const
+{
+	unsigned long bytes = sizeof(ReactantList) + capacity*(sizeof(MappingSet *) + sizeof(unsigned int));
+	for(int i=0; i<capacity; i++)
+		bytes += mappingSets[i]->getMemoryUsage();
+	return bytes;
+}
+
+
+void ReactantList::saveImage(ReactantImage &image) const
+{
+	image.capacity = capacity;
+	image.size = n_mappingSets;
+	image.ids.resize(capacity);
+	image.molecules.clear();
+	image.clones.clear();
+	for(int i=0; i<capacity; i++) {
+		image.ids[i] = mappingSets[i]->getId();
+		if(i<n_mappingSets) mappingSets[i]->saveImage(image);
+	}
+	image.indexArrays.clear();
+	image.rateFactorSums.clear();
+}
+
+
+void ReactantList::restoreImage(const ReactantImage &image)
+{
+	// the MappingSets keep their ids, so line them up by id first; sets the list
+	// has grown since the image are dropped, and any it had then are made again
+	MappingSet **byId = new MappingSet *[max(capacity,image.capacity)];
+	for(int i=0; i<capacity; i++)
+		byId[mappingSets[i]->getId()] = mappingSets[i];
+	for(int id=capacity; id<image.capacity; id++)
+		byId[id] = ts->generateBlankMappingSet(reactantIndex, id);
+	for(int id=image.capacity; id<capacity; id++)
+		delete byId[id];
+
+	if(capacity!=image.capacity) {
+		delete [] mappingSets;
+		delete [] msPositionMap;
+		capacity = image.capacity;
+		mappingSets = new MappingSet *[capacity];
+		msPositionMap = new unsigned int [capacity];
+	}
+
+	n_mappingSets = image.size;
+	unsigned int m = 0;
+	for(int i=0; i<capacity; i++) {
+		mappingSets[i] = byId[image.ids[i]];
+		msPositionMap[image.ids[i]] = i;
+		if(i<n_mappingSets) mappingSets[i]->restoreImage(image, i, m);
+		else mappingSets[i]->clear();
+	}
+	delete [] byId;
+}
+
+
 void ReactantList::printDetails() const
 {
 	//Used for debuggin'...
@@ -107,6 +107,12 @@ namespace NFcore
 			 */
 			virtual void printDetails() const;
 
+			virtual int getCapacity() const { return capacity; };
+			virtual unsigned long getMemoryUsage() const;
+
+			virtual void saveImage(ReactantImage &image) const;
+			virtual void restoreImage(const ReactantImage &image);
+
 		protected:
 
 			/*! Maintains the number of mappingSets on this list */
@@ -560,6 +560,94 @@ MappingSet * ReactantTree::getMappingSet(unsigned int mappingSetId) const
 }
 
 
+unsigned long ReactantTree::getMemoryUsage() const
+{
+	unsigned long bytes = sizeof(ReactantTree);
+	bytes += (numOfNodes+1)*(sizeof(double) + 2*sizeof(int));
+	bytes += maxElementCount*(sizeof(MappingSet *) + 3*sizeof(int));
+	for(int i=0; i<maxElementCount; i++)
+		bytes += mappingSets[i]->getMemoryUsage();
+	return bytes;
+}
+
+
+void ReactantTree::saveImage(ReactantImage &image) const
+{
+	image.capacity = maxElementCount;
+	image.size = n_mappingSets;
+	image.ids.resize(maxElementCount);
+	image.molecules.clear();
+	image.clones.clear();
+	for(int i=0; i<maxElementCount; i++) {
+		image.ids[i] = mappingSets[i]->getId();
+		if(i<n_mappingSets) mappingSets[i]->saveImage(image);
+	}
+
+	// the position maps and the counts of the nodes, and the sums of the nodes
+	image.indexArrays.assign(msPositionMap, msPositionMap+maxElementCount);
+	image.indexArrays.insert(image.indexArrays.end(), msTreePositionMap, msTreePositionMap+maxElementCount);
+	image.indexArrays.insert(image.indexArrays.end(), reverseMsTreePositionMap, reverseMsTreePositionMap+maxElementCount);
+	image.indexArrays.insert(image.indexArrays.end(), leftElementCount, leftElementCount+numOfNodes+1);
+	image.indexArrays.insert(image.indexArrays.end(), rightElementCount, rightElementCount+numOfNodes+1);
+	image.rateFactorSums.assign(leftRateFactorSum, leftRateFactorSum+numOfNodes+1);
+}
+
+
+void ReactantTree::restoreImage(const ReactantImage &image)
+{
+	// line the MappingSets up by id, dropping the ones the tree has grown by
+	// since the image and making any it had then again
+	MappingSet **byId = new MappingSet *[max(maxElementCount,image.capacity)];
+	for(int i=0; i<maxElementCount; i++)
+		byId[mappingSets[i]->getId()] = mappingSets[i];
+	for(int id=maxElementCount; id<image.capacity; id++)
+		byId[id] = ts->generateBlankMappingSet(reactantIndex, id);
+	for(int id=image.capacity; id<maxElementCount; id++)
+		delete byId[id];
+
+	// the capacity is always a power of two, see the constructor
+	if(maxElementCount!=image.capacity) {
+		delete [] leftRateFactorSum;
+		delete [] leftElementCount;
+		delete [] rightElementCount;
+		delete [] mappingSets;
+		delete [] msPositionMap;
+		delete [] msTreePositionMap;
+		delete [] reverseMsTreePositionMap;
+
+		maxElementCount = image.capacity;
+		for(treeDepth=0; (1<<treeDepth)<maxElementCount; treeDepth++) {}
+		numOfNodes = 2*maxElementCount-1;
+		firstMappingTreeIndex = maxElementCount;
+
+		leftRateFactorSum = new double [numOfNodes+1];
+		leftElementCount = new int [numOfNodes+1];
+		rightElementCount = new int [numOfNodes+1];
+		mappingSets = new MappingSet * [maxElementCount];
+		msPositionMap = new int [maxElementCount];
+		msTreePositionMap = new int [maxElementCount];
+		reverseMsTreePositionMap = new int [maxElementCount];
+	}
+
+	n_mappingSets = image.size;
+	unsigned int m = 0;
+	for(int i=0; i<maxElementCount; i++) {
+		mappingSets[i] = byId[image.ids[i]];
+		if(i<n_mappingSets) mappingSets[i]->restoreImage(image, i, m);
+		else mappingSets[i]->clear();
+	}
+	delete [] byId;
+
+	const int *a = &image.indexArrays[0];
+	copy(a, a+maxElementCount, msPositionMap);                 a += maxElementCount;
+	copy(a, a+maxElementCount, msTreePositionMap);             a += maxElementCount;
+	copy(a, a+maxElementCount, reverseMsTreePositionMap);      a += maxElementCount;
+	copy(a, a+numOfNodes+1, leftElementCount);                 a += numOfNodes+1;
+	copy(a, a+numOfNodes+1, rightElementCount);
+	copy(image.rateFactorSums.begin(), image.rateFactorSums.end(), leftRateFactorSum);
+}
+
+
 void ReactantTree::printDetails() const {
 
 	cout<<endl<<endl<<"<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<"<<endl;
@@ -110,6 +110,16 @@ namespace NFcore
 			*/
 			virtual void printDetails() const;
 
+			/*!
+				Returns the number of MappingSets the tree can hold before it has to
+				expand, and the approximate bytes used by the tree and its MappingSets.
+			*/
+			virtual int getCapacity() const { return maxElementCount; };
+			virtual unsigned long getMemoryUsage() const;
+
+			virtual void saveImage(ReactantImage &image) const;
+			virtual void restoreImage(const ReactantImage &image);
+
 
 
 
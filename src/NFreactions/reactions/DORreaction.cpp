@@ -89,6 +89,7 @@ DORRxnClass::DORRxnClass(
 	argIndexIntoMappingSet =  new int [n_argMolecules];
 	argMappedMolecule = new Molecule *[n_argMolecules];
 	argScope = new int [n_argMolecules];
+	argReactantCounts = new int [n_reactants];
 
 
 	for(int i=0; i<(int)lfArgumentPointerNameList.size(); i++) {
@@ -189,6 +190,7 @@ DORRxnClass::~DORRxnClass() {
 	delete [] argIndexIntoMappingSet;
 	delete [] argMappedMolecule;
 	delete [] argScope;
+	delete [] argReactantCounts;
 
 }
 
@@ -234,7 +236,7 @@ void DORRxnClass::remove(Molecule *m, unsigned int reactantPos)
 
 int DORRxnClass::checkForCollision(Molecule *m, MappingSet* ms, int rxnIndex){
 	
-	set<int> tempSet = m->getRxnListMappingSet(rxnIndex);
+	const set<int> &tempSet = m->getRxnListMappingSet(rxnIndex);
 	for(set<int>::iterator it= tempSet.begin();it!= tempSet.end(); ++it){
 		MappingSet* ms2 = reactantTree->getMappingSet(*it);
 		if(MappingSet::checkForEquality(ms,ms2)){
@@ -501,6 +503,12 @@ int DORRxnClass::getCorrectedReactantCount(unsigned int reactantIndex) const
 			 : reactantLists[reactantIndex]->size();
 }
 
+ReactantContainer * DORRxnClass::getReactantContainer(unsigned int reactantIndex) const
+{
+	if(reactantIndex==(unsigned)this->DORreactantIndex) return reactantTree;
+	return reactantLists[reactantIndex];
+}
+
 /*
 JJT: this function is called if the default mappingset information is sending the wrong parameter to the local function when using a species
 scope label. for now the solution is to try every molecule referenced by the mapping set. This may be inefficient but it will only be as long
@@ -513,20 +521,12 @@ double DORRxnClass::pickLocalFunctionParameter(MappingSet* ms, int index, vector
 		{
 			for (auto it: *(type1_Mol)){
 				if(it == ms->get(r)->getMolecule()->getMoleculeType()){
-					try{
-						this->argMappedMolecule[index] = ms->get(r)->getMolecule();
-						return this->cf->evaluateOn(this->argMappedMolecule,this->argScope, reactantCounts, this->n_reactants);
-						
-					}
-					catch(LocalFunctionException &lfe){
-						if(lfe.getIndex() == index){
-							continue;
-						}
-						else{
-							return this->pickLocalFunctionParameter(ms, lfe.getIndex(), lfe.getType1_Mol(), reactantCounts);
-						}
-						
-					}
+					double value;
+					this->argMappedMolecule[index] = ms->get(r)->getMolecule();
+					int failed = this->cf->evaluateOn(this->argMappedMolecule,this->argScope, reactantCounts, this->n_reactants, value);
+					if(failed<0) return value;
+					if(failed == index) continue;
+					return this->pickLocalFunctionParameter(ms, failed, this->cf->getTypeIMolecules(failed), reactantCounts);
 				}
 			}
 		}
@@ -557,26 +557,21 @@ double DORRxnClass::evaluateLocalFunctions(MappingSet *ms)
 	}
 
 	//cout<<"done setting molecules, so know calling the composite function evaluate method."<<endl;
-	int * reactantCounts = new int[this->n_reactants];
 	for(unsigned int r=0; r<n_reactants; r++) {
 		if(r==this->DORreactantIndex) {
-			reactantCounts[r]= reactantTree->size();
+			argReactantCounts[r]= reactantTree->size();
 		}
 		else {
-			reactantCounts[r]=reactantLists[r]->size();
+			argReactantCounts[r]=reactantLists[r]->size();
 		}
 	}
 	double value;
-	try{
-		value = this->cf->evaluateOn(argMappedMolecule,argScope, reactantCounts, n_reactants);
-	}
-	catch(LocalFunctionException &lfe){
+	int failed = this->cf->evaluateOn(argMappedMolecule,argScope, argReactantCounts, n_reactants, value);
+	if(failed>=0) {
 		//the parameter sent in argMappedMolecule cannot be mapped to an observable in the local function
 		//solution here: just try everything taht we reference in ms for the parameter in question
-		value = this->pickLocalFunctionParameter(ms, lfe.getIndex(), lfe.getType1_Mol(), reactantCounts);
+		value = this->pickLocalFunctionParameter(ms, failed, this->cf->getTypeIMolecules(failed), argReactantCounts);
 	}
-	endloop:
-	delete [] reactantCounts;
 	//cout<<"\t\t\t\t\t"<<"composite function value="<<value<<endl;
 
 	return value;
@@ -675,278 +670,203 @@ void DORRxnClass::printDetails() const
 
 
 /*
- * DOR2RxnClass
+ * DORNRxnClass
  */
 
-DOR2RxnClass::DOR2RxnClass(
+DORNRxnClass::DORNRxnClass(
 		string name,
 		double baseRate,
 		string baseRateName,
 		TransformationSet *transformationSet,
-		CompositeFunction *function1,
-		CompositeFunction *function2,
-		vector <string> &lfArgumentPointerNameList1,
-		vector <string> &lfArgumentPointerNameList2,
+		vector <CompositeFunction *> &functions,
+		vector <vector <string> > &lfArgumentPointerNameLists,
 		System *s
 	) : ReactionClass(name,baseRate,baseRateName,transformationSet,s)
 {
-	// TODO: figure out if there are used for anything
-	//vector <TemplateMolecule *> dorMolecules1;
-	//vector <TemplateMolecule *> dorMolecules2;
-
 	//////////////////////////////////////////////////////////////////////////////////////////
-	//Step 1: Find the DOR reactants, and make sure there are exactly 2.  DOR reactants
-	//can be found because they have a LocalFunctionPointer Transformation that keeps
-	//information about the pointer onto either a reactant species or a particular molecule
-	//in the pattern.
-	DORreactantIndex1 = -1;
-	DORreactantIndex2 = -1;
-	for (int r=0; (unsigned)r<n_reactants; r++) {
+	//Step 1: Find the DOR reactants, one for each function.  DOR reactants can be found
+	//because they have a LocalFunctionPointer Transformation that keeps information about
+	//the pointer onto either a reactant species or a particular molecule in the pattern.
+	//The functions are matched to them in the order of the reactants.
+	n_factors = functions.size();
+	if(lfArgumentPointerNameLists.size()!=functions.size()) {
+		cout<<"Error when creating DORNRxnClass: "<<name<<endl;
+		cout<<"Each function needs its own list of arguments."<<endl;
+		exit(1);
+	}
 
+	factorOfReactant = new int [n_reactants];
+	DORreactantIndex = new int [n_factors];
+	int found = 0;
+	for (unsigned int r=0; r<n_reactants; r++) {
+		factorOfReactant[r] = -1;
 		for (int i=0; i < transformationSet->getNumOfTransformations(r); i++) {
-
 			Transformation *transform = transformationSet->getTransformation(r,i);
-			if((unsigned)transform->getType()==TransformationFactory::LOCAL_FUNCTION_REFERENCE) {
-
-				if (DORreactantIndex1 ==-1){
-					if ( transformationSet->getTemplateMolecule(r)->getMoleculeType()->isPopulationType() )
-					{   // DOR reactant is a population!
-						cout<<"Error when creating DOR2RxnClass: "<<name<<endl;
-						cout<<"DOR reactant1 cannot be a population type."<<endl;
-						exit(1);
-					}
-
-					DORreactantIndex1 = r;
-				}
-				else if (DORreactantIndex1 == r) {
-					// this is ok
-				}
-				else if (DORreactantIndex2 ==-1) {
-					if ( transformationSet->getTemplateMolecule(r)->getMoleculeType()->isPopulationType() ) {
-						// DOR reactant is a population!
-						cout<<"Error when creating DOR2RxnClass: "<<name<<endl;
-						cout<<"DOR reactant2 cannot be a population type."<<endl;
-						exit(1);
-					}
+			if((unsigned)transform->getType()!=TransformationFactory::LOCAL_FUNCTION_REFERENCE) continue;
 
-					DORreactantIndex2 = r;
-				}
-				else if (DORreactantIndex2 == r) {
-					// this is ok
-				}
-				else {
-					cout<<"Error when creating DOR2RxnClass: "<<name<<endl;
-					cout<<"DOR2 reactions only support two DOR reactants."<<endl;
-					exit(1);
-				}
+			if ( transformationSet->getTemplateMolecule(r)->getMoleculeType()->isPopulationType() ) {
+				cout<<"Error when creating DORNRxnClass: "<<name<<endl;
+				cout<<"DOR reactant "<<found+1<<" cannot be a population type."<<endl;
+				exit(1);
 			}
+			if (found==n_factors) {
+				cout<<"Error when creating DORNRxnClass: "<<name<<endl;
+				cout<<"There are more reactants with local function pointers than functions ("<<n_factors<<")."<<endl;
+				exit(1);
+			}
+			factorOfReactant[r] = found;
+			DORreactantIndex[found++] = r;
+			break;
 		}
 	}
 
-	if (DORreactantIndex1==-1 || DORreactantIndex2==-1) {
-		cout<<"Error when creating DOR2RxnClass: "<<name<<endl;
-		cout<<"DOR2RxnClass requires pointers into two different reactant patterns, but fewer than 2 were found!"<<endl;
+	if (found<n_factors || n_factors<2) {
+		cout<<"Error when creating DORNRxnClass: "<<name<<endl;
+		cout<<"DORNRxnClass requires pointers into one reactant pattern for each of its "<<n_factors<<" functions,"<<endl;
+		cout<<"and at least two of them, but "<<found<<" were found!"<<endl;
 		exit(1);
 	}
 
-	if(DEBUG_MESSAGE)cout<<"I determined that the DOR reactant1 is in fact: "<<DORreactantIndex1<<endl;
-	if(DEBUG_MESSAGE)cout<<"I determined that the DOR reactant2 is in fact: "<<DORreactantIndex2<<endl;
-	if(DEBUG_MESSAGE)cout<<"N_reactants: "<<transformationSet->getNreactants()<<endl;
-
-
-	//////////////////////////////////////////////////////////////////////////////////////////
-	//Step 2: Some bookkeeping so that we can quickly get the function values from a mapping set
-	// Now that we have found the DOR reactant, which can potentially have multiple functions, lets
-	// figure out which functions apply to which
-	// vector <int> indexIntoMappingSet;    //list of the index into the transformations for each of the local functions
-	// vector <double> localFunctionValue;  //list of the value of each of the local functions needed to evaluate the rate law
-
-	// DOR reactant1
-	//Array to double check that we have used all pointer references we have created
-	bool *hasMatched1 = new bool [transformationSet->getNumOfTransformations(DORreactantIndex1)];
-	for (int i=0; i<transformationSet->getNumOfTransformations(DORreactantIndex1); i++) hasMatched1[i]=false;
-
-	//make sure that we have the right number of functions and argument names
-	if((unsigned)function1->getNumOfArgs()!=lfArgumentPointerNameList1.size()) {
-		cout<<"Error when creating DOR2RxnClass: "<<name<<endl;
-		cout<<"Number of arguments in function1 and LocalFunctionArgumentPointerList1 size do not match!"<<endl;
-		exit(1);
+	if(DEBUG_MESSAGE) {
+		for(int f=0; f<n_factors; f++)
+			cout<<"I determined that DOR reactant "<<f+1<<" is in fact: "<<DORreactantIndex[f]<<endl;
+		cout<<"N_reactants: "<<transformationSet->getNreactants()<<endl;
 	}
 
-	n_argMolecules1=lfArgumentPointerNameList1.size();
-	argIndexIntoMappingSet1 =  new int [n_argMolecules1];
-	argMappedMolecule1 = new Molecule *[n_argMolecules1];
-	argScope1 = new int [n_argMolecules1];
 
-	for(int i=0; i<(int)lfArgumentPointerNameList1.size(); i++) {
-		//Now search for the function argument...
-		bool match = false;
-		for(int k=0; k<transformationSet->getNumOfTransformations(DORreactantIndex1); k++) {
-			Transformation *transform = transformationSet->getTransformation(DORreactantIndex1,k);
-			if((unsigned)transform->getType()==TransformationFactory::LOCAL_FUNCTION_REFERENCE) {
-				LocalFunctionReference *lfr = static_cast<LocalFunctionReference*>(transform);
-				if(lfr->getPointerName()==lfArgumentPointerNameList1.at(i)) {
-					//If we got here, we found a match, so remember the index of the transformation
-					//so we can quickly get the value of the function for any mapping object we try
-					//to push on the reactant Tree.
-
-					argIndexIntoMappingSet1[i] =  k;
-					argMappedMolecule1[i] = 0;
-					argScope1[i] = lfr->getFunctionScope();
+	//////////////////////////////////////////////////////////////////////////////////////////
+	//Step 2: Some bookkeeping so that we can quickly get the function values from a mapping set,
+	//for each of the DOR reactants in turn
+	n_argMolecules = new int [n_factors];
+	argIndexIntoMappingSet = new int * [n_factors];
+	argMappedMolecule = new Molecule ** [n_factors];
+	argScope = new int * [n_factors];
+	argReactantCounts = new int [n_reactants];
+	cfs = new CompositeFunction * [n_factors];
+
+	for(int f=0; f<n_factors; f++)
+	{
+		int r = DORreactantIndex[f];
+		vector <string> &argNames = lfArgumentPointerNameLists.at(f);
 
-					hasMatched1[k]=true;
-					match=true;
-				}
-			}
-		}
-		if(!match){  //If there was no match found, then we've got issues...
-			cout<<"Error when creating DOR2 reaction: "<<name<<endl;
-			cout<<"Could not find a match in the templateMolecules for a pointer reference to species/molecule: ";
-			cout<<lfArgumentPointerNameList1.at(i)<<endl;
+		//make sure that we have the right number of functions and argument names
+		if((unsigned)functions.at(f)->getNumOfArgs()!=argNames.size()) {
+			cout<<"Error when creating DORNRxnClass: "<<name<<endl;
+			cout<<"Number of arguments in function"<<f+1<<" and LocalFunctionArgumentPointerList"<<f+1<<" size do not match!"<<endl;
 			exit(1);
 		}
-	}
 
-	//Just send out a warning if we didn't use one of the pointer references we were given
-	for(int k=0; k<transformationSet->getNumOfTransformations(DORreactantIndex1); k++) {
-		Transformation *transform = transformationSet->getTransformation(DORreactantIndex1,k);
-		if((unsigned)transform->getType()==TransformationFactory::LOCAL_FUNCTION_REFERENCE) {
-			if(!hasMatched1[k]) {
-				cout<<endl<<"Warning!  when creating DOR2RxnClass: "<<name<<endl;
-				cout<<"Pointer reference: "<<  static_cast<LocalFunctionReference*>(transform)->getPointerName();
-				cout<<" that was provided is not used in the local function definition."<<endl;
+		//Array to double check that we have used all pointer references we have created
+		bool *hasMatched = new bool [transformationSet->getNumOfTransformations(r)];
+		for (int i=0; i<transformationSet->getNumOfTransformations(r); i++) hasMatched[i]=false;
+
+		n_argMolecules[f] = argNames.size();
+		argIndexIntoMappingSet[f] = new int [n_argMolecules[f]];
+		argMappedMolecule[f] = new Molecule *[n_argMolecules[f]];
+		argScope[f] = new int [n_argMolecules[f]];
+
+		for(int i=0; i<n_argMolecules[f]; i++) {
+			//Now search for the function argument...
+			bool match = false;
+			for(int k=0; k<transformationSet->getNumOfTransformations(r); k++) {
+				Transformation *transform = transformationSet->getTransformation(r,k);
+				if((unsigned)transform->getType()==TransformationFactory::LOCAL_FUNCTION_REFERENCE) {
+					LocalFunctionReference *lfr = static_cast<LocalFunctionReference*>(transform);
+					if(lfr->getPointerName()==argNames.at(i)) {
+						//If we got here, we found a match, so remember the index of the transformation
+						//so we can quickly get the value of the function for any mapping object we try
+						//to push on the reactant Tree.
+						argIndexIntoMappingSet[f][i] = k;
+						argMappedMolecule[f][i] = 0;
+						argScope[f][i] = lfr->getFunctionScope();
+
+						hasMatched[k]=true;
+						match=true;
+					}
+				}
+			}
+			if(!match){  //If there was no match found, then we've got issues...
+				cout<<"Error when creating DORN reaction: "<<name<<endl;
+				cout<<"Could not find a match in the templateMolecules for a pointer reference to species/molecule: ";
+				cout<<argNames.at(i)<<endl;
+				exit(1);
 			}
 		}
-	}
-    // done with DOR reactant 1
-	delete [] hasMatched1;
 
-
-	// DOR reactant2
-	//Array to double check that we have used all pointer references we have created
-	bool *hasMatched2 = new bool [transformationSet->getNumOfTransformations(DORreactantIndex2)];
-	for (int i=0; i<transformationSet->getNumOfTransformations(DORreactantIndex1); i++) hasMatched2[i]=false;
-
-	//make sure that we have the right number of functions and argument names
-	if((unsigned)function2->getNumOfArgs()!=lfArgumentPointerNameList2.size()) {
-		cout<<"Error when creating DOR2RxnClass: "<<name<<endl;
-		cout<<"Number of arguments in function2 and LocalFunctionArgumentPointerList2 size do not match!"<<endl;
-		exit(1);
-	}
-
-	n_argMolecules2=lfArgumentPointerNameList2.size();
-	argIndexIntoMappingSet2 =  new int [n_argMolecules2];
-	argMappedMolecule2 = new Molecule *[n_argMolecules2];
-	argScope2 = new int [n_argMolecules2];
-
-	for(int i=0; i<(int)lfArgumentPointerNameList2.size(); i++) {
-		//Now search for the function argument...
-		bool match = false;
-		for(int k=0; k<transformationSet->getNumOfTransformations(DORreactantIndex2); k++) {
-			Transformation *transform = transformationSet->getTransformation(DORreactantIndex2,k);
+		//Just send out a warning if we didn't use one of the pointer references we were given
+		for(int k=0; k<transformationSet->getNumOfTransformations(r); k++) {
+			Transformation *transform = transformationSet->getTransformation(r,k);
 			if((unsigned)transform->getType()==TransformationFactory::LOCAL_FUNCTION_REFERENCE) {
-				LocalFunctionReference *lfr = static_cast<LocalFunctionReference*>(transform);
-				if(lfr->getPointerName()==lfArgumentPointerNameList2.at(i)) {
-					//If we got here, we found a match, so remember the index of the transformation
-					//so we can quickly get the value of the function for any mapping object we try
-					//to push on the reactant Tree.
-
-					argIndexIntoMappingSet2[i] =  k;
-					argMappedMolecule2[i] = 0;
-					argScope2[i] = lfr->getFunctionScope();
-
-					hasMatched2[k]=true;
-					match=true;
+				if(!hasMatched[k]) {
+					cout<<endl<<"Warning!  when creating DORNRxnClass: "<<name<<endl;
+					cout<<"Pointer reference: "<<  static_cast<LocalFunctionReference*>(transform)->getPointerName();
+					cout<<" that was provided is not used in the local function definition."<<endl;
 				}
 			}
 		}
-		if(!match){  //If there was no match found, then we've got issues...
-			cout<<"Error when creating DOR2 reaction: "<<name<<endl;
-			cout<<"Could not find a match in the templateMolecules for a pointer reference to species/molecule: ";
-			cout<<lfArgumentPointerNameList2.at(i)<<endl;
-			exit(1);
-		}
+		delete [] hasMatched;
 	}
 
 
-
-	//Just send out a warning if we didn't use one of the pointer references we were given
-	for(int k=0; k<transformationSet->getNumOfTransformations(DORreactantIndex2); k++) {
-		Transformation *transform = transformationSet->getTransformation(DORreactantIndex2,k);
-		if((unsigned)transform->getType()==TransformationFactory::LOCAL_FUNCTION_REFERENCE) {
-			if(!hasMatched2[k]) {
-				cout<<endl<<"Warning!  when creating DOR2RxnClass: "<<name<<endl;
-				cout<<"Pointer reference: "<<  static_cast<LocalFunctionReference*>(transform)->getPointerName();
-				cout<<" that was provided is not used in the local function definition."<<endl;
-			}
-		}
-	}
-    // done with DOR reactant 2
-	delete [] hasMatched2;
-
-
 	//////////////////////////////////////////////////////////////////////////////////////////
 	///  Step 3: Wheh! now we can finally get on the business of creating the reactant lists
-	///  and the reactant tree and setting the usual reactionClass parameters
+	///  and the reactant trees and setting the usual reactionClass parameters
 
 	//Remember that we are a DOR ReactionClass
-	this->reactionType = ReactionClass::DOR2_RXN;
+	this->reactionType = ReactionClass::DORN_RXN;
 
 	//Set up the reactant trees
-	reactantTree1 = new ReactantTree(this->DORreactantIndex1,transformationSet,32);
-	reactantTree2 = new ReactantTree(this->DORreactantIndex2,transformationSet,32);
+	reactantTrees = new ReactantTree * [n_factors];
+	for(int f=0; f<n_factors; f++)
+		reactantTrees[f] = new ReactantTree(DORreactantIndex[f],transformationSet,32);
 
 	//Set up the reactantLists
 	reactantLists = new ReactantList *[n_reactants];
 	for (unsigned int r=0; r<n_reactants; r++) {
-		if( (signed)r!=this->DORreactantIndex1  &&  (signed)r!=this->DORreactantIndex2 )
+		reactantLists[r] = 0;
+		if( factorOfReactant[r]<0 )
 			reactantLists[r]=(new ReactantList(r,transformationSet,25));
 	}
 
 	//Initialize a to zero
 	this->a=0;
 
-	//Set the actual functions
-	this->cf1 = function1;
-	this->cf2 = function2;
-
-	// TODO: figure out if we really need to add all these molecules as TypeI dependencies.
-	//  It seems like we really only need to do this for the DOR reactant
-
-	//Add type I molecule dependencies, so that when this function
-	//is reevaluated on a molecule, the molecule knows to update this reaction
-	//for (unsigned int r=0; r<n_reactants; r++) {
-	//	cf1->addTypeIMoleculeDependency( reactantTemplates[r]->getMoleculeType() );
-	//	cf2->addTypeIMoleculeDependency( reactantTemplates[r]->getMoleculeType() );
-	//}
-	cf1->addTypeIMoleculeDependency( reactantTemplates[DORreactantIndex1]->getMoleculeType() );
-	cf2->addTypeIMoleculeDependency( reactantTemplates[DORreactantIndex2]->getMoleculeType() );
-
+	//Set the actual functions, and add type I molecule dependencies, so that when a
+	//function is reevaluated on a molecule, the molecule knows to update this reaction
+	for(int f=0; f<n_factors; f++) {
+		cfs[f] = functions.at(f);
+		cfs[f]->addTypeIMoleculeDependency( reactantTemplates[DORreactantIndex[f]]->getMoleculeType() );
+	}
 }
 
 
-DOR2RxnClass::~DOR2RxnClass() {
+DORNRxnClass::~DORNRxnClass() {
 
 	for(unsigned int r=0; r<n_reactants; r++) {
-		if( r != DORreactantIndex1  && 	r != DORreactantIndex2 )
+		if( factorOfReactant[r]<0 )
 			delete reactantLists[r];
 	}
-
 	delete [] reactantLists;
 
-	delete reactantTree1;
-	delete reactantTree2;
-
-	delete [] argIndexIntoMappingSet1;
-	delete [] argIndexIntoMappingSet2;
-	delete [] argMappedMolecule1;
-	delete [] argMappedMolecule2;
-	delete [] argScope1;
-	delete [] argScope2;
+	for(int f=0; f<n_factors; f++) {
+		delete reactantTrees[f];
+		delete [] argIndexIntoMappingSet[f];
+		delete [] argMappedMolecule[f];
+		delete [] argScope[f];
+	}
+	delete [] reactantTrees;
+	delete [] argIndexIntoMappingSet;
+	delete [] argMappedMolecule;
+	delete [] argScope;
+	delete [] n_argMolecules;
+	delete [] cfs;
+	delete [] DORreactantIndex;
+	delete [] factorOfReactant;
+	delete [] argReactantCounts;
 }
 
 
-void DOR2RxnClass::init() {
+void DORNRxnClass::init() {
 
 	//Here we have to tell the molecules that they are part of this function
 	//and for single molecule functions, we have to tell them also that they are in
@@ -958,51 +878,30 @@ void DOR2RxnClass::init() {
 }
 
 
-void DOR2RxnClass::remove(Molecule *m, unsigned int reactantPos)
+void DORNRxnClass::remove(Molecule *m, unsigned int reactantPos)
 {
-	// removing molecule from a DOR!!
-	if(reactantPos==(unsigned)this->DORreactantIndex1){
-		// handle the DOR reactant1
-		int rxnIndex = m->getMoleculeType()->getRxnIndex(this,reactantPos);
-		if(m->getRxnListMappingId(rxnIndex)>=0) {
-			//cout<<"was in the tree, so we should remove"<<endl;
-			reactantTree1->removeMappingSet(m->getRxnListMappingId(rxnIndex));
-			m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
-		}
-	}
-	else if (reactantPos==(unsigned)this->DORreactantIndex2){
-		// handle the DOR reactant2
-		int rxnIndex = m->getMoleculeType()->getRxnIndex(this,reactantPos);
-		if(m->getRxnListMappingId(rxnIndex)>=0) {
-			//cout<<"was in the tree, so we should remove"<<endl;
-			reactantTree2->removeMappingSet(m->getRxnListMappingId(rxnIndex));
-			m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
-		}
-	}
-	else {
-		// handle it normally...
-		ReactantList *rl = reactantLists[reactantPos];
-		int rxnIndex = m->getMoleculeType()->getRxnIndex(this,reactantPos);
-		if(m->getRxnListMappingId(rxnIndex)>=0) {
-			rl->removeMappingSet(m->getRxnListMappingId(rxnIndex));
-			m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
-		}
+	// removing molecule from a DOR tree, or from a normal list
+	ReactantContainer *rc = getReactantContainer(reactantPos);
+	int rxnIndex = m->getMoleculeType()->getRxnIndex(this,reactantPos);
+	if(m->getRxnListMappingId(rxnIndex)>=0) {
+		rc->removeMappingSet(m->getRxnListMappingId(rxnIndex));
+		m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
 	}
 }
 
 
-bool DOR2RxnClass::tryToAdd(Molecule *m, unsigned int reactantPos) {
+bool DORNRxnClass::tryToAdd(Molecule *m, unsigned int reactantPos) {
 
-	// adding molecule to DOR2RxnClass
-	//if(DEBUG_MESSAGE)m->printDetails();
-	if (reactantPos==(unsigned)this->DORreactantIndex1) {
+	int f = factorOfReactant[reactantPos];
+	if (f>=0) {
 
 		// handle the DOR reactant
+		ReactantTree *reactantTree = reactantTrees[f];
 		int rxnIndex = m->getMoleculeType()->getRxnIndex(this,reactantPos);
 
-		if(reactantTree1->getHasClonedMappings()) {
+		if(reactantTree->getHasClonedMappings()) {
 			if(m->getRxnListMappingId(rxnIndex)>=0) {
-				reactantTree1->removeMappingSet(m->getRxnListMappingId(rxnIndex));
+				reactantTree->removeMappingSet(m->getRxnListMappingId(rxnIndex));
 				m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
 			}
 		}
@@ -1011,58 +910,20 @@ bool DOR2RxnClass::tryToAdd(Molecule *m, unsigned int reactantPos) {
 			// was in the tree, so checking if we should remove
 			if(!reactantTemplates[reactantPos]->compare(m)) {
 				// removing
-				reactantTree1->removeMappingSet(m->getRxnListMappingId(rxnIndex));
-				m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
-			} else {}
-		} else {
-			// wasn't in the tree, so trying to push and compare
-			ms=reactantTree1->pushNextAvailableMappingSet();
-			comparisonResult = reactantTemplates[reactantPos]->compare(m,reactantTree1,ms);
-			if(!comparisonResult) {
-			//if(!reactantTemplates[reactantPos]->compare(m,reactantTree1,ms)) {
-				//cout<<"shouldn't be in the tree, so we pop"<<endl;
-				reactantTree1->removeMappingSet(ms->getId());
-			} else {
-				//we are keeping it, so evaluate the function and confirm the push
-				double localFunctionValue = evaluateLocalFunctions1(ms);
-				//if(DEBUG_MESSAGE)cout<<"local function value is: "<<localFunctionValue<<endl;
-				reactantTree1->confirmPush(ms->getId(),localFunctionValue);
-				m->setRxnListMappingId(rxnIndex,ms->getId());
-			}
-		}
-	}
-	else if (reactantPos==(unsigned)this->DORreactantIndex2) {
-
-		// handle the DOR reactant
-		int rxnIndex = m->getMoleculeType()->getRxnIndex(this,reactantPos);
-
-		if(reactantTree2->getHasClonedMappings()) {
-			if(m->getRxnListMappingId(rxnIndex)>=0) {
-				reactantTree2->removeMappingSet(m->getRxnListMappingId(rxnIndex));
+				reactantTree->removeMappingSet(m->getRxnListMappingId(rxnIndex));
 				m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
 			}
-		}
-
-		if(m->getRxnListMappingId(rxnIndex)>=0) {
-			// was in the tree, so checking if we should remove
-			if(!reactantTemplates[reactantPos]->compare(m)) {
-				// removing
-				reactantTree2->removeMappingSet(m->getRxnListMappingId(rxnIndex));
-				m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
-			} else {}
 		} else {
 			// wasn't in the tree, so trying to push and compare
-			ms=reactantTree2->pushNextAvailableMappingSet();
-			comparisonResult = reactantTemplates[reactantPos]->compare(m,reactantTree2,ms);
-			if(!comparisonResult){
-			//if(!reactantTemplates[reactantPos]->compare(m,reactantTree2,ms)) {
-				//cout<<"shouldn't be in the tree, so we pop"<<endl;
-				reactantTree2->removeMappingSet(ms->getId());
+			ms=reactantTree->pushNextAvailableMappingSet();
+			comparisonResult = reactantTemplates[reactantPos]->compare(m,reactantTree,ms);
+			if(!comparisonResult) {
+				//shouldn't be in the tree, so we pop
+				reactantTree->removeMappingSet(ms->getId());
 			} else {
 				//we are keeping it, so evaluate the function and confirm the push
-				double localFunctionValue = this->evaluateLocalFunctions2(ms);
-				//if(DEBUG_MESSAGE)cout<<"local function value is: "<<localFunctionValue<<endl;
-				reactantTree2->confirmPush(ms->getId(),localFunctionValue);
+				double localFunctionValue = evaluateLocalFunctions(f,ms);
+				reactantTree->confirmPush(ms->getId(),localFunctionValue);
 				m->setRxnListMappingId(rxnIndex,ms->getId());
 			}
 		}
@@ -1083,7 +944,6 @@ bool DOR2RxnClass::tryToAdd(Molecule *m, unsigned int reactantPos) {
 		if(m->getRxnListMappingId(rxnIndex)>=0) //If we are in this reaction...
 		{
 			if(!reactantTemplates[reactantPos]->compare(m)) {
-				//cout<<"Removing molecule "<<m->getUniqueID()<<" which was at mappingSet: "<<m->getRxnListMappingId(rxnIndex)<<endl;
 				rl->removeMappingSet(m->getRxnListMappingId(rxnIndex));
 				m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
 			}
@@ -1105,13 +965,10 @@ bool DOR2RxnClass::tryToAdd(Molecule *m, unsigned int reactantPos) {
 }
 
 
-int DOR2RxnClass::getReactantCount(unsigned int reactantIndex) const
+int DORNRxnClass::getReactantCount(unsigned int reactantIndex) const
 {
-	if (reactantIndex==(unsigned)this->DORreactantIndex1) {
-		return reactantTree1->size();
-	}
-	if (reactantIndex==(unsigned)this->DORreactantIndex2) {
-		return reactantTree2->size();
+	if (factorOfReactant[reactantIndex]>=0) {
+		return reactantTrees[factorOfReactant[reactantIndex]]->size();
 	}
 	return isPopulationType[reactantIndex] ?
 		       reactantLists[reactantIndex]->getPopulation()
@@ -1119,13 +976,10 @@ int DOR2RxnClass::getReactantCount(unsigned int reactantIndex) const
 }
 
 
-int DOR2RxnClass::getCorrectedReactantCount(unsigned int reactantIndex) const
+int DORNRxnClass::getCorrectedReactantCount(unsigned int reactantIndex) const
 {
-	if (reactantIndex==(unsigned)DORreactantIndex1) {
-		return reactantTree1->size();
-	}
-	else if (reactantIndex==(unsigned)DORreactantIndex2) {
-		return reactantTree1->size();
+	if (factorOfReactant[reactantIndex]>=0) {
+		return reactantTrees[factorOfReactant[reactantIndex]]->size();
 	}
 	return isPopulationType[reactantIndex] ?
 			   std::max( reactantLists[reactantIndex]->getPopulation()
@@ -1133,176 +987,125 @@ int DOR2RxnClass::getCorrectedReactantCount(unsigned int reactantIndex) const
 			 : reactantLists[reactantIndex]->size();
 }
 
+ReactantContainer * DORNRxnClass::getReactantContainer(unsigned int reactantIndex) const
+{
+	if (factorOfReactant[reactantIndex]>=0) return reactantTrees[factorOfReactant[reactantIndex]];
+	return reactantLists[reactantIndex];
+}
 
 
-//This function takes a given mappingset and looks up the value of its local
-//functions based on the local functions that were defined
-double DOR2RxnClass::evaluateLocalFunctions1(MappingSet *ms)
-{
-	//cout << "DOR2RxnClass::evaluateLocalFunctions1(" << ms << ")" << endl;
-	//cout << "n_argMolecules1: " << n_argMolecules1 << endl;
-	//cout << "argIndexIntoMappingSet1: " << argIndexIntoMappingSet1[0] << endl;
-	//Go through each function, and set the value of the function
 
+//This function takes a given mappingset of the DOR reactant of one factor and
+//evaluates the function of that factor on it
+double DORNRxnClass::evaluateLocalFunctions(int f, MappingSet *ms)
+{
 	//Grab the molecules needed for the local function to evaluate
-	for(int i=0; i < n_argMolecules1; i++) {
-		argMappedMolecule1[i] = ms->get(argIndexIntoMappingSet1[i])->getMolecule();
+	for(int i=0; i < n_argMolecules[f]; i++) {
+		argMappedMolecule[f][i] = ms->get(argIndexIntoMappingSet[f][i])->getMolecule();
 	}
-	//cout << "argMappedMolecule1: " << argMappedMolecule1[0]->getMoleculeTypeName() << endl;
-	//cout << "argScope1: " << argScope1[0] << endl;
 
 	// done setting molecules, so now calling the composite function evaluate method
-	int * reactantCounts = new int[n_reactants];
 	for(unsigned int r=0; r<n_reactants; r++) {
-		if(r==(unsigned int)DORreactantIndex1) {
-			reactantCounts[r] = reactantTree1->size();
-		}
-		else if(r==(unsigned int)DORreactantIndex2) {
-			reactantCounts[r] = reactantTree2->size();
-		}
-		else {
-			reactantCounts[r] = reactantLists[r]->size();
-		}
-		//cout << "n_reactants[" << r << "]=" << reactantCounts[r] << endl;
+		if(factorOfReactant[r]>=0) argReactantCounts[r] = reactantTrees[factorOfReactant[r]]->size();
+		else argReactantCounts[r] = reactantLists[r]->size();
 	}
 
-	double value = cf1->evaluateOn(argMappedMolecule1, argScope1, reactantCounts, n_reactants);
-	//cout << "return value=" << value << endl;
-
-	delete [] reactantCounts;
+	double value;
+	int failed = cfs[f]->evaluateOn(argMappedMolecule[f], argScope[f], argReactantCounts, n_reactants, value);
+	if(failed>=0) {
+		//as in DORRxnClass::evaluateLocalFunctions(), try the other molecules of the
+		//mapping set for the argument that could not be mapped
+		value = pickLocalFunctionParameter(f, ms, failed, cfs[f]->getTypeIMolecules(failed), argReactantCounts);
+	}
 	return value;
 }
 
 
-//This function takes a given mappingset and looks up the value of its local
-//functions based on the local functions that were defined
-double DOR2RxnClass::evaluateLocalFunctions2(MappingSet *ms)
+//The same search as DORRxnClass::pickLocalFunctionParameter(), for the function of one factor
+double DORNRxnClass::pickLocalFunctionParameter(int f, MappingSet* ms, int index, vector <MoleculeType *>* type1_Mol, int* reactantCounts)
 {
-	//cout << "DOR2RxnClass::evaluateLocalFunctions2(" << ms << ")" << endl;
-	//cout << "mapping molecule type: " << ms->get(0)->getMolecule()->getMoleculeTypeName() << endl;
-	//Go through each function, and set the value of the function
-
-	//Grab the molecules needed for the local function to evaluate
-	for (int i=0; i < n_argMolecules2; i++) {
-		argMappedMolecule2[i] = ms->get(argIndexIntoMappingSet2[i])->getMolecule();
-	}
-
-	// done setting molecules, so now calling the composite function evaluate method
-	int * reactantCounts = new int[n_reactants];
-	for(unsigned int r=0; r<n_reactants; r++) {
-		if(r==DORreactantIndex1) {
-			reactantCounts[r] = reactantTree1->size();
-		}
-		else if(r==this->DORreactantIndex2) {
-			reactantCounts[r] = reactantTree2->size();
-		}
-		else {
-			reactantCounts[r] = reactantLists[r]->size();
+	for(unsigned int r=0; r<ms->getNumOfMappings(); r++)
+	{
+		for (auto it: *(type1_Mol)){
+			if(it == ms->get(r)->getMolecule()->getMoleculeType()){
+				double value;
+				argMappedMolecule[f][index] = ms->get(r)->getMolecule();
+				int failed = cfs[f]->evaluateOn(argMappedMolecule[f], argScope[f], reactantCounts, n_reactants, value);
+				if(failed<0) return value;
+				if(failed == index) continue;
+				return pickLocalFunctionParameter(f, ms, failed, cfs[f]->getTypeIMolecules(failed), reactantCounts);
+			}
 		}
 	}
-
-	double value = cf2->evaluateOn(argMappedMolecule2, argScope2, reactantCounts, n_reactants);
-	//cout << "return value=" << value << endl;
-
-	delete [] reactantCounts;
-	return value;
+	cout<<"Internal error in LocalFunction::evaluateOn()! Trying to evaluate a function with unknown scope."<<endl;
+	exit(1);
 }
 
 
-double DOR2RxnClass::update_a() {
+double DORNRxnClass::update_a() {
 	a = baseRate;
-	//cout << "> DOR2RxnClass::update_a()" << endl;
-	//cout << "baseRate=" << baseRate << endl;
 	for (unsigned int i=0; i<n_reactants; i++) {
-		if (i==(unsigned int)DORreactantIndex1) {
-			a*=reactantTree1->getRateFactorSum();
-			//cout << i << ":rateFactorSum1=" << reactantTree1->getRateFactorSum() << endl;
-		}
-		else if (i==(unsigned int)DORreactantIndex2) {
-			a*=reactantTree2->getRateFactorSum();
-			//cout << i << ":rateFactorSum2=" << reactantTree2->getRateFactorSum() << endl;
+		if (factorOfReactant[i]>=0) {
+			a*=reactantTrees[factorOfReactant[i]]->getRateFactorSum();
 		}
 		else {
 			a*=(double)getCorrectedReactantCount(i);
-			//cout << i << ":ReactantCount=" << (double)getCorrectedReactantCount(i) << endl;
 		}
 	}
-	//cout << "update_a=" << a << endl;
 	return a;
 }
 
 
-void DOR2RxnClass::pickMappingSets(double randNumber) const
+void DORNRxnClass::pickMappingSets(double randNumber) const
 {
-	//here we cannot just select a random molecule.  This is where all of our hard
-	//work pays off.  We can use the tree to correctly select the next DOR reactant
-	//(as well as all the other reactants.  So here we go...
-	//double rateFactorMultiplier = baseRate;
+	//The rate is a product over the factors, so every DOR reactant is picked from
+	//its own tree, independently of the others, after the usual reactants
 	for(unsigned int i=0; i<n_reactants; i++) {
-		if( i!=(unsigned)DORreactantIndex1 && i!=(unsigned)DORreactantIndex2) {
+		if( factorOfReactant[i]<0 ) {
 			if ( isPopulationType[i] ) {
 				reactantLists[i]->pickRandomFromPopulation(mappingSet[i]);
 			} else {
 				reactantLists[i]->pickRandom(mappingSet[i]);
 			}
-			//rateFactorMultiplier*=getReactantCount(i);
 		}
 	}
 
-	double randNumber1 = NFutil::RANDOM( reactantTree1->getRateFactorSum() );
-	reactantTree1->pickReactantFromValue( mappingSet[DORreactantIndex1], randNumber1, 1.0);
-
-	double randNumber2 = NFutil::RANDOM( reactantTree2->getRateFactorSum() );
-	reactantTree2->pickReactantFromValue( mappingSet[DORreactantIndex2], randNumber2, 1.0);
-
+	for(int f=0; f<n_factors; f++) {
+		double factorRandNumber = NFutil::RANDOM( reactantTrees[f]->getRateFactorSum() );
+		reactantTrees[f]->pickReactantFromValue( mappingSet[DORreactantIndex[f]], factorRandNumber, 1.0);
+	}
 }
 
 
-void DOR2RxnClass::notifyRateFactorChange(Molecule * m, int reactantIndex, int rxnListIndex) {
-	if (reactantIndex==DORreactantIndex1) {
-		double newValue = evaluateLocalFunctions1(reactantTree1->getMappingSet(rxnListIndex));
-		reactantTree1->updateValue(rxnListIndex,newValue);
-	}
-	else if (reactantIndex==DORreactantIndex2) {
-		double newValue = evaluateLocalFunctions2(reactantTree2->getMappingSet(rxnListIndex));
-		reactantTree2->updateValue(rxnListIndex,newValue);
-	}
-	else {
-		cout<<"Internal Error in DORRxnClass::notifyRateFactorChange!!  : trying to change a rate\n";
+void DORNRxnClass::notifyRateFactorChange(Molecule * m, int reactantIndex, int rxnListIndex) {
+	int f = factorOfReactant[reactantIndex];
+	if (f<0) {
+		cout<<"Internal Error in DORNRxnClass::notifyRateFactorChange!!  : trying to change a rate\n";
 		cout<<"factor of a non-DOR reactant.  That means this function was called in error!\n";
 		exit(1);
 	}
+	double newValue = evaluateLocalFunctions(f,reactantTrees[f]->getMappingSet(rxnListIndex));
+	reactantTrees[f]->updateValue(rxnListIndex,newValue);
 }
 
 
-void DOR2RxnClass::printDetails() const
+void DORNRxnClass::printDetails() const
 {
-	cout<<"DOR2RxnClass: " << name <<"  ( baseRate="<<baseRate<<",  a="<<a<<", fired="<<fireCounter<<" times )"<<endl;
+	cout<<"DORNRxnClass: " << name <<"  ( baseRate="<<baseRate<<",  a="<<a<<", fired="<<fireCounter<<" times )"<<endl;
 	for(unsigned int r=0; r<n_reactants; r++)
 	{
-		if( r==(unsigned)DORreactantIndex1) {
-			cout<<"      -(DOR1) |"<< getReactantCount(r)<<" mappings|\t";
-			cout<<reactantTemplates[r]->getPatternString()<<"\n";
-			cout<<"             (rateFactorSum="<<reactantTree1->getRateFactorSum();
-			cout<<")."<<endl;
-		}
-		else if( r==(unsigned)DORreactantIndex2) {
-			cout<<"      -(DOR2) |"<< getReactantCount(r)<<" mappings|\t";
+		int f = factorOfReactant[r];
+		if( f>=0 ) {
+			cout<<"      -(DOR"<<f+1<<") |"<< getReactantCount(r)<<" mappings|\t";
 			cout<<reactantTemplates[r]->getPatternString()<<"\n";
-			cout<<"             (rateFactorSum="<<reactantTree2->getRateFactorSum();
+			cout<<"             (rateFactorSum="<<reactantTrees[f]->getRateFactorSum();
 			cout<<")."<<endl;
 		} else {
 			cout<<"      -|"<< getReactantCount(r)<<" mappings|\t";
 			cout<<reactantTemplates[r]->getPatternString()<<"\n";
-
 		}
 	}
 
 	if (n_reactants==0)
 		cout << "      >No Reactants: so this rule either creates new species or does nothing."<<endl;
 }
-
-
-
-
-
@@ -54,12 +54,7 @@ double FunctionalRxnClass::update_a() {
 	//	cout<<"here"<<endl;
 	if(gf!=0) {
 	//	cout<<"in here"<<endl;
-		// AS-2021
-		if(gf->fileFunc==true) {
-			gf->fileUpdate();
-		}
-		// AS-2021
-		a=FuncFactory::Eval(gf->p);
+		a=gf->getValue();
 	} else if(cf!=0) {
 		int * reactantCounts = new int[this->n_reactants];
 		for(unsigned int r=0; r<n_reactants; r++) {
@@ -255,7 +250,7 @@ int BasicRxnClass::checkForEquality(Molecule *m, MappingSet* ms, int rxnIndex, R
 	/*
 	Check if mapping set clashes with any of the mapping sets already in reactantList
 	*/
-	set<int> tempSet = m->getRxnListMappingSet(rxnIndex);
+	const set<int> &tempSet = m->getRxnListMappingSet(rxnIndex);
 	for(set<int>::iterator it= tempSet.begin();it!= tempSet.end(); ++it){
 		MappingSet* ms2 = reactantList->getMappingSet(*it);
 		if(MappingSet::checkForEquality(ms,ms2)){
@@ -306,15 +301,15 @@ bool BasicRxnClass::tryToAdd(Molecule *m, unsigned int reactantPos)
 	//cout<<" ... as a mormal reaction "<<this->name<<endl;
 
 
-	//If this reaction has multiple instances, we always remove them all!
-	// then we remap because other mappings may have changed.  Yes, this may
-	// be more ineffecient, but it is the fast implementation
-	if(rl->getHasClonedMappings()) {
-		while(m->getRxnListMappingId(rxnIndex)>=0) {
-			rl->removeMappingSet(m->getRxnListMappingId(rxnIndex));
-			m->deleteRxnListMappingId(rxnIndex,m->getRxnListMappingId(rxnIndex));
-			//m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
-		}
+	//We don't remove the mapping sets the molecule already has before remapping
+	// it.  They are set aside and stay in the list, and once the new mappings
+	// are known, keepUnchangedMappingSets() puts back the old ones that map
+	// exactly the same, so only the mappings that changed are removed or added.
+	previousMappingIds.clear();
+	if(m->getRxnListMappingId(rxnIndex)>=0) {
+		const set<int> &ids = m->getRxnListMappingSet(rxnIndex);
+		previousMappingIds.assign(ids.begin(),ids.end());
+		m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
 	}
 
 	// Here we get the standard update...
@@ -375,17 +370,20 @@ bool BasicRxnClass::tryToAdd(Molecule *m, unsigned int reactantPos)
 	// 	}
 	// }
 
-	//Here we get the standard update...
-	while(m->getRxnListMappingId(rxnIndex)>=0) {
-		rl->removeMappingSet(m->getRxnListMappingId(rxnIndex));
-		m->deleteRxnListMappingId(rxnIndex,m->getRxnListMappingId(rxnIndex));
-		//m->setRxnListMappingId(rxnIndex,Molecule::NOT_IN_RXN);
+	//If the same pattern already failed to match this molecule in this event,
+	// there is nothing to map
+	bool remembered;
+	if(reactantTemplates[reactantPos]->findRememberedMatch(m,remembered) && !remembered) {
+		if(!previousMappingIds.empty())
+			keepUnchangedMappingSets(m,rxnIndex);
+		return true;
 	}
 
 	//Try to map it!
 	ms = rl->pushNextAvailableMappingSet();
 	symmetricMappingSet.clear();
 	comparisonResult = reactantTemplates[reactantPos]->compare(m,rl,ms,false,&symmetricMappingSet);
+	reactantTemplates[reactantPos]->rememberMatch(m,comparisonResult);
 	if(!comparisonResult) {
 		//cout << "no mapping in normal reaction, remove"<<endl;
 		//we must remove, if we did not match.  This will also remove
@@ -422,10 +420,56 @@ bool BasicRxnClass::tryToAdd(Molecule *m, unsigned int reactantPos)
 		
 	}
 
+	if(!previousMappingIds.empty())
+		keepUnchangedMappingSets(m,rxnIndex);
+
 	return true;
 }
 
 
+//Two mapping sets are the same if they, and the chains of clones hanging off of
+//them, map every position onto the same molecules
+static bool isSameMappingSet(ReactantList *rl, MappingSet *ms1, MappingSet *ms2)
+{
+	while(MappingSet::checkForSameMappings(ms1,ms2)) {
+		unsigned int clone1 = ms1->getClonedMapping();
+		unsigned int clone2 = ms2->getClonedMapping();
+		if(clone1==MappingSet::NO_CLONE || clone2==MappingSet::NO_CLONE)
+			return clone1==clone2;
+		ms1 = rl->getMappingSet(clone1);
+		ms2 = rl->getMappingSet(clone2);
+	}
+	return false;
+}
+
+
+void BasicRxnClass::keepUnchangedMappingSets(Molecule *m, int rxnIndex)
+{
+	//Swap every new mapping set that repeats an old one for the old one, which
+	//keeps its place in the list
+	const set<int> &ids = m->getRxnListMappingSet(rxnIndex);
+	newMappingIds.assign(ids.begin(),ids.end());
+	for(unsigned int n=0; n<newMappingIds.size(); n++) {
+		MappingSet *newMs = rl->getMappingSet(newMappingIds[n]);
+		for(unsigned int k=0; k<previousMappingIds.size(); k++) {
+			if(previousMappingIds[k]<0) continue;
+			if(isSameMappingSet(rl,rl->getMappingSet(previousMappingIds[k]),newMs)) {
+				rl->removeMappingSet(newMappingIds[n]);
+				m->deleteRxnListMappingId(rxnIndex,newMappingIds[n]);
+				m->setRxnListMappingId(rxnIndex,previousMappingIds[k]);
+				previousMappingIds[k] = -1;
+				break;
+			}
+		}
+	}
+
+	//and whatever old mappings did not come back are gone
+	for(unsigned int k=0; k<previousMappingIds.size(); k++)
+		if(previousMappingIds[k]>=0) rl->removeMappingSet(previousMappingIds[k]);
+	previousMappingIds.clear();
+}
+
+
 
 void BasicRxnClass::remove(Molecule *m, unsigned int reactantPos)
 {
@@ -29,11 +29,16 @@ namespace NFcore
 			virtual void notifyRateFactorChange(Molecule * m, int reactantIndex, int rxnListIndex);
 			virtual int getReactantCount(unsigned int reactantIndex) const;
 			virtual int getCorrectedReactantCount(unsigned int reactantIndex) const;
+			virtual ReactantContainer * getReactantContainer(unsigned int reactantIndex) const { return reactantLists[reactantIndex]; };
 
 			virtual void printFullDetails() const;
 
 		protected:
 			virtual void pickMappingSets(double randNumber) const;
+
+			//puts back the molecule's previous mapping sets that the new ones repeat
+			void keepUnchangedMappingSets(Molecule *m, int rxnIndex);
+
 			// AS-6/22
 			bool connectivityFlag;
 
@@ -41,6 +46,8 @@ namespace NFcore
 
 			ReactantList *rl;
 			MappingSet *ms;
+			vector <int> previousMappingIds;
+			vector <int> newMappingIds;
 	};
 
 
@@ -95,6 +102,7 @@ namespace NFcore
 			virtual double update_a();
 
 			virtual int getDORreactantPosition() const { return DORreactantIndex; };
+			virtual bool isDORreactant(int rPosition) const { return rPosition==DORreactantIndex; };
 
 			//JJT: checks if there's an existing mapping set in *m equal to *ms that maps to this reaction
 			virtual int checkForCollision(Molecule *m, MappingSet* ms,int rxnIndex);
@@ -102,6 +110,7 @@ namespace NFcore
 			virtual void notifyRateFactorChange(Molecule * m, int reactantIndex, int rxnListIndex);
 			virtual int getReactantCount(unsigned int reactantIndex) const;
 			virtual int getCorrectedReactantCount(unsigned int reactantIndex) const;
+			virtual ReactantContainer * getReactantContainer(unsigned int reactantIndex) const;
 
 			virtual void printDetails() const;
 			virtual void printFullDetails() const {};
@@ -134,6 +143,7 @@ namespace NFcore
 			int * argIndexIntoMappingSet;
 			Molecule ** argMappedMolecule;
 			int * argScope;
+			int * argReactantCounts; /*!< the reactant counts handed to cf */
 
 
 			//vector <int> argIndexIntoMappingSet;
@@ -146,22 +156,24 @@ namespace NFcore
 
 	};
 
-	/* A reaction class with DOR calculations on two reactants.
-	 * The rate function must be factored as  f(x,y) = g(x)*h(y)
+	/* A reaction class with DOR calculations on any number of reactants.
+	 * The rate function must be factored as  f(x,y,..) = g(x)*h(y)*.., with one
+	 * factor for each reactant that has local function references, in the order
+	 * of the reactants.  Each of those reactants gets its own ReactantTree, the
+	 * propensity is the product of the tree sums and each factor is sampled from
+	 * its own tree.
 	 * */
-	class DOR2RxnClass : public ReactionClass {
+	class DORNRxnClass : public ReactionClass {
 		public:
-			DOR2RxnClass(
+			DORNRxnClass(
 					string name,
 					double baseRate,
 					string baseRateName,
 					TransformationSet *transformationSet,
-					CompositeFunction *function1,
-					CompositeFunction *function2,
-					vector <string> &lfArgumentPointerNameList1,
-					vector <string> &lfArgumentPointerNameList2,
+					vector <CompositeFunction *> &functions,
+					vector <vector <string> > &lfArgumentPointerNameLists,
 					System *s);
-			virtual ~DOR2RxnClass();
+			virtual ~DORNRxnClass();
 
 			virtual void init();
 			virtual void prepareForSimulation() {};
@@ -169,50 +181,41 @@ namespace NFcore
 			virtual void remove(Molecule *m, unsigned int reactantPos);
 			virtual double update_a();
 
-			virtual int getDORreactantPosition()  const { return DORreactantIndex1; };
-			virtual int getDORreactantPosition2() const { return DORreactantIndex2; };
+			virtual int getDORreactantPosition() const { return DORreactantIndex[0]; };
+			virtual bool isDORreactant(int rPosition) const { return factorOfReactant[rPosition]>=0; };
 
 			virtual void notifyRateFactorChange(Molecule * m, int reactantIndex, int rxnListIndex);
 			virtual int getReactantCount(unsigned int reactantIndex) const;
 			virtual int getCorrectedReactantCount(unsigned int reactantIndex) const;
+			virtual ReactantContainer * getReactantContainer(unsigned int reactantIndex) const;
 
 			virtual void printDetails() const;
 			virtual void printFullDetails() const {};
 
-			void directAddForDebugging(Molecule *m);
-			void printTreeForDebugging();
-
-			static void test1(System *s);
-
 		protected:
 
-			virtual double evaluateLocalFunctions1(MappingSet *ms);
-			virtual double evaluateLocalFunctions2(MappingSet *ms);
+			virtual double evaluateLocalFunctions(int factor, MappingSet *ms);
 
 			virtual void pickMappingSets(double randNumber) const;
 
+			virtual double pickLocalFunctionParameter(int factor, MappingSet *ms, int, vector <MoleculeType *>*, int*);
+
 			ReactantList **reactantLists;
-			ReactantTree *reactantTree1;
-			ReactantTree *reactantTree2;
 
-			// TODO: figure out if we need one of two of these
 			MappingSet *ms;
 
-			CompositeFunction *cf1;
-			CompositeFunction *cf2;
-
-			//Parameters to keep track of local functions
-			int DORreactantIndex1;
-			int DORreactantIndex2;
-
-			int n_argMolecules1;
-			int n_argMolecules2;
-			int * argIndexIntoMappingSet1;
-			int * argIndexIntoMappingSet2;
-			Molecule ** argMappedMolecule1;
-			Molecule ** argMappedMolecule2;
-			int * argScope1;
-			int * argScope2;
+			//Parameters to keep track of the factors, indexed by factor
+			int n_factors;
+			int *factorOfReactant;  /*!< the factor of each reactant, or -1 */
+			int *DORreactantIndex;
+			ReactantTree **reactantTrees;
+			CompositeFunction **cfs;
+
+			int *n_argMolecules;
+			int **argIndexIntoMappingSet;
+			Molecule ***argMappedMolecule;
+			int **argScope;
+			int * argReactantCounts; /*!< the reactant counts handed to the functions */
 
 	};
 
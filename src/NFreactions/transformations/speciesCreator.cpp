@@ -12,7 +12,6 @@ SpeciesCreator::SpeciesCreator(
 {
 	try {
 		this->n_molecules = productMoleculeTypes.size();
-		cout << "\t\t\tNew species Creator!! num of molecules in species: "<<n_molecules<<endl;
 
 		//Copy over the molecules
 		n_molecules = productMoleculeTypes.size();
@@ -20,7 +19,6 @@ SpeciesCreator::SpeciesCreator(
 		for(unsigned int m=0; m<n_molecules; m++)
 		{
 			moleculeTypes[m]=productMoleculeTypes.at(m);
-			cout << "\t\t\t\t" << m << ": " << moleculeTypes[m]->getName() << endl;
 		}
 
 		newMoleculeCreations = new Molecule *[n_molecules];
@@ -37,8 +35,6 @@ SpeciesCreator::SpeciesCreator(
 			ndStateMolecule[s]=stateInformation.at(0).at(s);
 			ndStateIndex[s]=stateInformation.at(1).at(s);
 			ndStateValue[s]=stateInformation.at(2).at(s);
-
-			cout<<"state"<<s<<" : "<<ndStateMolecule[s]<<" "<< ndStateIndex[s]<<" "<<ndStateValue[s]<<endl;
 		}
 
 		//Save the bonds that we have to create
@@ -54,12 +50,16 @@ SpeciesCreator::SpeciesCreator(
 			bMolecule2[b]=bindingSiteInformation.at(2).at(b);
 			bSite1[b]=bindingSiteInformation.at(1).at(b);
 			bSite2[b]=bindingSiteInformation.at(3).at(b);
-
-			cout<<"bonds"<<b<<" : "<<bMolecule1[b]<<","<<bSite1[b]<<"  to  "<<bMolecule2[b]<<","<<bSite2[b]<<endl;
-
-
 		}
 
+		//The count of a population molecule is not part of the species, so
+		//its matches can't be reused
+		hasPrototype = false;
+		usePrototype = true;
+		prototypeOnTheFlyVersion = 0;
+		for(unsigned int m=0; m<n_molecules; m++)
+			if(moleculeTypes[m]->isPopulationType()) usePrototype = false;
+
 	} catch(std::exception& err){
 		cout<<"Error when creating a new SpeciesCreator object: SpeciesCreator was not properly creaated... quitting."<<endl;
 		err.what();
@@ -232,19 +232,8 @@ void SpeciesCreator::create()
 		Molecule::bind(m1,bSite1[b],m2,bSite2[b]);
 	}
 
-	//Create all the molecules
-	//Molecule *m = mt->genDefaultMolecule();
-
-	//Set all the states etc...
-
 	//Prep the molecules and enter them into the simulation
-	for(unsigned int m=0; m<n_molecules; m++)
-	{
-		moleculeTypes[m]->addMoleculeToRunningSystem(newMoleculeCreations[m]);
-		//cout<<"Created:"<<endl;
-		//newMoleculeCreations[m]->printDetails();
-		//cout<<endl;
-	}
+	addToRunningSystem();
 }
 
 // AS2023 - alternate call sig to write and store a log of species creation
@@ -289,12 +278,26 @@ void SpeciesCreator::create(string &logstr)
 		}
 	}
 
-	//Create all the molecules
-	//Molecule *m = mt->genDefaultMolecule();
+	//Prep the molecules and enter them into the simulation
+	addToRunningSystem();
+}
 
-	//Set all the states etc...
 
-	//Prep the molecules and enter them into the simulation
+void SpeciesCreator::addToRunningSystem()
+{
+	System *s = moleculeTypes[0]->getSystem();
+	if(hasPrototype && prototypeOnTheFlyVersion!=s->getOnTheFlyVersion())
+		hasPrototype = false;
+
+	if(hasPrototype) {
+		for(unsigned int m=0; m<n_molecules; m++)
+		{
+			moleculeTypes[m]->addMoleculeToRunningSystem(newMoleculeCreations[m],
+					prototypeRxnMembership[m], prototypeObsMatches[m]);
+		}
+		return;
+	}
+
 	for(unsigned int m=0; m<n_molecules; m++)
 	{
 		moleculeTypes[m]->addMoleculeToRunningSystem(newMoleculeCreations[m]);
@@ -302,4 +305,16 @@ void SpeciesCreator::create(string &logstr)
 		//newMoleculeCreations[m]->printDetails();
 		//cout<<endl;
 	}
+
+	if(usePrototype) {
+		prototypeRxnMembership.resize(n_molecules);
+		prototypeObsMatches.resize(n_molecules);
+		for(unsigned int m=0; m<n_molecules; m++)
+		{
+			moleculeTypes[m]->getRunningSystemMembership(newMoleculeCreations[m],
+					prototypeRxnMembership[m], prototypeObsMatches[m]);
+		}
+		hasPrototype = true;
+		prototypeOnTheFlyVersion = s->getOnTheFlyVersion();
+	}
 }
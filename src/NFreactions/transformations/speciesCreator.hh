@@ -26,6 +26,9 @@ namespace NFcore
 			void create(string &logstr);
 		
 		protected:
+
+			//Enters the new molecules into the observables and reactions
+			void addToRunningSystem();
 			
 			unsigned int n_molecules;
 			MoleculeType ** moleculeTypes;
@@ -47,6 +50,19 @@ namespace NFcore
 			int *bMolecule2;
 			int *bSite1;
 			int *bSite2;
+
+
+			//The species is the same every time, so what it matches is too.  The first
+			//creation goes through the full matching and records, for each molecule, the
+			//reactions it became a reactant of and its observable matches.  Later creations
+			//only try those reactions and count the observables without comparing.  The
+			//matches of observables that were not on the fly then are not recorded, so the
+			//prototype is dropped when the system puts more observables on the fly.
+			bool hasPrototype;
+			bool usePrototype;
+			unsigned int prototypeOnTheFlyVersion;
+			vector < vector <int> > prototypeRxnMembership;
+			vector < vector <int> > prototypeObsMatches;
 	};
 
 
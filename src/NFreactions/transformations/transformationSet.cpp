@@ -4,9 +4,9 @@
 using namespace NFcore;
 
 
-list <Molecule *> TransformationSet::deleteList;
-list <Molecule *> TransformationSet::updateAfterDeleteList;
-list <Molecule *>::iterator TransformationSet::it;
+thread_local list <Molecule *> TransformationSet::deleteList;
+thread_local list <Molecule *> TransformationSet::updateAfterDeleteList;
+thread_local list <Molecule *>::iterator TransformationSet::it;
 TransformationSet::TransformationSet(vector <TemplateMolecule *> reactantTemplates) // @suppress("Class members should be properly initialized")
 {
 	this->hasSymUnbinding=false;
@@ -289,6 +289,11 @@ namespace NFcore
 			 */
 			int getNumOfAddMoleculeTransforms() const { return addMoleculeTransformations.size(); };
 
+			/*
+			 * Query the number of addSpeciesTransforms in this set
+			 */
+			int getNumOfAddSpeciesTransforms() const { return addSpeciesTransformations.size(); };
+
 			/*
 			 * If AddMolecule is a population, returns a pointer to the population object,
 			 *  otherwise returns null.  --Justin
@@ -343,14 +348,14 @@ namespace NFcore
 			vector <AddSpeciesTransform *> addSpeciesTransformations;
 
 			/*!	List to keep track of the molecules that we are going to delete when a transformation is applied	*/
-			static list <Molecule *> deleteList;
+			static thread_local list <Molecule *> deleteList;
 
 			/*!	List to keep track of the molecules that we have to update as a result of a deletion	*/
-			static list <Molecule *> updateAfterDeleteList;
+			static thread_local list <Molecule *> updateAfterDeleteList;
 
 
 			/*!	iterator for the deleteList and updateAfterDeleteList	*/
-			static list <Molecule *>::iterator it;
+			static thread_local list <Molecule *>::iterator it;
 
 
 			/*!	keeps track if this set has a symmetric unbinding reaction	*/
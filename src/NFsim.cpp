@@ -74,6 +74,9 @@
  *
  *  -notf = disables On the Fly Observables, see manual
  *
+ *  -obsThreads [integer] = number of threads that recount observables at output steps,
+ *          and that write the species list of -ss
+ *
  *  -cb = turn on complex bookkeeping, see manual
  * 
  *  -connect - infer network connectivity before starting simulation. (default: no).
@@ -101,6 +104,58 @@
  *
  *  -maxcputime - maximum run time for simulation in seconds (default: no limit).
  *                 @author Arvind Rasi Subramaniam
+ *
+ *  -profile [filename] = per-phase and per-rule timing report, only available when
+ *                 built with NFSIM_PROFILE (cmake -DNFSIM_PROFILE=ON)
+ *
+ *  -perfcounters = add cycles, instructions, cache misses and branch misses per
+ *                 phase to the -profile report, read with perf_event_open on Linux
+ *
+ *  -memreport [filename] = bytes and object counts by subsystem, printed when the
+ *                 system is prepared and at each output step
+ *
+ *  -maxevents [integer] = stop the simulation after a fixed number of events, see
+ *                 models/performance_test_models/README for the benchmark suite
+ *
+ *  -replicates [integer] = run the model this many times and write the mean and
+ *                 standard deviation of each output column at each sample time to
+ *                 [name]_ensemble.gdat, or to the file given with -ensemble.  Each
+ *                 replicate i is seeded with seed+i.  -rprocs [integer] splits the
+ *                 replicates over that many processes, and -rout also writes the
+ *                 gdat file of each replicate.
+ *
+ *  -split [integer] = simulate the independent subsystems of the -xml model, the
+ *                 groups of molecule types that no rule or observable connects, on
+ *                 up to this many threads (one per core by default).  Subsystem k is
+ *                 seeded with seed+k, and every subsystem keeps its own copy of the
+ *                 model in memory.
+ *
+ *  -optimistic [integer] = run the events of the one system on up to this many
+ *                 threads (one per core by default) with the experimental engine in
+ *                 src/NFcore/optimisticEngine.hh.  Events that touch different complexes
+ *                 run at once, and the trajectory does not depend on the number of
+ *                 threads.  -obatch [integer] sets the most events drawn at a time
+ *                 (4096 by default).  Models the engine can't run are simulated as usual.
+ *
+ *  -subvolumes [integer] = simulate the model on a grid with this many well-mixed
+ *                 subvolumes per side (10 by default), with the experimental engine in
+ *                 src/NFcore/subvolumeEngine.hh.  -sdim [2 or 3] gives the number of
+ *                 dimensions (3 by default, 2 for membranes), and -hop [double] the rate
+ *                 at which a complex jumps to each neighbouring subvolume (1 by default).
+ *                 It runs the same models as -optimistic, and other models as usual.
+ *
+ *  -nooutput = do not write the gdat file, for runs that only need the final state
+ *                 or are driven through the library API in src/NFapi
+ *
+ *  -serve [socket] = keep the -xml model loaded and run RNF style commands sent over
+ *                 a unix domain socket, see src/NFapi/NFserver.hh for the protocol
+ *
+ *  -agentcell -population = run -nCells chemotactic cells of the -xml model in one
+ *                 environment on -nThreads threads, writing positions and CheYp to
+ *                 [oDir]/population.dat, see src/NFtest/agentcell/population.hh
+ *
+ *  -test microbench = time the core data structures in isolation, see
+ *                 src/NFtest/microbench (options -reps, -warmup, -seed, -out)
  * 
  *  -printmoltypes - output molecule types (default: false).
  * 						   @author Ali Sinan Saglam
@@ -179,6 +234,13 @@
 #include <string>
 #include <time.h>
 #include <limits>
+#include <thread>
+#include <chrono>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 using namespace std;
 
@@ -210,6 +272,9 @@ System *initSystemFromFlags(map<string,string> argMap, bool verbose);
 
 
 
+// libnfsim is built from the same sources, without main()
+#ifndef NFSIM_LIBRARY
+
 //!  Main executable for the NFsim program.
 /*!
   @author Michael Sneddon
@@ -275,6 +340,27 @@ int main(int argc, char *argv[])
 			parsed = true;
 		}
 
+		//  Keeping an XML file loaded and serving commands on a socket...
+		else if (argMap.find("xml")!=argMap.end() && argMap.find("serve")!=argMap.end())
+		{
+			NFserver::serve(argMap, verbose);
+			parsed = true;
+		}
+
+		//  Running an ensemble of replicates of an XML file...
+		else if (argMap.find("xml")!=argMap.end() && argMap.find("replicates")!=argMap.end())
+		{
+			runReplicates(argMap, verbose);
+			parsed = true;
+		}
+
+		//  Running the independent parts of an XML file on separate threads...
+		else if (argMap.find("xml")!=argMap.end() && argMap.find("split")!=argMap.end())
+		{
+			runSubsystems(argMap, verbose);
+			parsed = true;
+		}
+
 		//  Main entry point for a basic XML file...
 		else if (argMap.find("xml")!=argMap.end())
 		{
@@ -307,6 +393,10 @@ int main(int argc, char *argv[])
 					NFtest_tlbr::run(argMap);
 					foundATest=true;
 				}
+				if(test=="microbench") {
+					NFtest_microbench::run(argMap);
+					foundATest=true;
+				}
 				if(test=="mathFuncParser") {
 					FuncFactory::test();
 					foundATest=true;
@@ -348,6 +438,8 @@ int main(int argc, char *argv[])
     return 0;
 }
 
+#endif /* NFSIM_LIBRARY */
+
 
 
 bool runRNFscript(map<string,string> argMap, bool verbose)
@@ -527,6 +619,8 @@ System *initSystemFromFlags(map<string,string> argMap, bool verbose)
 						s->setOutputRxnFiringCounts(false);
 					};
 
+				} else if (argMap.find("nooutput")!=argMap.end()) {
+					if(verbose) cout<<"\tNo output file will be written (detected -nooutput flag)."<<endl<<endl;
 				} else {
 					if(s->isOutputtingBinary()) {
 						s->registerOutputFileLocation(s->getName()+"_nf.dat");
@@ -588,6 +682,34 @@ System *initSystemFromFlags(map<string,string> argMap, bool verbose)
 					if(verbose) cout<<"\tOn-the-fly observables is turned on (detected -notf flag)."<<endl<<endl;
 				}
 
+				//the number of threads that recount observables at output steps
+				if(argMap.find("obsThreads")!=argMap.end()) {
+					s->setObservableThreads(NFinput::parseAsInt(argMap,"obsThreads",1));
+					if(verbose) cout<<"\tRecounting observables on "<<s->getObservableThreads()<<" threads (detected -obsThreads flag)."<<endl<<endl;
+				}
+
+				//turn on the per-phase profiler, if it was compiled in
+				if(argMap.find("profile")!=argMap.end()) {
+					if(Profiler::enable()) {
+						string profileFileName = argMap.find("profile")->second;
+						if(!profileFileName.empty()) Profiler::setReportFile(profileFileName);
+						if(verbose) cout<<"\tProfiling the simulation loop (detected -profile flag)."<<endl<<endl;
+					}
+				}
+
+				//also read the hardware performance counters around each profiled phase
+				if(argMap.find("perfcounters")!=argMap.end()) {
+					if(Profiler::enabled || Profiler::enable("perfcounters")) {
+						if(Profiler::enableCounters() && verbose)
+							cout<<"\tReading hardware counters in each phase (detected -perfcounters flag)."<<endl<<endl;
+					}
+				}
+
+				//report memory use by subsystem when prepared and at every output step
+				if(argMap.find("memreport")!=argMap.end()) {
+					s->turnOnMemoryReport(argMap.find("memreport")->second);
+					if(verbose) cout<<"\tReporting memory use at each output step (detected -memreport flag)."<<endl<<endl;
+				}
 
 
 
@@ -609,6 +731,61 @@ System *initSystemFromFlags(map<string,string> argMap, bool verbose)
 }
 
 
+bool runOptimistic(System *s, map<string,string> &argMap, double eqTime, double sTime, int oSteps)
+{
+	int nThreads = (int)thread::hardware_concurrency();
+	if(!argMap.find("optimistic")->second.empty())
+		nThreads = NFinput::parseAsInt(argMap,"optimistic",nThreads);
+	int batchSize = NFinput::parseAsInt(argMap,"obatch",4096);
+
+	const char *unsupported[] = {"rxnlog","dump","maxevents","profile"};
+	string flag;
+	for(unsigned int f=0; f<sizeof(unsupported)/sizeof(unsupported[0]); f++)
+		if(argMap.find(unsupported[f])!=argMap.end()) flag = unsupported[f];
+
+	OptimisticEngine engine(s,nThreads,batchSize);
+	if(!engine.isSupported() || !flag.empty()) {
+		if(!flag.empty()) cout<<"The -"<<flag<<" flag needs the regular engine, so -optimistic is ignored."<<endl;
+		else cout<<"The optimistic engine can't run this model ("<<engine.getUnsupportedReason()<<"), so it is simulated with the regular engine."<<endl;
+		return false;
+	}
+
+	cout<<endl<<endl<<endl<<"Equilibrating for :"<<eqTime<<"s.  Please wait."<<endl<<endl;
+	engine.equilibrate(eqTime);
+	engine.sim(sTime,oSteps);
+	return true;
+}
+
+
+bool runSubvolumes(System *s, map<string,string> &argMap, double eqTime, double sTime, int oSteps)
+{
+	int nPerSide = 10;
+	if(!argMap.find("subvolumes")->second.empty())
+		nPerSide = NFinput::parseAsInt(argMap,"subvolumes",nPerSide);
+	int nDimensions = NFinput::parseAsInt(argMap,"sdim",3);
+	double hopRate = NFinput::parseAsDouble(argMap,"hop",1.0);
+
+	const char *unsupported[] = {"rxnlog","dump","maxevents","profile"};
+	for(unsigned int f=0; f<sizeof(unsupported)/sizeof(unsupported[0]); f++) {
+		if(argMap.find(unsupported[f])!=argMap.end()) {
+			cout<<"The -"<<unsupported[f]<<" flag needs the regular engine, so -subvolumes is ignored."<<endl;
+			return false;
+		}
+	}
+
+	SubvolumeEngine engine(s,nPerSide,nDimensions,hopRate);
+	if(!engine.isSupported()) {
+		cout<<"The subvolume engine can't run this model ("<<engine.getUnsupportedReason()<<"), so it is simulated with the regular engine."<<endl;
+		return false;
+	}
+
+	cout<<endl<<endl<<endl<<"Equilibrating for :"<<eqTime<<"s.  Please wait."<<endl<<endl;
+	engine.equilibrate(eqTime);
+	engine.sim(sTime,oSteps);
+	return true;
+}
+
+
 bool runFromArgs(System *s, map<string,string> argMap, bool verbose)
 {
 	// default simulation time is 10 seconds outputting
@@ -629,6 +806,11 @@ bool runFromArgs(System *s, map<string,string> argMap, bool verbose)
 
 	oSteps = NFinput::parseAsInt(argMap,"oSteps",(int)oSteps);
 
+	// stop after a fixed number of events (used by the benchmark suite)
+	if (argMap.find("maxevents") != argMap.end()) {
+		s->setMaxEvents(NFinput::parseAsInt(argMap,"maxevents",-1));
+	}
+
 	//Prepare the system for simulation!!
 	s->prepareForSimulation();
 
@@ -640,6 +822,8 @@ bool runFromArgs(System *s, map<string,string> argMap, bool verbose)
 		s->printAllObservableCounts(0);
 		cout<<endl;
 		s->printAllFunctions();
+		if(s->getNumOfSubsystems()>1)
+			cout<<"the model splits into "<<s->getNumOfSubsystems()<<" independent subsystems, which the -split flag simulates on separate threads."<<endl;
 		cout<<"-------------------------\n";
 	}
 
@@ -648,6 +832,12 @@ bool runFromArgs(System *s, map<string,string> argMap, bool verbose)
 	if (argMap.find("walk")!=argMap.end()) {
 		NFinput::walk(s);
 	}
+	else if (argMap.find("optimistic")!=argMap.end() && runOptimistic(s,argMap,eqTime,sTime,oSteps)) {
+		// the optimistic engine did the run
+	}
+	else if (argMap.find("subvolumes")!=argMap.end() && runSubvolumes(s,argMap,eqTime,sTime,oSteps)) {
+		// the subvolume engine did the run
+	}
 	else {
 		// Do the run
 		cout<<endl<<endl<<endl<<"Equilibrating for :"<<eqTime<<"s.  Please wait."<<endl<<endl;
@@ -676,6 +866,251 @@ bool runFromArgs(System *s, map<string,string> argMap, bool verbose)
 
 
 
+//! Runs one replicate of the ensemble and folds its output into the statistics
+static bool runReplicate(map<string,string> argMap, int replicate, unsigned long baseSeed,
+		string stem, EnsembleStats &stats, bool verbose)
+{
+	if (argMap.find("rout")!=argMap.end())
+		argMap["o"] = stem+"_rep"+NFutil::toString(replicate)+".gdat";
+	else {
+		// replicates of an ensemble only write the summary, unless -rout is given
+		argMap.erase("o");
+		argMap["nooutput"] = "";
+	}
+
+	NFutil::SEED_RANDOM(baseSeed+replicate);
+	cout<<"\n\nreplicate "<<replicate<<" (seed "<<(baseSeed+replicate)<<")"<<endl;
+	System *s = initSystemFromFlags(argMap, verbose);
+	if(s==NULL) return false;
+	s->setEnsembleStats(&stats);
+	bool ok = runFromArgs(s,argMap,verbose);
+	s->setEnsembleStats(0);
+	delete s;
+	return ok;
+}
+
+
+bool runReplicates(map<string,string> argMap, bool verbose)
+{
+	int nReplicates = NFinput::parseAsInt(argMap,"replicates",1);
+	if(nReplicates<1) {
+		cout<<"The -replicates flag needs a positive number of replicates."<<endl;
+		return false;
+	}
+	int nProcs = NFinput::parseAsInt(argMap,"rprocs",1);
+	if(nProcs<1) nProcs = 1;
+	if(nProcs>nReplicates) nProcs = nReplicates;
+
+	// each replicate is seeded on its own, so that the ensemble does not
+	// depend on how the replicates are split over processes
+	unsigned long baseSeed = (unsigned long) time(NULL);
+	if(argMap.find("seed")!=argMap.end())
+		baseSeed = abs(NFinput::parseAsInt(argMap,"seed",0));
+
+	// name the outputs after the -o file if given, otherwise the xml file
+	string stem = argMap.find("xml")->second;
+	if (argMap.find("o")!=argMap.end() && !argMap.find("o")->second.empty())
+		stem = argMap.find("o")->second;
+	size_t dot = stem.find_last_of('.');
+	if(dot!=string::npos && stem.find_first_of("/\\",dot)==string::npos) stem = stem.substr(0,dot);
+	if (argMap.find("o")==argMap.end()) {
+		size_t slash = stem.find_last_of("/\\");
+		if(slash!=string::npos) stem = stem.substr(slash+1);
+	}
+	string summaryFile = stem+"_ensemble.gdat";
+	if (argMap.find("ensemble")!=argMap.end() && !argMap.find("ensemble")->second.empty())
+		summaryFile = argMap.find("ensemble")->second;
+
+	cout<<"running "<<nReplicates<<" replicates";
+	if(nProcs>1) cout<<" in "<<nProcs<<" processes";
+	cout<<", summary will be written to: "<<summaryFile<<endl;
+
+	EnsembleStats stats;
+	bool ok = true;
+	if(nProcs==1) {
+		for(int r=0; r<nReplicates && ok; r++)
+			ok = runReplicate(argMap,r,baseSeed,stem,stats,verbose);
+	}
+	else {
+#ifndef _WIN32
+		// every worker runs every nProcs-th replicate, and sends its statistics
+		// back to this process through a pipe when it is done
+		vector <int> pipes;
+		vector <pid_t> workers;
+		for(int w=0; w<nProcs; w++) {
+			int fd[2];
+			if(pipe(fd)!=0) {
+				cerr<<"Could not create a pipe to a replicate worker process."<<endl;
+				ok = false;
+				break;
+			}
+			cout.flush();
+			pid_t pid = fork();
+			if(pid<0) {
+				cerr<<"Could not fork a replicate worker process."<<endl;
+				close(fd[0]); close(fd[1]);
+				ok = false;
+				break;
+			}
+			if(pid==0) {
+				close(fd[0]);
+				if(!verbose) {
+					if(freopen("/dev/null","w",stdout)==NULL) cerr<<"Could not silence a replicate worker."<<endl;
+				}
+				EnsembleStats partial;
+				bool workerOk = true;
+				for(int r=w; r<nReplicates && workerOk; r+=nProcs)
+					workerOk = runReplicate(argMap,r,baseSeed,stem,partial,verbose);
+				string buffer;
+				if(workerOk) partial.serialize(buffer);
+				size_t written = 0;
+				while(written<buffer.size()) {
+					ssize_t n = write(fd[1], buffer.data()+written, buffer.size()-written);
+					if(n<=0) { workerOk = false; break; }
+					written += n;
+				}
+				close(fd[1]);
+				cout.flush();
+				_exit(workerOk ? 0 : 1);
+			}
+			close(fd[1]);
+			pipes.push_back(fd[0]);
+			workers.push_back(pid);
+		}
+
+		for(unsigned int w=0; w<workers.size(); w++) {
+			string buffer;
+			char chunk[65536];
+			ssize_t n;
+			while((n = read(pipes[w], chunk, sizeof(chunk))) > 0) buffer.append(chunk,n);
+			close(pipes[w]);
+			int status = 0;
+			waitpid(workers[w], &status, 0);
+			EnsembleStats partial;
+			if(!WIFEXITED(status) || WEXITSTATUS(status)!=0 || !partial.deserialize(buffer) || !stats.merge(partial)) {
+				cerr<<"Replicate worker process "<<w<<" failed."<<endl;
+				ok = false;
+			}
+		}
+#else
+		cout<<"Running replicates in parallel is not supported on this platform, running them one by one."<<endl;
+		for(int r=0; r<nReplicates && ok; r++)
+			ok = runReplicate(argMap,r,baseSeed,stem,stats,verbose);
+#endif
+	}
+
+	if(!ok) {
+		cout<<"Error when running the replicates, the ensemble summary was not written."<<endl;
+		return false;
+	}
+	if(!stats.writeSummary(summaryFile)) return false;
+	cout<<endl<<"ensemble summary of "<<nReplicates<<" replicates written to: "<<summaryFile<<endl;
+	return true;
+}
+
+
+
+
+bool runSubsystems(map<string,string> argMap, bool verbose)
+{
+	int nThreads = NFinput::parseAsInt(argMap,"split",(int)thread::hardware_concurrency());
+	if(nThreads<1) nThreads = 1;
+
+	// the whole model keeps the output file, and is only used to write it
+	System *whole = initSystemFromFlags(argMap, verbose);
+	if(whole==NULL) return false;
+	whole->findIndependentSubsystems();
+	int nSubsystems = whole->getNumOfSubsystems();
+
+	const char *unsupported[] = {"b","ss","dump","rxnlog","walk","maxevents","printmoltypes","printrxncounts","memreport","profile"};
+	string flag;
+	for(unsigned int f=0; f<sizeof(unsupported)/sizeof(unsupported[0]); f++)
+		if(argMap.find(unsupported[f])!=argMap.end()) flag = unsupported[f];
+	if(nSubsystems<2 || !flag.empty()) {
+		if(nSubsystems<2) cout<<"The model does not split into independent subsystems, so it is simulated as a whole."<<endl;
+		else cout<<"The -"<<flag<<" flag needs the model in one piece, so it is simulated as a whole."<<endl;
+		bool ok = runFromArgs(whole,argMap,verbose);
+		delete whole;
+		return ok;
+	}
+	whole->prepareForSimulation();
+
+	double eqTime = NFinput::parseAsDouble(argMap,"eq",0);
+	double sTime = NFinput::parseAsDouble(argMap,"sim",10);
+	int oSteps = NFinput::parseAsInt(argMap,"oSteps",10);
+	if(oSteps<1) oSteps = 1;
+	if(nThreads>nSubsystems) nThreads = nSubsystems;
+
+	unsigned long baseSeed = (unsigned long) time(NULL);
+	if(argMap.find("seed")!=argMap.end())
+		baseSeed = abs(NFinput::parseAsInt(argMap,"seed",0));
+
+	// every subsystem reads the whole model, serially as in runAgentCellPopulation(), and drops what isn't its own
+	cout<<"simulating "<<nSubsystems<<" independent subsystems on "<<nThreads<<" threads, subsystem k is seeded with "<<baseSeed<<"+k."<<endl;
+	map<string,string> partArgs = argMap;
+	partArgs.erase("o");
+	partArgs["nooutput"] = "";
+	NFutil::NullBuffer ignored;
+	vector <System *> parts(nSubsystems,(System *)0);
+	vector <NFutil::RandomStream> streams(nSubsystems);
+	bool ok = true;
+	for(int k=0; k<nSubsystems && ok; k++) {
+		streambuf *old = cout.rdbuf();
+		if(!verbose) cout.rdbuf(&ignored);
+		parts[k] = initSystemFromFlags(partArgs, verbose);
+		if(parts[k]!=0) {
+			NFutil::SEED_RANDOM(baseSeed+k);
+			parts[k]->prepareForSimulation();
+			parts[k]->restrictToSubsystem(k);
+			NFutil::SAVE_RANDOM_STREAM(streams[k]);
+		}
+		cout.rdbuf(old);
+		ok = parts[k]!=0 && parts[k]->getNumOfSubsystems()==nSubsystems;
+	}
+
+	if(ok) {
+		streambuf *old = cout.rdbuf();
+		if(!verbose) cout.rdbuf(&ignored);
+		clock_t cpuStart = clock();
+		auto wallStart = chrono::steady_clock::now();
+
+		auto advance = [&](double t, bool equilibrating) {
+			NFutil::runInRanges(nSubsystems, nThreads, 1, [&](int begin, int end, int r) {
+				for(int k=begin; k<end; k++) {
+					NFutil::LOAD_RANDOM_STREAM(streams[k]);
+					if(equilibrating) parts[k]->equilibrate(t);
+					else parts[k]->sampleSubsystem(t);
+					NFutil::SAVE_RANDOM_STREAM(streams[k]);
+				}
+			});
+		};
+
+		if(eqTime>0) advance(eqTime,true);
+		advance(0,false);
+		whole->outputSubsystemCounts(0,parts);
+		for(int step=1; step<=oSteps; step++) {
+			double sampleTime = sTime*(double)step/(double)oSteps;
+			advance(sampleTime,false);
+			whole->outputSubsystemCounts(sampleTime,parts);
+		}
+
+		double wall = chrono::duration <double> (chrono::steady_clock::now()-wallStart).count();
+		cout.rdbuf(old);
+		long long events = 0;
+		for(int k=0; k<nSubsystems; k++) events += parts[k]->getGlobalEventCounter();
+		cout<<"   You just simulated "<<events<<" reactions in "<<nSubsystems<<" subsystems in "<<wall<<"s of wall time"<<endl;
+		cout<<"   ("<<(double)(clock()-cpuStart)/CLOCKS_PER_SEC<<"s of CPU time on all threads)"<<endl;
+	} else {
+		cout<<"Could not set up every subsystem, quitting."<<endl;
+	}
+
+	for(int k=0; k<nSubsystems; k++) delete parts[k];
+	delete whole;
+	return ok;
+}
+
+
+
 
 void printLogo(int indent, string version)
 {
@@ -746,6 +1181,13 @@ void printHelp(string version)
 	cout<<"                    right before you output especially if you don't output"<<endl;
 	cout<<"                    too often.  Use this flag to switch to recomputing at "<<endl;
 	cout<<"                    every output step instead of using On The Fly output."<<endl;
+	cout<<"                    Without it, observables that no function or rate law"<<endl;
+	cout<<"                    uses are already only recomputed at output steps."<<endl;
+	cout<<""<<endl;
+	cout<<"  -obsThreads [int] number of threads that recount observables at output"<<endl;
+	cout<<"                    steps and write the species list of -ss, by default"<<endl;
+	cout<<"                    one per core.  Only large systems are split between"<<endl;
+	cout<<"                    threads."<<endl;
 	cout<<""<<endl;
 	cout<<"  -ogf              output the value of all global functions."<<endl;
 	cout<<""<<endl;
@@ -758,7 +1200,9 @@ void printHelp(string version)
 	cout<<""<<endl;
 	cout<<"  -test             used to specify a given preprogrammed test. Some tests"<<endl;
 	cout<<"                    include \"tlbr\" and \"simple_system\".  Tests do not read"<<endl;
-	cout<<"                    in other command line flags"<<endl;
+	cout<<"                    in other command line flags.  The \"microbench\" test"<<endl;
+	cout<<"                    times the core data structures in isolation (options"<<endl;
+	cout<<"                    -reps, -warmup, -seed and -out for a JSON report)"<<endl;
 	cout<<""<<endl;
 	cout<<"  -seed             used to specify the seed for the random number generator."<<endl;
 	cout<<"                    This allows you to run the same simulation and get the"<<endl;
@@ -801,6 +1245,62 @@ void printHelp(string version)
 	cout<<""<<endl;
  	// cout<<"  -maxcputime       maximum run time for simulation in seconds (default: no limit)."<<endl;
 	// cout<<""<<endl;
+	cout<<"  -profile [file]   report the time spent in each phase of the simulation loop"<<endl;
+	cout<<"                    and in each rule, plus pattern matching and traversal"<<endl;
+	cout<<"                    counts, at the end of the run.  The report is also written"<<endl;
+	cout<<"                    to the file, if one is given.  Requires a build with"<<endl;
+	cout<<"                    NFSIM_PROFILE defined (cmake -DNFSIM_PROFILE=ON)."<<endl;
+	cout<<""<<endl;
+	cout<<"  -perfcounters     also read the hardware counters (cycles, instructions, L1D"<<endl;
+	cout<<"                    and LLC misses, branch misses) in each phase of the profile."<<endl;
+	cout<<"                    Implies -profile.  Needs Linux and permission to use"<<endl;
+	cout<<"                    perf_event_open, otherwise the counters are left out."<<endl;
+	cout<<""<<endl;
+	cout<<"  -memreport [file] print the bytes and object counts used by molecules, their"<<endl;
+	cout<<"                    reaction sets, molecule lists, mapping sets in reactant"<<endl;
+	cout<<"                    lists and trees, complexes, connected reactions and log"<<endl;
+	cout<<"                    buffers, when the system is prepared and at each output"<<endl;
+	cout<<"                    step.  The report is also written to the file (as tab"<<endl;
+	cout<<"                    separated rows, with one row per reactant list), if given."<<endl;
+	cout<<""<<endl;
+	cout<<"  -maxevents [int]  stop the simulation after this many events, even if the"<<endl;
+	cout<<"                    simulation time has not been reached.  Together with -seed,"<<endl;
+	cout<<"                    this gives reproducible runs for performance comparisons."<<endl;
+	cout<<""<<endl;
+	cout<<"  -replicates [int] run the model this many times, and write the mean and the"<<endl;
+	cout<<"                    standard deviation of every output column at every sample"<<endl;
+	cout<<"                    time to a single summary file, [name]_ensemble.gdat."<<endl;
+	cout<<"                    Replicate i is seeded with seed+i."<<endl;
+	cout<<"  -ensemble [file]  the name of the summary file for -replicates."<<endl;
+	cout<<"  -rprocs [int]     run the replicates in this many processes at once."<<endl;
+	cout<<"  -rout             also write the output of each replicate, to files named"<<endl;
+	cout<<"                    [name]_rep[i].gdat."<<endl;
+	cout<<""<<endl;
+	cout<<"  -split [int]      simulate the parts of the model that no rule or observable"<<endl;
+	cout<<"                    connects on separate threads, up to this many at once."<<endl;
+	cout<<"                    Part k is seeded with seed+k and keeps its own copy of"<<endl;
+	cout<<"                    the model in memory."<<endl;
+	cout<<""<<endl;
+	cout<<"  -optimistic [int] run the events of the model on this many threads at once"<<endl;
+	cout<<"                    where they touch different complexes (experimental, only"<<endl;
+	cout<<"                    for elementary rules that don't add or delete molecules)."<<endl;
+	cout<<"  -obatch [int]     the most events -optimistic draws at a time."<<endl;
+	cout<<""<<endl;
+	cout<<"  -subvolumes [int] simulate the model on a grid of well-mixed subvolumes with"<<endl;
+	cout<<"                    this many per side (experimental, for the same models as"<<endl;
+	cout<<"                    -optimistic)."<<endl;
+	cout<<"  -sdim [int]       the number of dimensions of the grid, 2 or 3."<<endl;
+	cout<<"  -hop [double]     the rate at which complexes jump to each neighbouring"<<endl;
+	cout<<"                    subvolume."<<endl;
+	cout<<""<<endl;
+	cout<<"  -nooutput         do not write the observable output (gdat) file."<<endl;
+	cout<<""<<endl;
+	cout<<"  -serve [socket]   keep the model loaded and run commands sent by clients over"<<endl;
+	cout<<"                    a unix domain socket: the RNF commands, plus 'sim [time]"<<endl;
+	cout<<"                    [steps]' and 'observables', which send the observables"<<endl;
+	cout<<"                    back as binary tables, 'quit' and 'shutdown'.  Each client"<<endl;
+	cout<<"                    gets its own copy of the prepared model."<<endl;
+	cout<<""<<endl;
 	cout<<""<<endl;
 }
 
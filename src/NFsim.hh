@@ -46,8 +46,11 @@
 #include  "NFtest/simple_system/simple_system.hh"
 #include  "NFtest/transcription/transcription.hh"
 #include  "NFtest/tlbr/tlbr.hh"
+#include  "NFtest/microbench/microbench.hh"
 #include  "NFtest/agentcell/agentcell.hh"
 
+#include "NFapi/NFserver.hh"
+
 
 
 //! Runs a given System with the specified arguments
@@ -57,6 +60,22 @@
 bool runFromArgs(System *s, map<string,string> argMap, bool verbose);
 
 
+/*!
+  Runs the prepared System with the OptimisticEngine on up to -optimistic
+  threads.  Returns false, without running anything, if the model or one of
+  the flags needs the regular engine.
+*/
+bool runOptimistic(System *s, map<string,string> &argMap, double eqTime, double sTime, int oSteps);
+
+
+/*!
+  Runs the prepared System with the SubvolumeEngine on a grid of -subvolumes
+  per side.  Returns false, without running anything, if the model or one of
+  the flags needs the regular engine.
+*/
+bool runSubvolumes(System *s, map<string,string> &argMap, double eqTime, double sTime, int oSteps);
+
+
 //! Initialize a system from command line flags
 /*!
   @author Michael Sneddon
@@ -64,6 +83,23 @@ bool runFromArgs(System *s, map<string,string> argMap, bool verbose);
 System *initSystemFromFlags(map<string,string> argMap, bool verbose);
 
 
+/*!
+  Runs the -xml model -replicates times, each replicate with its own seed,
+  and writes the mean and standard deviation of every output column at each
+  sample time to a single summary file.
+*/
+bool runReplicates(map<string,string> argMap, bool verbose);
+
+
+/*!
+  Runs the -xml model split into its independent subsystems (see
+  System::findIndependentSubsystems()), each simulated by its own copy of
+  the model on up to -split threads, and writes their observables into one
+  output file.  Models that don't split are simulated as a whole.
+*/
+bool runSubsystems(map<string,string> argMap, bool verbose);
+
+
 
 
 
@@ -2,6 +2,7 @@
 #include <iostream>
 
 #include "agentcell.hh"
+#include "population.hh"
 #include "../../NFcore/NFcore.hh"
 #include "../../NFinput/NFinput.hh"
 #include "cell/cell.hh"
@@ -17,6 +18,11 @@ void runAgentCell(map<string,string> argMap, bool verbose)
 	double actime;
 
 
+	if (argMap.find("population")!=argMap.end()) {
+		runAgentCellPopulation(argMap,verbose);
+		return;
+	}
+
 	cout<<"Running AgentCell Emulator."<<endl;
 	if (argMap.find("xml")!=argMap.end())
 	{
@@ -71,22 +77,7 @@ void runAgentCell(map<string,string> argMap, bool verbose)
 			}
 
 			cout<<"\n\n----- Run Options -----"<<endl;
-			Environment *e;
-			if(argMap.find("constEnvironment")!=argMap.end()) {
-				cout<<"Environment:   "<<"Constant"<<endl;
-				e= new ConstantEnvironment(0);
-			} else if(argMap.find("linearEnvironment")!=argMap.end()) {
-				double slope = pow(10,-8.0);
-				slope = NFinput::parseAsDouble(argMap,"linearEnvironment",slope);
-				double intercept = 0;
-				intercept = NFinput::parseAsDouble(argMap,"zIntercept",intercept);
-				cout<<"Environment:   "<<"Linear Gradient (slope: "<<slope<<", intercept: "<<intercept<<")"<<endl;
-				e = new LinearEnvironment(slope,intercept);
-			} else {
-				double slope = pow(10,-8.0);
-				cout<<"Environment:   "<<"Linear Gradient (default, slope: "<<slope<<", intercept: 0)"<<endl;
-				e = new LinearEnvironment(slope,0);
-			}
+			Environment *e = createAgentCellEnvironment(argMap);
 
 			cout<<"Eq time:       "<<eqTime<<"s"<<endl;
 			cout<<"Sim time:      "<<simTime<<"s"<<endl;
@@ -159,3 +150,25 @@ void runAgentCell(map<string,string> argMap, bool verbose)
 	}
 }
 
+
+
+Environment * createAgentCellEnvironment(map<string,string> &argMap)
+{
+	Environment *e;
+	if(argMap.find("constEnvironment")!=argMap.end()) {
+		cout<<"Environment:   "<<"Constant"<<endl;
+		e= new ConstantEnvironment(0);
+	} else if(argMap.find("linearEnvironment")!=argMap.end()) {
+		double slope = pow(10,-8.0);
+		slope = NFinput::parseAsDouble(argMap,"linearEnvironment",slope);
+		double intercept = 0;
+		intercept = NFinput::parseAsDouble(argMap,"zIntercept",intercept);
+		cout<<"Environment:   "<<"Linear Gradient (slope: "<<slope<<", intercept: "<<intercept<<")"<<endl;
+		e = new LinearEnvironment(slope,intercept);
+	} else {
+		double slope = pow(10,-8.0);
+		cout<<"Environment:   "<<"Linear Gradient (default, slope: "<<slope<<", intercept: 0)"<<endl;
+		e = new LinearEnvironment(slope,0);
+	}
+	return e;
+}
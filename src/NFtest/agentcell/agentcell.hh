@@ -12,7 +12,13 @@
 #include <map>
 
 using namespace std;
+
+class Environment;
+
 void runAgentCell(map<string,string> argMap, bool verbose);
 
+//Creates the environment given by the -constEnvironment or -linearEnvironment flags
+Environment * createAgentCellEnvironment(map<string,string> &argMap);
+
 
 #endif /* AGENTCELL_HH_ */
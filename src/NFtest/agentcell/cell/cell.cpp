@@ -68,10 +68,13 @@ AgentCell::AgentCell(
 
 
 
-	//Set output streams for the cell movement (Now in binary!!! )
+	//Set output streams for the cell movement (Now in binary!!! ), unless
+	//no directory was given and whoever runs the cell records it instead
 	fileName = cellTrajFileName;
-	outputFileStream.open((fileName+".dat").c_str(), ios_base::out | ios_base::binary | ios_base::trunc);
-	if(!outputFileStream.is_open()) {
+	writeOutput = !outputDirectoryPath.empty();
+	quiet = false;
+	if(writeOutput) outputFileStream.open((fileName+".dat").c_str(), ios_base::out | ios_base::binary | ios_base::trunc);
+	if(writeOutput && !outputFileStream.is_open()) {
 		cout<<"could not open stream to output file."<<endl;
 		cout<<(fileName+".dat").c_str()<<endl;
 		exit(1);
@@ -110,6 +113,7 @@ AgentCell::~AgentCell()
 	outputFileStream.close();
 	motorFileStream.close();
 	delete gs;
+	delete [] cheYhistory;
 }
 
 
@@ -177,8 +181,8 @@ void AgentCell::equilibriate(double duration, double dt)
 {
 	int progressStep = round(((duration)/dt)/40);
 	int currentStep = 0;
-	cout<<"start -------------------------------------- end"<<endl;
-	cout<<"      ";
+	if(!quiet) cout<<"start -------------------------------------- end"<<endl;
+	if(!quiet) cout<<"      ";
 
 
 	//boxcarTimeWidth = 0.3;
@@ -186,7 +190,9 @@ void AgentCell::equilibriate(double duration, double dt)
 
 	//since we are equilibrating, we have to reinitialize the
 	//cheYp history.
+	delete [] this->cheYhistory;
 	this->cheYhistory =new double [cheYhistorySize];
+	this->cheYhistorySum = 0;
 	for(int i=0; i<cheYhistorySize; i++) {
 		cheYhistory[i]=(double)this->system->getObservableByName("Yp")->getCount();
 		cheYhistorySum += cheYhistory[i];
@@ -251,12 +257,12 @@ void AgentCell::equilibriate(double duration, double dt)
 		//cout<<"Flagella State: "<< flagellaState<<endl;
 
 		currentStep++;
-		if(currentStep%progressStep==0) {
+		if(!quiet && currentStep%progressStep==0) {
 			cout<<"*"; cout.flush();
 		}
 	}
 
-	cout<<endl;
+	if(!quiet) cout<<endl;
 }
 
 
@@ -265,8 +271,8 @@ double AgentCell::stepTo(double endTime, double dt)
 {
 	int progressStep = round(((endTime - currentTime)/dt)/38);
 	int currentStep = 0;
-	cout<<"start -------------------------------------- end"<<endl;
-	cout<<"      ";
+	if(!quiet) cout<<"start -------------------------------------- end"<<endl;
+	if(!quiet) cout<<"      ";
 
 	int CWrot = 0;
 	int CCWrot = 0;
@@ -275,7 +281,7 @@ double AgentCell::stepTo(double endTime, double dt)
 	while(currentTime<=endTime)
 	{
 		//First we output the current information
-		system->outputAllObservableCounts(currentTime);
+		if(writeOutput) system->outputAllObservableCounts(currentTime);
 		this->outputCellValues();
 
 		//Next we simulate for the time step
@@ -349,11 +355,12 @@ double AgentCell::stepTo(double endTime, double dt)
 		}
 
 		currentStep++;
-		if(currentStep%progressStep==0) {
+		if(!quiet && currentStep%progressStep==0) {
 			cout<<"*"; cout.flush();
 		}
 	}
 
+	if(quiet) return currentTime;
 	cout<<endl;
 	cout<<"Final CW bias: "<<((float)CWrot/((float)CCWrot+(float)CWrot))<<endl;
 	cout<<"Swimming bias: "<<(float)swim/((float)swim+(float)tumble)<<endl;
@@ -370,6 +377,7 @@ void AgentCell::swimToNewPosition(double elapsedTime)
 
 void AgentCell::outputCellHeader()
 {
+	if(!writeOutput) return;
 	//new, binary technique
 	ofstream o((fileName+".hd").c_str());
 	o<<"#\trows\tTIME(s)\tX_POS(um)\tY_POS(um)\tZ_POS(um)\tLigand(M)\tMotor("<<this->CCW<<"=CCW)\tFlagella("<<this->BUNDLED<<"=BUNDLED)\tMeanCheYp";
@@ -381,6 +389,7 @@ void AgentCell::outputCellHeader()
 
 void AgentCell::outputCellValues()
 {
+	if(!writeOutput) return;
 	binaryFileOutputCounter++;
 
 	outputFileStream.write((char *)&currentTime, sizeof(double));
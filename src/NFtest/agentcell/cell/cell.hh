@@ -45,6 +45,9 @@ class AgentCell
 		double stepTo(double endTime, double dt);
 		void equilibriate(double duration, double dt);
 
+		//Turns off the progress bars printed by stepTo and equilibriate
+		void setQuiet(bool quiet) { this->quiet = quiet; };
+
 		//Functions to get current position and direction
 		double getXposition() const { return pos[X]; };
 		double getYposition() const { return pos[Y]; };
@@ -53,6 +56,12 @@ class AgentCell
 		double getYdirection() const { return dir[Y]; };
 		double getZdirection() const { return dir[Z]; };
 
+		double getCurrentTime() const { return currentTime; };
+		double getLigConc() const { return currentLigConc; };
+		double getMeanCheYp() const { return meanCheYp; };
+		int getMotorState() const { return motorState; };
+		int getFlagellaState() const { return flagellaState; };
+
 		//Constants that can be used
 		static const int X = 0;
 		static const int Y = 1;
@@ -158,6 +167,8 @@ class AgentCell
 
 		string fileName;
 		unsigned int binaryFileOutputCounter;
+		bool writeOutput;
+		bool quiet;
 
 		static const int CW = 1;
 		static const int CCW = 0;
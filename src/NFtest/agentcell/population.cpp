@@ -0,0 +1,296 @@
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <cmath>
+
+#include "population.hh"
+#include "agentcell.hh"
+#include "../../NFcore/NFcore.hh"
+#include "../../NFinput/NFinput.hh"
+#include "cell/cell.hh"
+#include "cell/environment.hh"
+
+using namespace NFcore;
+using namespace std;
+
+
+//! A cell of the population with the System and random number stream it owns
+struct PopulationCell
+{
+	System *s;
+	AgentCell *ac;
+	NFutil::RandomStream rng;
+};
+
+
+//! Threads that run a job over every cell and wait until all cells are done
+class CellPool
+{
+	public:
+		CellPool(int nThreads, int nCells);
+		~CellPool();
+
+		//Runs job(c) for every cell c, the calling thread helps out
+		void run(function <void (int)> job);
+
+	protected:
+		void work();
+		void takeCells();
+
+		int nCells;
+		vector <thread> threads;
+
+		mutex m;
+		condition_variable started;
+		condition_variable finished;
+		function <void (int)> job;
+		unsigned long epoch;
+		int running;
+		bool stopping;
+		atomic <int> nextCell;
+};
+
+
+CellPool::CellPool(int nThreads, int nCells)
+{
+	this->nCells = nCells;
+	this->epoch = 0;
+	this->running = 0;
+	this->stopping = false;
+	this->nextCell = nCells;
+	for(int t=1; t<nThreads; t++)
+		threads.push_back(thread(&CellPool::work,this));
+}
+
+CellPool::~CellPool()
+{
+	{
+		lock_guard <mutex> lock(m);
+		stopping = true;
+	}
+	started.notify_all();
+	for(unsigned int t=0; t<threads.size(); t++)
+		threads[t].join();
+}
+
+void CellPool::run(function <void (int)> job)
+{
+	{
+		lock_guard <mutex> lock(m);
+		this->job = job;
+		nextCell = 0;
+		running = threads.size();
+		epoch++;
+	}
+	started.notify_all();
+	takeCells();
+
+	unique_lock <mutex> lock(m);
+	finished.wait(lock, [this]{ return running==0; });
+}
+
+void CellPool::work()
+{
+	unsigned long seen = 0;
+	while(true) {
+		{
+			unique_lock <mutex> lock(m);
+			started.wait(lock, [this,seen]{ return stopping || epoch!=seen; });
+			if(stopping) return;
+			seen = epoch;
+		}
+		takeCells();
+		{
+			lock_guard <mutex> lock(m);
+			running--;
+		}
+		finished.notify_one();
+	}
+}
+
+void CellPool::takeCells()
+{
+	for(int c=nextCell++; c<nCells; c=nextCell++)
+		job(c);
+}
+
+
+
+void runAgentCellPopulation(map<string,string> argMap, bool verbose)
+{
+	cout<<"Running AgentCell population."<<endl;
+	if (argMap.find("xml")==argMap.end() || argMap.find("xml")->second.empty()) {
+		cout<<"The population needs a model, given with the 'xml' flag.  quiting."<<endl;
+		return;
+	}
+	string filename = argMap.find("xml")->second;
+
+	double eqTime = NFinput::parseAsDouble(argMap,"eq",10);
+	double simTime = NFinput::parseAsDouble(argMap,"sim",10);
+	double dt = NFinput::parseAsDouble(argMap,"dt",0.01);
+	double sampleDt = NFinput::parseAsDouble(argMap,"sampleDt",dt);
+	int nCells = NFinput::parseAsInt(argMap,"nCells",1);
+	double motorThresh = NFinput::parseAsInt(argMap,"motorThresh",1800);
+	int nThreads = NFinput::parseAsInt(argMap,"nThreads",(int)thread::hardware_concurrency());
+	if(nThreads<1) nThreads = 1;
+	if(nThreads>nCells) nThreads = nCells;
+	if(nCells<1 || dt<=0) {
+		cout<<"The population needs at least one cell and a positive dt.  quiting."<<endl;
+		return;
+	}
+
+	unsigned long baseSeed = (unsigned long) time(NULL);
+	if(argMap.find("seed")!=argMap.end())
+		baseSeed = abs(NFinput::parseAsInt(argMap,"seed",0));
+
+	string oDir = "";
+	if (argMap.find("oDir")!=argMap.end()) oDir = argMap.find("oDir")->second;
+	if(oDir.empty()) {
+		cout<<"No valid output directory, with flag 'oDir', given."<<endl;
+		cout<<"quiting."<<endl; return;
+	}
+
+	int stepsPerSample = (int)round(sampleDt/dt);
+	if(stepsPerSample<1) stepsPerSample = 1;
+	int nSamples = (int)round(simTime/(stepsPerSample*dt)) + 1;
+
+	cout<<"\n\n----- Run Options -----"<<endl;
+	Environment *e = createAgentCellEnvironment(argMap);
+	cout<<"Eq time:       "<<eqTime<<"s"<<endl;
+	cout<<"Sim time:      "<<simTime<<"s"<<endl;
+	cout<<"dt:            "<<dt<<"s"<<endl;
+	cout<<"Sample dt:     "<<stepsPerSample*dt<<"s"<<endl;
+	cout<<"Motor thresh:  "<<motorThresh<<" CheYp"<<endl;
+	cout<<"Cell Count:    "<<nCells<<endl;
+	cout<<"Threads:       "<<nThreads<<endl;
+	cout<<"Seeds:         "<<baseSeed<<" to "<<baseSeed+nCells-1<<endl;
+	cout<<"Output Dir:    "<<oDir<<endl;
+
+	// see runAgentCell() for where these come from
+	double cellSpeed = 20;
+	double rotDiffusionConstant = 0.0620577;
+
+
+	// There is no way to copy a System, so every cell reads its own from the
+	// file.  This happens here, on one thread, because reading a model is not
+	// safe to run in parallel.
+	cout<<endl<<"Reading "<<nCells<<" copies of the model..."<<endl;
+	clock_t loadStart = clock();
+	NFutil::NullBuffer ignored;
+	vector <PopulationCell> cells(nCells);
+	for(int i=0; i<nCells; i++) {
+		streambuf *old = cout.rdbuf(&ignored);
+		int suggestedTraversalLimit = ReactionClass::NO_LIMIT;
+		System *s = NFinput::initializeFromXML(filename,false,100000,false,suggestedTraversalLimit);
+		if(s!=0) {
+			s->setUniversalTraversalLimit(suggestedTraversalLimit);
+			// the cell's stream starts here, the new cell already draws its direction
+			NFutil::SEED_RANDOM(baseSeed+i);
+			s->prepareForSimulation();
+		}
+		cout.rdbuf(old);
+		if(s==0) {
+			cout<<"Could not read "<<filename<<", quiting."<<endl;
+			for(int k=0; k<i; k++) { delete cells[k].ac; delete cells[k].s; }
+			delete e;
+			return;
+		}
+		if(s->getObservableByName("Yp")==0) {
+			cout<<"\n AgentCell Emulator requires an observable named 'Yp'"<<endl;
+			cout<<" in order to accurately swim the cell.  Yp was not defined"<<endl;
+			cout<<" in this file, so program will now quit."<<endl;
+			delete s;
+			for(int k=0; k<i; k++) { delete cells[k].ac; delete cells[k].s; }
+			delete e;
+			return;
+		}
+		cells[i].s = s;
+		cells[i].ac = new AgentCell(s,e,cellSpeed,rotDiffusionConstant,motorThresh,0,"");
+		cells[i].ac->setQuiet(true);
+		NFutil::SAVE_RANDOM_STREAM(cells[i].rng);
+	}
+	cout<<"done.  Elapsed CPU time: "<<(double)(clock()-loadStart)/CLOCKS_PER_SEC<<"s"<<endl;
+
+
+	// columnar output, one array per column, each holding [sample][cell]
+	const int nColumns = 5;
+	const char *columnNames[nColumns] = {"X_POS(um)","Y_POS(um)","Z_POS(um)","Ligand(M)","MeanCheYp"};
+	vector <double> times(nSamples);
+	vector <vector <double> > columns(nColumns, vector <double> (nSamples*nCells));
+
+	int sample = 0;
+	auto record = [&](int c) {
+		AgentCell *ac = cells[c].ac;
+		size_t k = (size_t)sample*nCells + c;
+		columns[0][k] = ac->getXposition();
+		columns[1][k] = ac->getYposition();
+		columns[2][k] = ac->getZposition();
+		columns[3][k] = ac->getLigConc();
+		columns[4][k] = ac->getMeanCheYp();
+	};
+
+	// NFsim prints a few warnings from inside the simulation loop, which
+	// would only get garbled with many threads at once
+	streambuf *old = cout.rdbuf();
+	if(!verbose) cout.rdbuf(&ignored);
+
+	CellPool pool(nThreads, nCells);
+	auto startTime = chrono::steady_clock::now();
+
+	pool.run([&](int c) {
+		NFutil::LOAD_RANDOM_STREAM(cells[c].rng);
+		cells[c].ac->equilibriate(eqTime,dt);
+		NFutil::SAVE_RANDOM_STREAM(cells[c].rng);
+		record(c);
+	});
+	times[0] = 0;
+
+	for(sample=1; sample<nSamples; sample++) {
+		pool.run([&](int c) {
+			NFutil::LOAD_RANDOM_STREAM(cells[c].rng);
+			// stepTo takes the step that starts at its end time too
+			AgentCell *ac = cells[c].ac;
+			ac->stepTo(ac->getCurrentTime()+(stepsPerSample-0.5)*dt,dt);
+			NFutil::SAVE_RANDOM_STREAM(cells[c].rng);
+			record(c);
+		});
+		times[sample] = cells[0].ac->getCurrentTime();
+	}
+
+	double elapsed = chrono::duration <double> (chrono::steady_clock::now()-startTime).count();
+	cout.rdbuf(old);
+	cout<<"simulated "<<nCells<<" cells in "<<elapsed<<"s of wall time ("
+			<<(double)nCells*(eqTime+simTime)/elapsed<<" cell-seconds per second)."<<endl;
+
+
+	// write the columns out in one go
+	string base = oDir+"/population";
+	ofstream data((base+".dat").c_str(), ios_base::out | ios_base::binary | ios_base::trunc);
+	if(!data.is_open()) {
+		cout<<"could not open stream to output file."<<endl;
+		cout<<base+".dat"<<endl;
+	} else {
+		data.write((char *)&times[0], nSamples*sizeof(double));
+		for(int col=0; col<nColumns; col++)
+			data.write((char *)&columns[col][0], columns[col].size()*sizeof(double));
+		data.close();
+
+		ofstream header((base+".hd").c_str());
+		header<<"#\tcells\tsamples\tTIME(s)";
+		for(int col=0; col<nColumns; col++) header<<"\t"<<columnNames[col];
+		header<<"\n\t"<<nCells<<"\t"<<nSamples<<"\n";
+		header.close();
+		cout<<"wrote "<<base<<".dat"<<endl;
+	}
+
+	for(int i=0; i<nCells; i++) {
+		delete cells[i].ac;
+		delete cells[i].s;
+	}
+	delete e;
+}
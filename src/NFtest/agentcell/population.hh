@@ -0,0 +1,40 @@
+/*
+ * population.hh
+ *
+ *  Runs a whole population of AgentCells at once, each with its own
+ *  copy of the System, on a pool of threads.
+ */
+
+#ifndef AGENTCELL_POPULATION_HH_
+#define AGENTCELL_POPULATION_HH_
+
+#include <string>
+#include <map>
+
+using namespace std;
+
+
+//!  Simulates -nCells cells in one shared environment on -nThreads threads.
+/*!
+	Started with
+
+	       ./NFsim -xml model.xml -agentcell -population -nCells 1000 -nThreads 8 -oDir out
+
+	Every cell gets its own System, read from the same XML file and prepared
+	before the run starts, and its own random number stream seeded with
+	seed+i for cell i.  The cells are equilibrated, then advanced together
+	in epochs of -sampleDt seconds (default: dt).  Within an epoch the cells
+	are independent, so the threads take them in any order; the environment
+	is only read.  At the end of every epoch each cell writes its position,
+	ligand concentration and mean CheYp into preallocated arrays.  Because
+	every cell has its own stream, the results don't depend on the number of
+	threads.
+
+	The arrays are written to oDir/population.dat when the run ends: the
+	sample times, then one block per column holding samples*cells doubles,
+	sample major.  oDir/population.hd names the columns and gives the sizes.
+*/
+void runAgentCellPopulation(map<string,string> argMap, bool verbose);
+
+
+#endif /* AGENTCELL_POPULATION_HH_ */
@@ -0,0 +1,430 @@
+#include "microbench.hh"
+
+#include <chrono>
+#include <iomanip>
+#include <cmath>
+
+
+using namespace NFcore;
+using namespace NFtest_microbench;
+
+
+// Results of the kernels are accumulated here so that the compiler cannot
+// optimize the timed loops away.
+static volatile double sink = 0;
+
+
+// Runs the kernel for the warm-up repetitions, and then times it over the
+// given number of repetitions of opsPerRep operations each.
+template <class Kernel>
+static Result measure(string name, unsigned long opsPerRep, int warmup, int reps, Kernel kernel)
+{
+	for(int w=0; w<warmup; w++) kernel(opsPerRep);
+
+	vector <double> nsPerOp;
+	for(int r=0; r<reps; r++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		kernel(opsPerRep);
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		double ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count();
+		nsPerOp.push_back(ns/(double)opsPerRep);
+	}
+	return summarize(name,opsPerRep,nsPerOp);
+}
+
+
+void NFtest_microbench::run(map<string,string> &argMap)
+{
+	int seed = NFinput::parseAsInt(argMap,"seed",1234);
+	int reps = NFinput::parseAsInt(argMap,"reps",20);
+	int warmup = NFinput::parseAsInt(argMap,"warmup",3);
+	string outFile = "";
+	if(argMap.find("out")!=argMap.end()) outFile = argMap.find("out")->second;
+	if(reps<1) reps=1;
+	if(warmup<0) warmup=0;
+
+	cout<<"Running the micro-benchmarks (seed "<<seed<<", "<<warmup<<" warm-up and "<<reps<<" timed repetitions)"<<endl;
+	NFutil::SEED_RANDOM(seed);
+
+
+	//  1) Build the system: linear chains of P molecules of several lengths, with
+	//     the state of each molecule picked at random, and a set of state change
+	//     rules whose rates span several orders of magnitude.
+	System *s = new System("microbench",true);
+	MoleculeType *molP = createP(s);
+
+	int chainLengths[] = {1, 16, 256, 1024};
+	const int n_lengths = 4;
+	const int moleculesPerLength = 4096;
+	vector < vector <Molecule *> > chains(n_lengths);
+	for(int l=0; l<n_lengths; l++)
+		createChains(molP, chainLengths[l], moleculesPerLength/chainLengths[l], chains[l]);
+
+	int sIndex = molP->getCompIndexFromName("s");
+	vector <Molecule *> allMols;
+	for(int i=0; i<molP->getMoleculeCount(); i++) {
+		Molecule *m = molP->getMolecule(i);
+		if(NFutil::RANDOM_CLOSED()<0.5) m->setComponentState(sIndex,1);
+		allMols.push_back(m);
+	}
+	// visit the molecules in a random (but fixed) order, so the comparisons do
+	// not just walk along each chain in memory order
+	for(unsigned int i=allMols.size()-1; i>0; i--) {
+		unsigned int j = NFutil::RANDOM_INT(0,i+1);
+		Molecule *tmp = allMols[i]; allMols[i] = allMols[j]; allMols[j] = tmp;
+	}
+
+	const int n_rxns = 32;
+	for(int r=0; r<n_rxns; r++) {
+		stringstream name; name<<"phos_"<<r;
+		s->addReaction(createPhosRxn(molP, name.str(), pow(10.0,(double)(r%8)-4.0)));
+	}
+	s->prepareForSimulation();
+
+
+	vector <Result> results;
+
+
+	//  2) TemplateMolecule::compare on patterns of increasing size
+	{
+		TemplateMolecule *tPhos = new TemplateMolecule(molP);
+		tPhos->addComponentConstraint("s","P");
+
+		TemplateMolecule *tFree = new TemplateMolecule(molP);
+		tFree->addEmptyComponent("a");
+		tFree->addEmptyComponent("b");
+
+		TemplateMolecule *tPair1 = new TemplateMolecule(molP);
+		TemplateMolecule *tPair2 = new TemplateMolecule(molP);
+		tPair2->addComponentConstraint("s","P");
+		TemplateMolecule::bind(tPair1,"b","",tPair2,"a","");
+
+		TemplateMolecule *tTri1 = new TemplateMolecule(molP);
+		TemplateMolecule *tTri2 = new TemplateMolecule(molP);
+		TemplateMolecule *tTri3 = new TemplateMolecule(molP);
+		TemplateMolecule::bind(tTri1,"b","",tTri2,"a","");
+		TemplateMolecule::bind(tTri2,"b","",tTri3,"a","");
+
+		string names[] = {"compare P(s~P)", "compare P(a,b)", "compare P(b!1).P(a!1,s~P)", "compare P(b!1).P(a!1,b!2).P(a!2)"};
+		TemplateMolecule *patterns[] = {tPhos, tFree, tPair1, tTri2};
+		for(int p=0; p<4; p++) {
+			TemplateMolecule *tm = patterns[p];
+			unsigned int next = 0;
+			results.push_back(measure(names[p], 100000, warmup, reps, [&](unsigned long n) {
+				for(unsigned long i=0; i<n; i++) {
+					if(tm->compare(allMols[next])) sink = sink + 1;
+					if(++next==allMols.size()) next=0;
+				}
+			}));
+		}
+	}
+
+
+	//  3) Molecule::breadthFirstSearch and Complex::generateCanonicalLabel over chains
+	for(int l=0; l<n_lengths; l++) {
+		vector <Molecule *> &firsts = chains[l];
+		stringstream name; name<<"breadthFirstSearch (size "<<chainLengths[l]<<")";
+		unsigned long ops = max(10, 400000/chainLengths[l]);
+		list <Molecule *> members;
+		unsigned int next = 0;
+		results.push_back(measure(name.str(), ops, warmup, reps, [&](unsigned long n) {
+			for(unsigned long i=0; i<n; i++) {
+				members.clear();
+				Molecule::breadthFirstSearch(members, firsts[next], ReactionClass::NO_LIMIT);
+				sink = sink + members.size();
+				if(++next==firsts.size()) next=0;
+			}
+		}));
+	}
+	for(int l=0; l<n_lengths; l++) {
+		vector <Molecule *> &firsts = chains[l];
+		stringstream name; name<<"generateCanonicalLabel (size "<<chainLengths[l]<<")";
+		unsigned long ops = max(10, 40000/chainLengths[l]);
+		unsigned int next = 0;
+		results.push_back(measure(name.str(), ops, warmup, reps, [&](unsigned long n) {
+			for(unsigned long i=0; i<n; i++) {
+				Complex *c = firsts[next]->getComplex();
+				c->unsetCanonical();
+				sink = sink + c->getCanonicalLabel().size();
+				if(++next==firsts.size()) next=0;
+			}
+		}));
+	}
+
+
+	//  4) ReactantList and ReactantTree, filled up to a typical size first
+	TemplateMolecule *tUnphos = new TemplateMolecule(molP);
+	tUnphos->addComponentConstraint("s","U");
+	vector <TemplateMolecule *> templates; templates.push_back(tUnphos);
+	TransformationSet *ts = new TransformationSet(templates);
+	ts->addStateChangeTransform(tUnphos,"s","P");
+	ts->finalize();
+
+	const unsigned int containerSize = 10000;
+	{
+		ReactantList *rl = new ReactantList(0,ts,16);
+		vector <unsigned int> ids;
+		for(unsigned int i=0; i<containerSize; i++)
+			ids.push_back(rl->pushNextAvailableMappingSet()->getId());
+
+		results.push_back(measure("ReactantList push+remove", 100000, warmup, reps, [&](unsigned long n) {
+			for(unsigned long i=0; i<n; i++) {
+				unsigned int k = NFutil::RANDOM_INT(0,ids.size());
+				rl->removeMappingSet(ids[k]);
+				ids[k] = rl->pushNextAvailableMappingSet()->getId();
+			}
+		}));
+		results.push_back(measure("ReactantList pickRandom", 100000, warmup, reps, [&](unsigned long n) {
+			MappingSet *ms;
+			for(unsigned long i=0; i<n; i++) {
+				rl->pickRandom(ms);
+				sink = sink + ms->getId();
+			}
+		}));
+		delete rl;
+	}
+	{
+		ReactantTree *rt = new ReactantTree(0,ts,16);
+		vector <unsigned int> ids;
+		for(unsigned int i=0; i<containerSize; i++) {
+			MappingSet *ms = rt->pushNextAvailableMappingSet();
+			rt->confirmPush(ms->getId(), 0.5+NFutil::RANDOM_CLOSED());
+			ids.push_back(ms->getId());
+		}
+
+		results.push_back(measure("ReactantTree push+remove", 100000, warmup, reps, [&](unsigned long n) {
+			for(unsigned long i=0; i<n; i++) {
+				unsigned int k = NFutil::RANDOM_INT(0,ids.size());
+				rt->removeMappingSet(ids[k]);
+				MappingSet *ms = rt->pushNextAvailableMappingSet();
+				rt->confirmPush(ms->getId(), 0.5+NFutil::RANDOM_CLOSED());
+				ids[k] = ms->getId();
+			}
+		}));
+		results.push_back(measure("ReactantTree updateValue", 100000, warmup, reps, [&](unsigned long n) {
+			for(unsigned long i=0; i<n; i++)
+				rt->updateValue(ids[NFutil::RANDOM_INT(0,ids.size())], 0.5+NFutil::RANDOM_CLOSED());
+		}));
+		results.push_back(measure("ReactantTree pickReactantFromValue", 100000, warmup, reps, [&](unsigned long n) {
+			MappingSet *ms;
+			for(unsigned long i=0; i<n; i++) {
+				rt->pickReactantFromValue(ms, NFutil::RANDOM(rt->getRateFactorSum()), 1.0);
+				sink = sink + ms->getId();
+			}
+		}));
+		delete rt;
+	}
+
+
+	//  5) MappingSet::clone of a mapped reactant
+	{
+		MappingSet *original = ts->generateBlankMappingSet(0,0);
+		MappingSet *clone = ts->generateBlankMappingSet(0,1);
+		unsigned int k = 0;
+		while(!tUnphos->compare(allMols[k],0,original)) k++;
+
+		results.push_back(measure("MappingSet::clone", 1000000, warmup, reps, [&](unsigned long n) {
+			for(unsigned long i=0; i<n; i++) {
+				MappingSet::clone(original,clone);
+				original->clearClonedMapping();
+			}
+		}));
+		delete original;
+		delete clone;
+	}
+
+
+	//  6) The two reaction selectors, over the rules of the system
+	{
+		vector <ReactionClass *> rxns;
+		for(int r=0; r<s->getNumOfReactions(); r++) rxns.push_back(s->getReaction(r));
+
+		ReactionSelector *selectors[] = { new DirectSelector(rxns), new LogClassSelector(rxns) };
+		string selectorNames[] = { "DirectSelector", "LogClassSelector" };
+		for(int k=0; k<2; k++) {
+			ReactionSelector *sel = selectors[k];
+			results.push_back(measure(selectorNames[k]+" update (up+down)", 100000, warmup, reps, [&](unsigned long n) {
+				for(unsigned long i=0; i<n; i++) {
+					ReactionClass *r = rxns[NFutil::RANDOM_INT(0,rxns.size())];
+					double a = r->get_a();
+					sel->update(r,a,8.0*a);
+					sel->update(r,8.0*a,a);
+				}
+			}));
+			results.push_back(measure(selectorNames[k]+" getNextReactionClass", 100000, warmup, reps, [&](unsigned long n) {
+				ReactionClass *rc;
+				for(unsigned long i=0; i<n; i++) {
+					sel->getNextReactionClass(rc);
+					sink = sink + rc->getRxnId();
+				}
+			}));
+			delete sel;
+		}
+	}
+
+
+	//  7) FuncFactory::Eval on a short and a longer expression
+	{
+		double A=0, Km=50, kcat=2.5;
+		vector <string> varNames; varNames.push_back("A"); varNames.push_back("Km"); varNames.push_back("kcat");
+		vector <double *> varPtrs; varPtrs.push_back(&A); varPtrs.push_back(&Km); varPtrs.push_back(&kcat);
+
+		string names[] = {"FuncFactory::Eval kcat*A/(Km+A)", "FuncFactory::Eval exp/sqrt/pow expression"};
+		mu::Parser *parsers[] = {
+			FuncFactory::create("kcat*A/(Km+A)",varNames,varPtrs),
+			FuncFactory::create("kcat*exp(-A/Km)+sqrt(A)*(A/Km)^2-ln(1+A)",varNames,varPtrs) };
+		for(int p=0; p<2; p++) {
+			mu::Parser *parser = parsers[p];
+			results.push_back(measure(names[p], 1000000, warmup, reps, [&](unsigned long n) {
+				for(unsigned long i=0; i<n; i++) {
+					A = (double)(i%1000);
+					sink = sink + FuncFactory::Eval(parser);
+				}
+			}));
+			delete parser;
+		}
+	}
+
+
+	//  8) Create/delete churn, as in the transcription models where molecules are
+	//     synthesized and degraded all the time: every operation removes a random
+	//     P monomer and creates a new one in its place, with a random state
+	{
+		vector <Molecule *> &monomers = chains[0];
+		results.push_back(measure("create+delete churn (P monomer)", 100000, warmup, reps, [&](unsigned long n) {
+			for(unsigned long i=0; i<n; i++) {
+				unsigned int k = NFutil::RANDOM_INT(0,monomers.size());
+				molP->removeMoleculeFromRunningSystem(monomers[k]);
+				Molecule *m = molP->genDefaultMolecule();
+				if(NFutil::RANDOM_CLOSED()<0.5) m->setComponentState(sIndex,1);
+				molP->addMoleculeToRunningSystem(m);
+				monomers[k] = m;
+			}
+		}));
+	}
+
+
+	report(results, seed, warmup, outFile);
+
+	delete ts;
+	delete s;
+}
+
+
+
+
+MoleculeType * NFtest_microbench::createP(System *s)
+{
+	vector <string> compName;
+	vector <string> defaultCompState;
+	vector < vector <string> > possibleCompStates;
+
+	compName.push_back("a");
+	defaultCompState.push_back("No State");
+	vector <string> possibleAstates;
+	possibleCompStates.push_back(possibleAstates);
+
+	compName.push_back("b");
+	defaultCompState.push_back("No State");
+	vector <string> possibleBstates;
+	possibleCompStates.push_back(possibleBstates);
+
+	compName.push_back("s");
+	defaultCompState.push_back("U");
+	vector <string> possibleSstates;
+	possibleSstates.push_back("U");
+	possibleSstates.push_back("P");
+	possibleCompStates.push_back(possibleSstates);
+
+	return new MoleculeType("P", compName, defaultCompState, possibleCompStates, s);
+}
+
+
+void NFtest_microbench::createChains(MoleculeType *molP, int chainLength, int nChains, vector <Molecule *> &firstMolecules)
+{
+	int aIndex = molP->getCompIndexFromName("a");
+	int bIndex = molP->getCompIndexFromName("b");
+	for(int c=0; c<nChains; c++) {
+		Molecule *first = molP->genDefaultMolecule();
+		Molecule *last = first;
+		for(int i=1; i<chainLength; i++) {
+			Molecule *m = molP->genDefaultMolecule();
+			Molecule::bind(last,bIndex,m,aIndex);
+			last = m;
+		}
+		firstMolecules.push_back(first);
+	}
+}
+
+
+ReactionClass * NFtest_microbench::createPhosRxn(MoleculeType *molP, string name, double rate)
+{
+	TemplateMolecule *pTemp = new TemplateMolecule(molP);
+	pTemp->addComponentConstraint("s","U");
+
+	vector <TemplateMolecule *> templates;
+	templates.push_back( pTemp );
+
+	TransformationSet *ts = new TransformationSet(templates);
+	ts->addStateChangeTransform(pTemp,"s","P");
+	ts->finalize();
+
+	return new BasicRxnClass(name,rate,"",ts,molP->getSystem());
+}
+
+
+Result NFtest_microbench::summarize(string name, unsigned long opsPerRep, vector <double> &nsPerOp)
+{
+	Result res;
+	res.name = name;
+	res.opsPerRep = opsPerRep;
+	res.reps = nsPerOp.size();
+
+	double sum = 0;
+	for(unsigned int i=0; i<nsPerOp.size(); i++) sum += nsPerOp[i];
+	res.meanNs = sum/(double)nsPerOp.size();
+
+	double sumSq = 0;
+	for(unsigned int i=0; i<nsPerOp.size(); i++) sumSq += (nsPerOp[i]-res.meanNs)*(nsPerOp[i]-res.meanNs);
+	res.stddevNs = (nsPerOp.size()>1) ? sqrt(sumSq/(double)(nsPerOp.size()-1)) : 0;
+
+	vector <double> sorted(nsPerOp);
+	sort(sorted.begin(),sorted.end());
+	res.minNs = sorted.front();
+	unsigned int mid = sorted.size()/2;
+	res.medianNs = (sorted.size()%2==1) ? sorted[mid] : 0.5*(sorted[mid-1]+sorted[mid]);
+	return res;
+}
+
+
+void NFtest_microbench::report(vector <Result> &results, int seed, int warmup, string filename)
+{
+	cout<<"\n   "<<left<<setw(44)<<"kernel"<<right<<setw(12)<<"mean ns/op"<<setw(10)<<"stddev"
+		<<setw(12)<<"min"<<setw(12)<<"median"<<endl;
+	for(unsigned int i=0; i<results.size(); i++) {
+		Result &r = results[i];
+		cout<<"   "<<left<<setw(44)<<r.name<<right<<setw(12)<<fixed<<setprecision(1)<<r.meanNs
+			<<setw(10)<<r.stddevNs<<setw(12)<<r.minNs<<setw(12)<<r.medianNs<<endl;
+	}
+	cout.unsetf(ios::fixed);
+	cout<<"   times are nanoseconds per operation over the timed repetitions"<<endl;
+	if(filename.empty()) return;
+
+	ofstream out(filename.c_str());
+	if(!out.is_open()) {
+		cerr<<"Could not open the micro-benchmark output file: "<<filename<<endl;
+		return;
+	}
+	out<<"{\n  \"seed\": "<<seed<<",\n  \"warmup\": "<<warmup<<",\n  \"kernels\": [\n";
+	out<<setprecision(6);
+	for(unsigned int i=0; i<results.size(); i++) {
+		Result &r = results[i];
+		out<<"    {\"name\": \""<<r.name<<"\", \"ops_per_rep\": "<<r.opsPerRep<<", \"reps\": "<<r.reps
+		   <<", \"mean_ns\": "<<r.meanNs<<", \"stddev_ns\": "<<r.stddevNs
+		   <<", \"min_ns\": "<<r.minNs<<", \"median_ns\": "<<r.medianNs<<"}";
+		out<<((i+1<results.size()) ? ",\n" : "\n");
+	}
+	out<<"  ]\n}\n";
+	out.close();
+	cout<<"   results written to: "<<filename<<endl;
+}
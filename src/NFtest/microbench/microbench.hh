@@ -0,0 +1,77 @@
+#ifndef MICROBENCH_HH_
+#define MICROBENCH_HH_
+
+
+
+#include "../../NFcore/NFcore.hh"
+#include "../../NFreactions/NFreactions.hh"
+#include "../../NFreactions/reactions/reaction.hh"
+#include "../../NFfunction/NFfunction.hh"
+#include "../../NFinput/NFinput.hh"
+#include "../../NFutil/NFutil.hh"
+
+
+using namespace NFcore;
+
+
+
+//!  Micro-benchmarks for the core data structures of NFsim.
+/*!
+	This namespace times the kernels that the simulation loop spends most of
+	its time in, each one in isolation: TemplateMolecule::compare on a few
+	representative patterns, Molecule::breadthFirstSearch and
+	Complex::generateCanonicalLabel on chains of a controlled size, push, remove
+	and pick on ReactantList and ReactantTree, the update and select paths of the
+	DirectSelector and the LogClassSelector, MappingSet::clone,
+	FuncFactory::Eval, and the creation and deletion of molecules.
+
+	Every kernel is run against the same hardcoded system built from a fixed
+	random seed.  Each is first run for a number of warm-up repetitions that are
+	not recorded, and then for a number of timed repetitions, and the mean,
+	standard deviation, minimum and median time per operation over those
+	repetitions are reported.  Run it with:
+
+	       ./NFsim -test microbench [-reps 20] [-warmup 3] [-seed 1234] [-out results.json]
+
+	The optional JSON file holds the same numbers so that two builds can be
+	compared after a change to one of the data structures.
+*/
+namespace NFtest_microbench
+{
+
+	//!  Runs all of the micro-benchmarks and prints a summary table.
+	void run(map<string,string> &argMap);
+
+
+	//!  Statistics for one kernel over all of the timed repetitions.
+	struct Result {
+		string name;
+		unsigned long opsPerRep;
+		int reps;
+		double meanNs;
+		double stddevNs;
+		double minNs;
+		double medianNs;
+	};
+
+
+	//!  Creates the molecule type P(a,b,s~U~P) that all of the benchmarks run on.
+	MoleculeType * createP(System *s);
+
+	//!  Populates the system with linear chains P(b!1).P(a!1,b!2)... of the given length.
+	void createChains(MoleculeType *molP, int chainLength, int nChains, vector <Molecule *> &firstMolecules);
+
+	//!  Creates a unimolecular state change rule P(s~U) -> P(s~P) with the given rate.
+	ReactionClass * createPhosRxn(MoleculeType *molP, string name, double rate);
+
+	//!  Computes the summary statistics from the time per operation of each repetition.
+	Result summarize(string name, unsigned long opsPerRep, vector <double> &nsPerOp);
+
+	//!  Prints the table of results, and writes them as JSON if a filename is given.
+	void report(vector <Result> &results, int seed, int warmup, string filename);
+}
+
+
+
+
+#endif /*MICROBENCH_HH_*/
@@ -202,15 +202,18 @@ ReactionClass * NFtest_transcription::createReactionRNAdegrades(MoleculeType *mo
 ReactionClass * NFtest_transcription::createReactionRNAtranscribed(MoleculeType *molRNA, double rate)
 {
 	vector <TemplateMolecule *> templates;
-	vector <TemplateMolecule *> newProduct;
 
-	TemplateMolecule *newRnaTemp = new TemplateMolecule(molRNA);
-	newProduct.push_back(newRnaTemp);
+	//The new species is a single RNA with all of its components in the default
+	//state and no bonds, so the state and bond lists are empty
+	vector <MoleculeType *> newProduct;
+	newProduct.push_back(molRNA);
+	vector < vector <int> > stateInformation(3);
+	vector < vector <int> > bindingSiteInformation(4);
 
 
 
 	TransformationSet *ts = new TransformationSet(templates);
-	SpeciesCreator *sc = new SpeciesCreator(newProduct);
+	SpeciesCreator *sc = new SpeciesCreator(newProduct,stateInformation,bindingSiteInformation);
 	ts->addAddSpecies(sc);
 	ts->finalize();
 
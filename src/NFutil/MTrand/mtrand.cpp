@@ -5,9 +5,19 @@
 // reside in header file because of the risk of multiple declarations
 
 // initialization of static private members
-unsigned long MTRand_int32::state[n] = {0x0UL};
-int MTRand_int32::p = 0;
-bool MTRand_int32::init = false;
+thread_local unsigned long MTRand_int32::state[n] = {0x0UL};
+thread_local int MTRand_int32::p = 0;
+thread_local bool MTRand_int32::init = false;
+
+void MTRand_int32::getState(unsigned long *s, int &pos) {
+  for (int i = 0; i < n; ++i) s[i] = state[i];
+  pos = p;
+}
+
+void MTRand_int32::setState(const unsigned long *s, int pos) {
+  for (int i = 0; i < n; ++i) state[i] = s[i];
+  p = pos;
+}
 
 void MTRand_int32::gen_state() { // generate new state vector
   for (int i = 0; i < (n - m); ++i)
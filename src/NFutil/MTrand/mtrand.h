@@ -58,16 +58,19 @@ public:
   void seed(const unsigned long*, int size); // seed with array
 // overload operator() to make this a generator (functor)
   unsigned long operator()() { return rand_int32(); }
+// copy the state out and back in, so that one thread can take turns on several streams
+  static void getState(unsigned long *s, int &pos);
+  static void setState(const unsigned long *s, int pos);
 // 2007-02-11: made the destructor virtual; thanks "double more" for pointing this out
   virtual ~MTRand_int32() {} // destructor
 protected: // used by derived classes, otherwise not accessible; use the ()-operator
   unsigned long rand_int32(); // generate 32 bit random integer
 private:
   static const int n = 624, m = 397; // compile time constants
-// the variables below are static (no duplicates can exist)
-  static unsigned long state[n]; // state vector array
-  static int p; // position in state array
-  static bool init; // true if init function is called
+// the variables below are static (no duplicates can exist), one copy per thread
+  static thread_local unsigned long state[n]; // state vector array
+  static thread_local int p; // position in state array
+  static thread_local bool init; // true if init function is called
 // private functions used to generate the pseudo random numbers
   unsigned long twiddle(unsigned long, unsigned long); // used by gen_state()
   void gen_state(); // generate new state
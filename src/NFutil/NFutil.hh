@@ -18,6 +18,8 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <functional>
+#include <vector>
 
 
 
@@ -92,6 +94,26 @@ namespace NFutil {
 	double RANDOM_GAUSSIAN();
 
 
+	//!  The full state of a random number stream.
+	struct RandomStream {
+		unsigned long state[624];
+		int position;
+		bool haveNextGaussian;
+		double nextGaussian;
+	};
+
+	//!  Copies the state of the calling thread's random number generator into the stream
+	/*!
+		Every thread has its own generator.  Saving the generator into a stream and
+		loading it back later lets a thread take turns on several independent streams,
+		so that the numbers each stream draws don't depend on which thread runs it.
+	*/
+	void SAVE_RANDOM_STREAM( RandomStream &rs );
+
+	//!  Sets the calling thread's random number generator to the given stream
+	void LOAD_RANDOM_STREAM( const RandomStream &rs );
+
+
 
 	//!  Parses and converts std::string objects to double values.
 	/*!
@@ -129,6 +151,60 @@ namespace NFutil {
 	void trim(string& str);
 
 
+	//!  Splits the indices [0,n) into contiguous ranges and runs job(begin,end,range) on each
+	/*!
+		The ranges run at the same time, at most nThreads of them, and the calling
+		thread takes the first one.  No range is made shorter than minRange, so
+		small jobs stay on the calling thread.  Returns the number of ranges, so
+		that the caller can keep one tally per range and add them up in order
+		once this returns.
+	*/
+	int runInRanges(int n, int nThreads, int minRange, const function <void (int,int,int)> &job);
+
+	//!  The number of ranges runInRanges() would split [0,n) into
+	int countRanges(int n, int nThreads, int minRange);
+
+	//!  Splits the indices [0,n) into disjoint sets that can be joined (a union-find)
+	/*!
+		Every set is named by its smallest index, so the names don't depend on
+		the order in which sets were joined.
+	*/
+	class DisjointSets
+	{
+		public:
+			DisjointSets(int n) : parent(n) { for(int i=0; i<n; i++) parent[i] = i; };
+
+			//!  The name of the set that index i is in
+			int find(int i) {
+				while(parent[i]!=i) i = parent[i] = parent[parent[i]];
+				return i;
+			};
+
+			//!  Joins the sets that indices i and j are in
+			void join(int i, int j) {
+				i = find(i);
+				j = find(j);
+				if(i<j) parent[j] = i;
+				else if(j<i) parent[i] = j;
+			};
+
+		protected:
+			vector <int> parent;
+	};
+
+	//!  Swallows output
+	/*!
+		Unlike a stringstream it keeps no state, so any thread can write to it.
+		Pointing cout at one silences simulations that run on several threads.
+	*/
+	class NullBuffer : public streambuf
+	{
+		protected:
+			int overflow(int c) { return traits_type::not_eof(c); };
+			streamsize xsputn(const char *s, streamsize n) { return n; };
+	};
+
+
 
 
 
@@ -0,0 +1,26 @@
+#include "NFutil.hh"
+
+#include <thread>
+#include <vector>
+
+
+int NFutil::countRanges(int n, int nThreads, int minRange)
+{
+	int nRanges = nThreads;
+	if(minRange>0 && n/minRange < nRanges) nRanges = n/minRange;
+	if(nRanges<1) nRanges = 1;
+	return nRanges;
+}
+
+int NFutil::runInRanges(int n, int nThreads, int minRange, const function <void (int,int,int)> &job)
+{
+	int nRanges = countRanges(n,nThreads,minRange);
+
+	vector <thread> threads;
+	for(int r=1; r<nRanges; r++)
+		threads.push_back(thread(job, (int)((long long)n*r/nRanges), (int)((long long)n*(r+1)/nRanges), r));
+	job(0, (int)((long long)n/nRanges), 0);
+	for(unsigned int t=0; t<threads.size(); t++)
+		threads[t].join();
+	return nRanges;
+}
@@ -28,9 +28,10 @@
 using namespace NFutil;
 
 
-static int initflag=1;
-static bool haveNextGaussian=false;
-static double nextGaussian = 0;
+// every thread has its own generator, seeded on first use
+static thread_local int initflag=1;
+static thread_local bool haveNextGaussian=false;
+static thread_local double nextGaussian = 0;
 
 static MTRand_int32 iRand;
 static MTRand dRand;
@@ -123,6 +124,24 @@ void NFutil::SEED_RANDOM( unsigned long seedInt ){
 }
 
 
+void NFutil::SAVE_RANDOM_STREAM( RandomStream &rs ) {
+	if (initflag) {
+		iRand.seed( (int) time(NULL));
+		initflag=0;
+	}
+	MTRand_int32::getState(rs.state, rs.position);
+	rs.haveNextGaussian = haveNextGaussian;
+	rs.nextGaussian = nextGaussian;
+}
+
+void NFutil::LOAD_RANDOM_STREAM( const RandomStream &rs ) {
+	MTRand_int32::setState(rs.state, rs.position);
+	haveNextGaussian = rs.haveNextGaussian;
+	nextGaussian = rs.nextGaussian;
+	initflag = 0;
+}
+
+
 
 
 
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Checks the experimental engines against the regular simulation loop.
+
+The optimistic engine (-optimistic) samples the same SSA as the regular loop,
+and so does the subvolume engine (-subvolumes) with a single subvolume.  With
+jumps that are fast next to the reactions, a grid of subvolumes is well mixed
+again, too.  Every case below is run with --seeds seeds, once with the regular
+loop and once with the engine, and the means of the observables at the end of
+the run are compared.  An observable fails when the two means are more than
+--zmax standard errors apart.  The optimistic engine must also give the same
+trajectory, to the last digit, on one thread and on four.
+
+The models are test/simple_system (states, binding and unbinding) and
+test/tlbr (symmetric sites and crosslinking into large aggregates).  tlbr,
+with its receptors clustering on a membrane, is also the example model for
+the subvolume engine, e.g.
+
+    NFsim -xml ../tlbr/tlbr.xml -sim 300 -subvolumes 4 -sdim 2 -hop 0.01
+
+Usage:
+    python3 check.py --nfsim ../../build/NFsim
+    python3 check.py --seeds 80 --zmax 3.5
+"""
+
+import argparse
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+# model under test/, simulation time, engine arguments
+CASES = [
+    ('simple_system/simple_system.xml', 2, ['-optimistic', '2']),
+    ('simple_system/simple_system.xml', 2, ['-optimistic', '2', '-cb']),
+    ('simple_system/simple_system.xml', 2, ['-subvolumes', '1']),
+    ('tlbr/tlbr.xml', 300, ['-optimistic', '2']),
+    ('tlbr/tlbr.xml', 300, ['-optimistic', '2', '-cb']),
+    ('tlbr/tlbr.xml', 300, ['-subvolumes', '1']),
+    ('tlbr/tlbr.xml', 300, ['-subvolumes', '2', '-sdim', '2', '-hop', '1']),
+]
+
+
+def default_nfsim():
+    for cand in [os.path.join(HERE, '..', '..', 'build', 'NFsim'),
+                 os.path.join(HERE, '..', '..', 'bin', 'NFsim')]:
+        if os.path.isfile(cand):
+            return os.path.normpath(cand)
+    return 'NFsim'
+
+
+def run(nfsim, model, t_end, seed, args, gdat, steps=1):
+    cmd = [nfsim, '-xml', os.path.join(HERE, '..', model), '-sim', str(t_end),
+           '-oSteps', str(steps), '-seed', str(seed), '-o', gdat] + args
+    p = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    if p.returncode != 0:
+        raise RuntimeError('NFsim failed (status %d): %s\n%s' % (p.returncode, ' '.join(cmd), p.stdout[-2000:]))
+    with open(gdat) as f:
+        lines = [l for l in f.read().split('\n') if l.strip()]
+    return lines[0].split()[2:], [float(x) for x in lines[-1].split()[1:]]
+
+
+def mean_and_var(rows):
+    n = len(rows)
+    means = [sum(col) / n for col in zip(*rows)]
+    var = [sum((x - m) ** 2 for x in col) / (n - 1) for col, m in zip(zip(*rows), means)]
+    return means, var
+
+
+def check_case(nfsim, workdir, model, t_end, args, seeds, zmax):
+    gdat = os.path.join(workdir, 'check.gdat')
+    names = None
+    regular, engine = [], []
+    for seed in range(1, seeds + 1):
+        names, row = run(nfsim, model, t_end, seed, [], gdat)
+        regular.append(row)
+        engine.append(run(nfsim, model, t_end, seed, args, gdat)[1])
+    m1, v1 = mean_and_var(regular)
+    m2, v2 = mean_and_var(engine)
+    failed = []
+    worst = 0.0
+    for name, a, va, b, vb in zip(names, m1, v1, m2, v2):
+        se = math.sqrt((va + vb) / seeds)
+        if se == 0:
+            z = 0.0 if a == b else float('inf')
+        else:
+            z = (b - a) / se
+        worst = max(worst, abs(z))
+        if abs(z) > zmax:
+            failed.append('%s: %.2f against %.2f (z=%.2f)' % (name, b, a, z))
+    return worst, failed
+
+
+def check_threads(nfsim, workdir):
+    outputs = []
+    for threads in ['1', '4']:
+        gdat = os.path.join(workdir, 'threads%s.gdat' % threads)
+        run(nfsim, 'tlbr/tlbr.xml', 300, 7, ['-optimistic', threads, '-cb'], gdat, steps=30)
+        with open(gdat) as f:
+            outputs.append(f.read())
+    return outputs[0] == outputs[1]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--nfsim', default=default_nfsim(), help='path to the NFsim executable')
+    ap.add_argument('--seeds', type=int, default=30, help='runs per case and engine (default 30)')
+    ap.add_argument('--zmax', type=float, default=4.0,
+                    help='standard errors two means may be apart (default 4)')
+    opts = ap.parse_args()
+    nfsim = os.path.abspath(opts.nfsim)
+
+    status = 0
+    with tempfile.TemporaryDirectory() as workdir:
+        for model, t_end, args in CASES:
+            worst, failed = check_case(nfsim, workdir, model, t_end, args, max(2, opts.seeds), opts.zmax)
+            print('%-4s %s %s  (largest |z| %.2f)' % ('FAIL' if failed else 'ok', model, ' '.join(args), worst))
+            for f in failed:
+                print('       ' + f)
+            if failed:
+                status = 1
+        if check_threads(nfsim, workdir):
+            print('ok   tlbr/tlbr.xml -optimistic 1 and 4 give the same trajectory')
+        else:
+            print('FAIL tlbr/tlbr.xml -optimistic 1 and 4 give different trajectories')
+            status = 1
+    return status
+
+
+if __name__ == '__main__':
+    sys.exit(main())